@@ -19,6 +19,15 @@ extern "C"
 #include "scip2hat_base.h"
 #include "scip2hat_cmd.h"
 #include "scip2hat_dbuffer.h"
+#include "scip2hat_reactor.h"
+#include "scip2hat_executor.h"
+#include "scip2hat_decode.h"
+#include "scip2hat_transport.h"
+#include "scip2hat_sim.h"
+#include "scip2hat_clock.h"
+#include "scip2hat_latency.h"
+#include "scip2hat_points.h"
+#include "scip2hat_ring.h"
 
 
 
@@ -17,6 +17,8 @@ extern "C"
 
 
 #include <stdio.h>
+#include <stdint.h>
+#include <time.h>
 #include <termios.h>
 #include <unistd.h>
 #include <pthread.h>
@@ -36,30 +38,79 @@ typedef enum SCIP2_ENCODE_TYPE_E
 
 
 
+/** Type of decoded value in memory */
+typedef enum SCIP2_VALUE_TYPE_E
+{
+    SCIP2_VAL_ULONG = 0, 	//! unsigned long
+    SCIP2_VAL_UINT16, 		//! uint16_t
+    SCIP2_VAL_UINT32 		//! uint32_t
+} S2ValType;
+
+
+
+/** Maximum length par Line */
+#define SCIP2_MAX_LENGTH 128
+
+/** Size of receive ring buffer of port */
+#define SCIP2_RECV_BUFSIZE 4096
+
+
+
+struct SCIP2_TRANSPORT;
+
 /** SCIP2 handle */
-typedef FILE S2Port;
+typedef struct SCIP2_PORT
+{
+    int fd;							//! File descriptor to poll ( -1: not pollable )
+    const struct SCIP2_TRANSPORT *transport;	//! Transport carrying bytes
+    void *ctx;						//! Context of transport
+    int head;						//! Read position in ring buffer
+    int tail;						//! Write position in ring buffer
+    int timeout;					//! Time out of receive [ms] ( -1: wait forever )
+    int wake[2];					//! Wake up pipe ( eventfd on Linux )
+    int checksum;					//! Validate checksum of recived lines
+    FILE *record;					//! Log of recived bytes ( NULL: not recording )
+    struct timespec recorded;		//! Time of last recorded bytes
+    char ring[SCIP2_RECV_BUFSIZE];	//! Receive ring buffer
+} S2Port;
 
 
 
 S2Port *Scip2_Open( const char *acpDevice, const speed_t acBitrate );
 S2Port *Scip2_OpenEthernet( const char *acpAddress, const int acPort );
+S2Port *Scip2_AllocPort( int aFd, const struct SCIP2_TRANSPORT *acpTransport, void *apCtx );
 int Scip2_Close( S2Port * apPort );
 void Scip2_Flush( S2Port * apPort );
 int bitrate2i( const speed_t acBitrate );
 int Scip2_SendTerm( S2Port * apPort );
 int Scip2_RecvTerm( S2Port * apPort );
 int Scip2_Send( S2Port * apPort, const char *apcMes );
+int Scip2_SendNoWait( S2Port * apPort, const char *apcMes );
+int Scip2_RecvEcho( S2Port * apPort, const char *apcMes );
 int Scip2_Recv( S2Port * apPort, char *apMes, int aNMes );
+char *Scip2_RecvLine( S2Port * apPort, int *apLen );
+int Scip2_Wake( S2Port * apPort );
+void Scip2_ClearWake( S2Port * apPort );
+char *Scip2_PollLine( S2Port * apPort, int *apLen );
+int Scip2_Fill( S2Port * apPort );
+int Scip2_Write( S2Port * apPort, const char *apcBuf, int aNBuf );
 int Scip2_ChangeBitrate( S2Port * apPort, const speed_t acBitrate );
 int Scip2_RecvStatus( S2Port * apPort );
 int Scip2_RecvEncodedLine( S2Port * apPort, unsigned long *apBuf, int aNBuf,
 const S2EncType acEnc, unsigned long *apRemains, int *apNRemains );
+int Scip2_RecvEncodedLineAs( S2Port * apPort, void *apBuf, const S2ValType acType, int aNBuf,
+const S2EncType acEnc, unsigned long *apRemains, int *apNRemains );
+int Scip2_DecodeLine( const char *apLine, int aLen, unsigned long *apBuf, int aNBuf,
+const S2EncType acEnc, unsigned long *apRemains, int *apNRemains );
+int Scip2_DecodeLineAs( const char *apLine, int aLen, void *apBuf, const S2ValType acType, int aNBuf,
+const S2EncType acEnc, unsigned long *apRemains, int *apNRemains );
+int Scip2_DecodeLineSum( const char *apLine, int aLen, void *apBuf, const S2ValType acType, int aNBuf,
+const S2EncType acEnc, unsigned long *apRemains, int *apNRemains, int *apNBadSum );
+int Scip2_CheckSum( const char *apLine, int aLen );
+void Scip2_SetChecksum( S2Port * apPort, int aEnable );
 
 
 
-/** Maximum length par Line */
-#define SCIP2_MAX_LENGTH 128
-
 /** define to print out error message */
 //	 #define SCIP2_DEBUG
 //	 #define SCIP2_DEBUG_ALL
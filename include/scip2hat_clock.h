@@ -0,0 +1,97 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_clock.h
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+#ifndef __LIBSCIP2HAT_CLOCK_H__
+#define __LIBSCIP2HAT_CLOCK_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+#include <time.h>
+
+#include "scip2hat.h"
+
+
+
+/** Number of samples of clock model ( one sample par interval ) */
+#define SCIP2_CLOCK_WINDOW 64
+
+/** Interval of samples of clock model [ms of sensor] */
+#define SCIP2_CLOCK_INTERVAL 1000
+
+/** Number of TM1 round trips par synchronization */
+#define SCIP2_CLOCK_NSYNC 8
+
+/** Maximum skew of sensor clock accepted by clock model [ppm] */
+#define SCIP2_CLOCK_MAX_SKEW 1000
+
+
+
+/** Clock model mapping time stamp of sensor to CLOCK_MONOTONIC of host
+ *  ( host = offset + skew * device - bias [ms] ) */
+typedef struct SCIP2_CLOCK
+{
+	/* unwrapping of 24 bits time stamp */
+	int started;
+	unsigned long raw;
+	long long utime;
+
+	/* samples with least delay in each interval ( cand: the one of current interval ) */
+	int nsample;
+	int head;
+	double dev[SCIP2_CLOCK_WINDOW];
+	double host[SCIP2_CLOCK_WINDOW];
+	int ncand;
+	double canddev;
+	double candhost;
+
+	/* fitted model */
+	double skew;
+	double offset;
+
+	/* anchor of TM synchronization ( delay of recived scans is removed as bias ) */
+	int anchored;
+	double anchordev;
+	double anchorhost;
+	double bias;
+
+	/* stamping of scans ( arrival: echo back of scan being recived, syncreq: TM synchronization is requested ) */
+	struct timespec arrival;
+	int syncreq;
+} S2Clock_t;
+
+
+
+struct SCIP2_SCANNED_DATA;
+struct SCIP2_SCANNED_DATA_TRI;
+
+/** user's function */
+void S2Clock_Init( S2Clock_t * aClock );
+int S2Clock_Sync( S2Clock_t * aClock, S2Port * apPort );
+void S2Clock_ToHost( S2Clock_t * aClock, long long aDevice, struct timespec *apHost );
+double S2Clock_GetSkew( S2Clock_t * aClock );
+void S2Sdd_SyncClock( struct SCIP2_SCANNED_DATA_TRI *aData );
+
+
+
+/** program function */
+long long S2Clock_Unwrap( S2Clock_t * aClock, unsigned long aRaw );
+void S2Clock_Update( S2Clock_t * aClock, long long aDevice, const struct timespec *acpArrival );
+void S2Sdd_Stamp( struct SCIP2_SCANNED_DATA_TRI *aData, struct SCIP2_SCANNED_DATA *aScan );
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __LIBSCIP2HAT_CLOCK_H__ */
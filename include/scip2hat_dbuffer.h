@@ -17,6 +17,31 @@ extern "C"
 
 
 #include "scip2hat.h"
+#include "scip2hat_clock.h"
+#include "scip2hat_latency.h"
+#include "scip2hat_points.h"
+#include "scip2hat_ring.h"
+
+
+
+/** Storage mode of scanned data */
+#define SCIP2_STORE_ULONG   0x00		//! unsigned long par step
+#define SCIP2_STORE_COMPACT 0x01		//! uint16_t / uint32_t par step chosen from encode type
+#define SCIP2_STORE_PLANAR  0x02		//! separate range and intensity planes of ME / NE / GE
+
+
+
+/** Maximum number of scan buffers in pool */
+#define SCIP2_SDD_MAX_BUF 16
+
+/** Flag of middle buffer index which is not picked up yet ( lock free mode ) */
+#define SCIP2_SDD_DIRTY 0x100
+
+/** Maximum number of GS requests queued for the worker ( and in flight ) */
+#define SCIP2_GS_QUEUE 8
+
+/** Interval of retrying to restart broken continuous scanning [ms] */
+#define SCIP2_RECOVER_INTERVAL 100
 
 
 
@@ -36,17 +61,99 @@ typedef struct SCIP2_SCANNED_DATA
 	S2Port *port;
 	unsigned long *data;
 	S2EncType enc;
+	int ref;
+	unsigned long seq;
+	int gen;
+
+	/* decoded values ( data, data16 or data32 points them according to type ) */
+	S2ValType type;
+	void *values;
+	uint16_t *data16;
+	uint32_t *data32;
+
+	/* planar storage ( data / data32 is range plane of nstep values ) */
+	int planar;
+	int nstep;
+	unsigned long *intensity;
+	uint32_t *intensity32;
+
+	/* number of lines with bad checksum ( counted if checksum of port is enabled ) */
+	int nbadsum;
+
+	/* time on host ( utime: unwrapped time stamp [ms], stamp: CLOCK_MONOTONIC by clock model ) */
+	long long utime;
+	struct timespec stamp;
+
+	/* CLOCK_MONOTONIC on stages of reciving ( zero if the stage is not reached ) */
+	struct timespec techo;
+	struct timespec tdecode;
+	struct timespec tpublish;
+	struct timespec tcallback;
+
+	/* time of each step from time stamp [us] ( NULL unless enabled by S2Sdd_setStepTime ) */
+	int32_t *steptime;
+	double stepfirst;
+	double steppitch;
+
+	/* Cartesian points of steps [mm] ( NULL unless enabled by S2Sdd_setPoints ) */
+	float *x;
+	float *y;
+
+	/* validity mask of steps and counts of invalid steps par S2RangeClass
+	   ( NULL unless enabled by S2Sdd_setValidity ) */
+	uint64_t *valid;
+	int nvalid;
+	int ninvalid[SCIP2_RANGE_NCLASS];
 } S2Scan_t;
 
 
 
+/** Get decoded value of the step in any storage mode */
+#define S2Scan_Value( s, i ) \
+	( ( s )->type == SCIP2_VAL_UINT16 ? ( unsigned long )( s )->data16[i] : \
+	  ( s )->type == SCIP2_VAL_UINT32 ? ( unsigned long )( s )->data32[i] : ( s )->data[i] )
+
+/** Check whether the step is valid ( validity mask must be enabled ) */
+#define S2Scan_IsValid( s, i ) \
+	( ( int )( ( ( s )->valid[( i ) >> 6] >> ( ( i ) & 63 ) ) & 1 ) )
+
+/** Get intensity of the step in planar storage */
+#define S2Scan_Intensity( s, i ) \
+	( ( s )->type == SCIP2_VAL_UINT32 ? ( unsigned long )( s )->intensity32[i] : ( s )->intensity[i] )
+
+
+
+/** State of line parser for continuous scanning */
+typedef enum SCIP2_RECV_STATE_E
+{
+    SCIP2_RECV_ECHO = 0, 	//! waiting echo back
+    SCIP2_RECV_STATUS, 		//! waiting status
+    SCIP2_RECV_TIME, 		//! waiting time stamp
+    SCIP2_RECV_DATA, 		//! reciving encoded data
+    SCIP2_RECV_RESYNC 		//! skipping lines until echo back
+} S2RecvState;
+
+
+
+/** Parameters of GS request */
+typedef struct SCIP2_GS_REQUEST
+{
+	S2Port *port;
+	int start;
+	int end;
+	int group;
+	S2EncType enc;
+} S2GSReq_t;
+
+
+
 /** Multi buffer structure for scanned data */
 typedef struct SCIP2_SCANNED_DATA_TRI
 {
 	S2Scan_t *pri;
 	S2Scan_t *sec;
 	S2Scan_t *thr;
-	S2Scan_t buf[3];
+	S2Scan_t buf[SCIP2_SDD_MAX_BUF];
 	int update;
 	pthread_mutex_t mutexr;
 	pthread_mutex_t mutexw;
@@ -54,6 +161,99 @@ typedef struct SCIP2_SCANNED_DATA_TRI
 	int nbuf;
 	int ( *callback ) ( S2Scan_t *, void * );
 	void *userdata;
+
+	/* line parser of continuous scanning */
+	S2RecvState state;
+	char mes[SCIP2_MAX_LENGTH];
+	int meslen;
+	S2EncType decenc;
+	int multi;
+	int remnum;
+	unsigned long value;
+	int nrem;
+	int nvalue;
+
+	/* storage mode of scanned data ( SCIP2_STORE_* ) */
+	int storage;
+
+	/* lock free triple buffer ( index of sec in buf with SCIP2_SDD_DIRTY ) */
+	int lockfree;
+	int lfactive;
+	int middle;
+
+	/* size of buffers reserved for scanning ( gen of buffers fitting it is rgen ) */
+	int rsize;
+	S2ValType rtype;
+	int rplanar;
+	int rsteptime;
+	int rpoints;
+	int rvalid;
+	int rgen;
+	int nstale;
+	S2Scan_t *held;
+
+	/* notification of new scan ( notify[0] is readable after swap ) */
+	pthread_mutex_t mutexn;
+	pthread_cond_t condn;
+	int nwait;
+	int notify[2];
+
+	/* persistent worker of GS ( requests are counted, gsdepth of them in flight ) */
+	int gsworker;
+	int gsactive;
+	int gsquit;
+	int gsreq;
+	int gsdone;
+	int gsdepth;
+	S2GSReq_t gsq[SCIP2_GS_QUEUE];
+	pthread_cond_t condg;
+
+	/* event loop servicing this buffer ( NULL: own thread ) */
+	struct SCIP2_REACTOR *reactor;
+	int active;
+
+	/* pool of scan buffers ( trio: bits of pri, sec and thr in buf ) */
+	int npool;
+	int trio;
+	int ndrop;
+
+	/* worker pool running callback ( NULL: run by reciver ) */
+	struct SCIP2_EXECUTOR *executor;
+	int njob;
+	int jobbusy;
+	int cbstop;
+
+	/* broadcast ring of latest scans followed by S2Reader_t */
+	S2Ring_t ring;
+
+	/* cooperative stop of reciver thread ( joining: thread is joined, not detached ) */
+	S2Port *port;
+	int stopreq;
+	int joining;
+
+	/* automatic recovery of continuous scanning ( cmd: command to re-issue ) */
+	char cmd[SCIP2_MAX_LENGTH];
+	int recover;
+	int nreconnect;
+	int down;
+	struct timespec lost;
+	long outage;
+
+	/* resynchronization on broken scan ( nskip of nskipmax lines skipped ) */
+	int resync;
+	int nskip;
+	int nskipmax;
+	long ndiscard;
+	int nbadframe;
+
+	/* clock model of sensor stamping scans */
+	S2Clock_t clock;
+
+	/* latency histograms of stages of reciving ( S2LatStage ) */
+	S2Hist_t latency[SCIP2_LAT_NSTAGE];
+
+	/* time of steps, validity mask and Cartesian points made by reciver */
+	S2Conv_t conv;
 } S2Sdd_t;
 
 
@@ -63,17 +263,46 @@ void S2Sdd_Init( S2Sdd_t * aData );
 void S2Sdd_Dest( S2Sdd_t * aData );
 void S2Sdd_setCallback( S2Sdd_t * aData, 
 	int ( *aCallback ) ( S2Scan_t *, void * ), void *aUserdata );
+void S2Sdd_setReactor( S2Sdd_t * aData, struct SCIP2_REACTOR *aReactor );
+void S2Sdd_setExecutor( S2Sdd_t * aData, struct SCIP2_EXECUTOR *aExecutor );
+void S2Sdd_setPool( S2Sdd_t * aData, int aNBuf );
+int S2Sdd_GetDropped( S2Sdd_t * aData );
+void S2Sdd_setRecover( S2Sdd_t * aData, int aEnable );
+int S2Sdd_GetReconnect( S2Sdd_t * aData );
+long S2Sdd_GetOutage( S2Sdd_t * aData );
+void S2Sdd_setResync( S2Sdd_t * aData, int aEnable );
+long S2Sdd_GetDiscardedBytes( S2Sdd_t * aData );
+int S2Sdd_GetDiscardedFrames( S2Sdd_t * aData );
+void S2Sdd_setStorage( S2Sdd_t * aData, int aStorage );
+void S2Sdd_setLockFree( S2Sdd_t * aData, int aEnable );
+void S2Sdd_setGSWorker( S2Sdd_t * aData, int aEnable );
+void S2Sdd_setGSPipeline( S2Sdd_t * aData, int aDepth );
+int S2Sdd_Reserve( S2Sdd_t * aData, int aNStep, const S2EncType acEnc );
 int S2Sdd_IsError( S2Sdd_t * aData );
+int S2Sdd_Wait( S2Sdd_t * aData, int aTimeout );
+int S2Sdd_GetEventFd( S2Sdd_t * aData );
+void S2Sdd_ClearEvent( S2Sdd_t * aData );
 
 void S2Sdd_End( S2Sdd_t * aData );
 int S2Sdd_Begin( S2Sdd_t * aData, S2Scan_t ** aScan );
+int S2Sdd_Acquire( S2Sdd_t * aData, S2Scan_t ** aScan );
+void S2Sdd_Release( S2Sdd_t * aData, S2Scan_t * aScan );
 
 
 
 /** program function */
 void *S2Sdd_RecvData( void *aArg );
+void *S2Sdd_RecvDataWorker( void *aArg );
 void *S2Sdd_RecvDataCont( void *aArg );
+int S2Sdd_InitCont( S2Sdd_t * aData );
+int S2Sdd_ParseCont( S2Sdd_t * aData, char *apLine, int aLen );
+int S2Sdd_StartThread( S2Sdd_t * aData, S2Port * apPort, void *( *aFunc ) ( void * ) );
+void S2Sdd_JoinThread( S2Sdd_t * aData );
 void S2Sdd_StopThread( S2Sdd_t * aData );
+void S2Sdd_SetupSwap( S2Sdd_t * aData, int aLockFree );
+void S2Sdd_Notify( S2Sdd_t * aData );
+int S2Sdd_LoadError( S2Sdd_t * aData );
+int S2Sdd_WaitReady( S2Sdd_t * aData, S2Reader_t * aReader, int aTimeout );
 
 
 
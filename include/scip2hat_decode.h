@@ -0,0 +1,44 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_decode.h
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+#ifndef __LIBSCIP2HAT_DECODE_H__
+#define __LIBSCIP2HAT_DECODE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+#include "scip2hat.h"
+
+
+
+/** SIMD instruction set used by decoder */
+typedef enum SCIP2_SIMD_E
+{
+    SCIP2_SIMD_NONE = 0, 	//! scalar
+    SCIP2_SIMD_SSE2, 		//! SSE2 ( SSSE3 for 3 bytes encoding )
+    SCIP2_SIMD_AVX2 		//! AVX2
+} S2Simd;
+
+
+
+S2Simd Scip2_SetSimd( const S2Simd acSimd );
+S2Simd Scip2_GetSimd( void );
+int Scip2_ValSize( const S2ValType acType );
+int Scip2_DecodeBlock( const char *apSrc, int aNValue, void *apBuf, const S2ValType acType, const S2EncType acEnc );
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __LIBSCIP2HAT_DECODE_H__ */
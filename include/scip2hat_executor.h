@@ -0,0 +1,73 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_executor.h
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+#ifndef __LIBSCIP2HAT_EXECUTOR_H__
+#define __LIBSCIP2HAT_EXECUTOR_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+#include <pthread.h>
+
+#include "scip2hat.h"
+
+
+
+/** Maximum number of worker threads */
+#define SCIP2_EXECUTOR_MAX_THREAD 16
+
+/** Maximum number of scans waiting for callback */
+#define SCIP2_EXECUTOR_QUEUE 64
+
+
+
+/** Scan waiting for callback */
+typedef struct SCIP2_EXECUTOR_JOB
+{
+	S2Sdd_t *sdd;
+	S2Scan_t *scan;
+} S2Job_t;
+
+
+
+/** Worker pool running callbacks of many sensors */
+typedef struct SCIP2_EXECUTOR
+{
+	int nthread;
+	int quit;
+	int njob;
+	S2Job_t job[SCIP2_EXECUTOR_QUEUE];
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	pthread_cond_t condd;
+	pthread_t thread[SCIP2_EXECUTOR_MAX_THREAD];
+} S2Executor_t;
+
+
+
+/** user's function */
+int S2Executor_Init( S2Executor_t * aExecutor, int aNThread );
+void S2Executor_Dest( S2Executor_t * aExecutor );
+
+
+
+/** program function */
+int S2Executor_Post( S2Executor_t * aExecutor, S2Sdd_t * aData, S2Scan_t * aScan );
+void S2Executor_Wait( S2Executor_t * aExecutor, S2Sdd_t * aData );
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __LIBSCIP2HAT_EXECUTOR_H__ */
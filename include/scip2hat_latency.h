@@ -0,0 +1,87 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_latency.h
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+#ifndef __LIBSCIP2HAT_LATENCY_H__
+#define __LIBSCIP2HAT_LATENCY_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+#include <time.h>
+
+
+
+/** Number of bins par octave of latency histogram ( error of percentile is less than 1/8 ) */
+#define SCIP2_LAT_SUB 8
+
+/** Number of bins of latency histogram ( 1 us to about 1 min ) */
+#define SCIP2_LAT_NBIN ( SCIP2_LAT_SUB * 24 )
+
+
+
+/** Stage of reciving scan measured by latency histogram */
+typedef enum SCIP2_LAT_STAGE_E
+{
+    SCIP2_LAT_TRANSFER = 0, 	//! echo back arrived to last data line decoded
+    SCIP2_LAT_PUBLISH, 			//! last data line decoded to scan published ( includes conversion to points )
+    SCIP2_LAT_CALLBACK, 		//! published ( decoded if callback runs in reciver ) to callback started
+    SCIP2_LAT_TOTAL, 			//! echo back arrived to callback started ( published if no callback )
+    SCIP2_LAT_NSTAGE
+} S2LatStage;
+
+
+
+/** Histogram of latency [us] in bins growing by octave */
+typedef struct SCIP2_LATENCY_HIST
+{
+	unsigned long count[SCIP2_LAT_NBIN];
+	long max;
+} S2Hist_t;
+
+
+
+/** Summary of latency histogram */
+typedef struct SCIP2_LATENCY_STAT
+{
+	unsigned long count;		//! Number of scans
+	long p50;					//! Median [us]
+	long p99;					//! 99th percentile [us]
+	long max;					//! Maximum [us]
+} S2LatStat_t;
+
+
+
+struct SCIP2_SCANNED_DATA;
+struct SCIP2_SCANNED_DATA_TRI;
+
+/** user's function */
+void S2Hist_Init( S2Hist_t * aHist );
+long S2Hist_Percentile( S2Hist_t * aHist, double aRatio );
+void S2Hist_GetStat( S2Hist_t * aHist, S2LatStat_t * apStat );
+int S2Sdd_GetLatency( struct SCIP2_SCANNED_DATA_TRI *aData, S2LatStage aStage, S2LatStat_t * apStat );
+void S2Sdd_ResetLatency( struct SCIP2_SCANNED_DATA_TRI *aData );
+
+
+
+/** program function */
+void S2Hist_Add( S2Hist_t * aHist, const struct timespec *acpFrom, const struct timespec *acpTo );
+void S2Sdd_MarkDecode( struct SCIP2_SCANNED_DATA_TRI *aData, struct SCIP2_SCANNED_DATA *aScan );
+void S2Sdd_CountPublish( struct SCIP2_SCANNED_DATA_TRI *aData, struct SCIP2_SCANNED_DATA *aScan );
+void S2Sdd_MarkCallback( struct SCIP2_SCANNED_DATA_TRI *aData, struct SCIP2_SCANNED_DATA *aScan );
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __LIBSCIP2HAT_LATENCY_H__ */
@@ -0,0 +1,122 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_points.h
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+#ifndef __LIBSCIP2HAT_POINTS_H__
+#define __LIBSCIP2HAT_POINTS_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+#include <stdint.h>
+
+#include "scip2hat.h"
+
+
+
+/** Class of invalid range */
+typedef enum SCIP2_RANGE_CLASS_E
+{
+    SCIP2_RANGE_ZERO = 0, 		//! 0 below dist_min ( no echo on most models )
+    SCIP2_RANGE_CODE, 			//! other error code of sensor below dist_min
+    SCIP2_RANGE_FAR, 			//! beyond dist_max
+    SCIP2_RANGE_NCLASS
+} S2RangeClass;
+
+
+
+/** Number of 64 bits words of validity mask of steps */
+#define SCIP2_MASK_WORDS( n ) ( ( ( n ) + 63 ) / 64 )
+
+
+
+/** Mounting pose of sensor on the vehicle */
+typedef struct SCIP2_POSE
+{
+	double x;					//! Position [mm]
+	double y;					//! Position [mm]
+	double yaw;					//! Direction of step_front from x axis [rad]
+} S2Pose_t;
+
+
+
+/** Table converting range of steps to Cartesian points */
+typedef struct SCIP2_TRIG
+{
+	/* parameters of sensor ( resolution is 0 until set up ) and mounting pose */
+	int resolution;
+	int front;
+	float dmin;
+	S2Pose_t pose;
+
+	/* direction of steps rotated by pose ( built for start and group of scan ) */
+	int start;
+	int group;
+	int nstep;
+	float *cos;
+	float *sin;
+} S2Trig_t;
+
+
+
+/** Conversion of recived scans ( time of steps, validity mask and Cartesian points ) */
+typedef struct SCIP2_CONVERSION
+{
+	/* time of step from rotation of sensor ( steppitch: [us] par step, 0: disabled ) */
+	double steppitch;
+	int stepfront;
+
+	/* conversion to Cartesian points ( points: enabled ) */
+	S2Trig_t trig;
+	int points;
+
+	/* validity of range ( validity: enabled ) */
+	int validity;
+	unsigned long vmin;
+	unsigned long vmax;
+} S2Conv_t;
+
+
+
+struct SCIP2_SENSOR_PARAM;
+struct SCIP2_SCANNED_DATA;
+struct SCIP2_SCANNED_DATA_TRI;
+
+/** user's function */
+void S2Trig_Init( S2Trig_t * aTrig );
+void S2Trig_Dest( S2Trig_t * aTrig );
+int S2Trig_Setup( S2Trig_t * aTrig, const struct SCIP2_SENSOR_PARAM *acpParam, const S2Pose_t * acpPose );
+int S2Trig_Build( S2Trig_t * aTrig, int aStart, int aGroup, int aNStep );
+void S2Trig_Convert( const S2Trig_t * acpTrig, const void *acpRange, const S2ValType acType, int aStride,
+                     int aNStep, float *apX, float *apY );
+int S2Range_Validate( const void *acpRange, const S2ValType acType, int aStride, int aNStep,
+                      unsigned long aMin, unsigned long aMax, uint64_t * apMask, int *apCount );
+int S2Sdd_setStepTime( struct SCIP2_SCANNED_DATA_TRI *aData, const struct SCIP2_SENSOR_PARAM *acpParam );
+int S2Sdd_setPoints( struct SCIP2_SCANNED_DATA_TRI *aData, const struct SCIP2_SENSOR_PARAM *acpParam,
+                     const S2Pose_t * acpPose );
+int S2Sdd_setValidity( struct SCIP2_SCANNED_DATA_TRI *aData, const struct SCIP2_SENSOR_PARAM *acpParam );
+
+
+
+/** program function */
+void S2Conv_Init( S2Conv_t * aConv );
+void S2Conv_Dest( S2Conv_t * aConv );
+void S2Scan_StepTime( struct SCIP2_SCANNED_DATA *aScan, int aFrom, int aTo );
+void S2Sdd_StampSteps( struct SCIP2_SCANNED_DATA_TRI *aData, struct SCIP2_SCANNED_DATA *aScan );
+void S2Sdd_ToPoints( struct SCIP2_SCANNED_DATA_TRI *aData, struct SCIP2_SCANNED_DATA *aScan );
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __LIBSCIP2HAT_POINTS_H__ */
@@ -0,0 +1,63 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_reactor.h
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+#ifndef __LIBSCIP2HAT_REACTOR_H__
+#define __LIBSCIP2HAT_REACTOR_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+#include <pthread.h>
+
+#include "scip2hat.h"
+
+
+
+/** Maximum number of events handled at once */
+#define SCIP2_REACTOR_EVENTS 16
+
+/** Maximum number of sensors serviced by one event loop */
+#define SCIP2_REACTOR_MAX_SENSOR 64
+
+
+
+/** Event loop servicing continuous scanning of many sensors */
+typedef struct SCIP2_REACTOR
+{
+	int epfd;
+	int wake[2];
+	int generation;
+	int nsdd;
+	S2Sdd_t *sdd[SCIP2_REACTOR_MAX_SENSOR];
+	pthread_mutex_t mutex;
+	pthread_t thread;
+} S2Reactor_t;
+
+
+
+/** user's function */
+int S2Reactor_Init( S2Reactor_t * aReactor );
+void S2Reactor_Dest( S2Reactor_t * aReactor );
+
+
+
+/** program function */
+int S2Reactor_Add( S2Reactor_t * aReactor, S2Sdd_t * aData );
+void S2Reactor_Remove( S2Reactor_t * aReactor, S2Sdd_t * aData );
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __LIBSCIP2HAT_REACTOR_H__ */
@@ -0,0 +1,70 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_ring.h
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+#ifndef __LIBSCIP2HAT_RING_H__
+#define __LIBSCIP2HAT_RING_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+#include <pthread.h>
+
+
+
+/** Maximum number of scans in broadcast ring ( SCIP2_SDD_MAX_BUF - 3 ) */
+#define SCIP2_RING_MAX 13
+
+
+
+/** Broadcast ring of latest scans ( scan of sequence number n is scan[n % nring] ) */
+typedef struct SCIP2_RING
+{
+	unsigned long seq;
+	int nring;
+	struct SCIP2_SCANNED_DATA *scan[SCIP2_RING_MAX];
+	pthread_mutex_t mutex;
+} S2Ring_t;
+
+
+
+/** Reader following broadcast ring at its own pace */
+typedef struct SCIP2_READER
+{
+	struct SCIP2_SCANNED_DATA_TRI *sdd;
+	unsigned long seq;
+	unsigned long skipped;
+} S2Reader_t;
+
+
+
+/** user's function */
+void S2Sdd_setRing( struct SCIP2_SCANNED_DATA_TRI *aData, int aNRing );
+void S2Reader_Init( S2Reader_t * aReader, struct SCIP2_SCANNED_DATA_TRI *aData );
+int S2Reader_Next( S2Reader_t * aReader, struct SCIP2_SCANNED_DATA **aScan );
+void S2Reader_Release( S2Reader_t * aReader, struct SCIP2_SCANNED_DATA *aScan );
+int S2Reader_Wait( S2Reader_t * aReader, int aTimeout );
+
+
+
+/** program function */
+void S2Ring_Init( S2Ring_t * aRing );
+void S2Ring_Dest( S2Ring_t * aRing );
+void S2Ring_Flush( S2Ring_t * aRing );
+void S2Ring_Put( S2Ring_t * aRing, struct SCIP2_SCANNED_DATA *aScan );
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __LIBSCIP2HAT_RING_H__ */
@@ -0,0 +1,125 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_sim.h
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+#ifndef __LIBSCIP2HAT_SIM_H__
+#define __LIBSCIP2HAT_SIM_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+#include <time.h>
+#include <pthread.h>
+
+#include "scip2hat.h"
+
+
+
+/** Maximum number of GS commands waiting for next scan */
+#define SCIP2_SIM_QUEUE 16
+
+/** Size of command buffer of simulator */
+#define SCIP2_SIM_INSIZE ( SCIP2_MAX_LENGTH * 4 )
+
+
+
+/** Synthetic range pattern */
+typedef enum SCIP2_SIM_PATTERN_E
+{
+    SCIP2_SIM_FLAT = 0, 	//! Constant range
+    SCIP2_SIM_RAMP, 		//! Range growing with step, moving with scan
+    SCIP2_SIM_WAVE 			//! Triangle wave moving with scan
+} S2SimPattern;
+
+
+
+/** Model of simulated sensor */
+typedef struct SCIP2_SIM_MODEL
+{
+	S2Param_t param;			//! Replied to PP ( revolution gives scan rate )
+	S2SimPattern pattern;		//! Range pattern
+	int range;					//! Base range of pattern [mm]
+	int noise;					//! Corrupt one of noise data lines on average ( 0: none )
+	int glitch;					//! Break echo back of one of glitch frames on average ( 0: none )
+	unsigned long time_offset;	//! Time stamp at start ( wraps around at 24 bits )
+	unsigned int seed;			//! Seed of noise
+} S2SimModel_t;
+
+
+
+/** Simulated sensor */
+typedef struct SCIP2_SIMULATOR
+{
+	S2SimModel_t model;
+	char name[SCIP2_MAX_LENGTH];
+	int port;
+	int tcp;
+	int listenfd;
+	int fd;
+	int slave;
+	int wake[2];
+	pthread_t thread;
+
+	/* device state */
+	int laser;
+	int tmmode;
+	unsigned long nscan;
+	struct timespec start;
+	struct timespec next;
+	unsigned int rand;
+
+	/* continuous scanning ( stream[0] is 0 while stopped ) */
+	char stream[SCIP2_MAX_LENGTH];
+	int sstart;
+	int send;
+	int sgroup;
+	int scull;
+	int snum;
+	int ssent;
+
+	/* GS commands waiting for next scan */
+	char gs[SCIP2_SIM_QUEUE][SCIP2_MAX_LENGTH];
+	int ngs;
+
+	/* buffers */
+	char in[SCIP2_SIM_INSIZE];
+	int nin;
+	char *data;
+	char *out;
+	int nout;
+	int outsize;
+
+	/* statistics */
+	long nframe;
+	long nnoise;
+	long nglitch;
+} S2Sim_t;
+
+
+
+/** user's function */
+void S2Sim_InitModel( S2SimModel_t * apModel );
+int S2Sim_OpenPty( S2Sim_t * aSim, const S2SimModel_t * acpModel );
+int S2Sim_OpenTcp( S2Sim_t * aSim, const S2SimModel_t * acpModel, int aPort );
+void S2Sim_Close( S2Sim_t * aSim );
+const char *S2Sim_GetName( S2Sim_t * aSim );
+int S2Sim_GetPort( S2Sim_t * aSim );
+long S2Sim_GetFrames( S2Sim_t * aSim );
+long S2Sim_GetNoise( S2Sim_t * aSim );
+long S2Sim_GetGlitch( S2Sim_t * aSim );
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __LIBSCIP2HAT_SIM_H__ */
@@ -0,0 +1,103 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_transport.h
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+#ifndef __LIBSCIP2HAT_TRANSPORT_H__
+#define __LIBSCIP2HAT_TRANSPORT_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+
+#include "scip2hat.h"
+
+
+
+/** Transport carrying bytes of SCIP2.0 port
+ *  ( fd of port is polled for reading, or -1 if bytes are always ready ) */
+typedef struct SCIP2_TRANSPORT
+{
+	const char *name;
+	ssize_t ( *read ) ( S2Port *, char *, size_t );
+	ssize_t ( *write ) ( S2Port *, const char *, size_t );
+	void ( *flush ) ( S2Port * );
+	int ( *close ) ( S2Port * );
+} S2Transport;
+
+
+
+/** In-memory device ( context of memory transport ) */
+typedef struct SCIP2_MEMORY
+{
+	char *in;
+	int nin;
+	int pos;
+	int loop;
+	char *out;
+	int nout;
+	int outsize;
+} S2Memory_t;
+
+
+
+/** Magic bytes at head of recorded log
+ *  ( followed by records of uint32_t delta time [us], uint16_t length and bytes in host byte order ) */
+#define SCIP2_LOG_MAGIC "SCIP2LOG"
+
+/** Size of record header of recorded log */
+#define SCIP2_LOG_HEADER 6
+
+
+
+/** Recorded log being replayed ( context of replay transport ) */
+typedef struct SCIP2_REPLAY
+{
+	char *log;
+	long size;
+	long pos;
+	int nchunk;
+	int realtime;
+	struct timespec due;
+	long nwrite;
+} S2Replay_t;
+
+
+
+/** Transports */
+extern const S2Transport Scip2_SerialTransport;
+extern const S2Transport Scip2_TcpTransport;
+extern const S2Transport Scip2_MemoryTransport;
+extern const S2Transport Scip2_ReplayTransport;
+
+
+
+/** user's function */
+S2Port *Scip2_OpenMemory( const char *acpInput, int aNInput, int aLoop );
+const char *Scip2_GetMemoryOutput( S2Port * apPort, int *apLen );
+S2Port *Scip2_OpenReplay( const char *acpPath, int aRealtime );
+int Scip2_StartRecord( S2Port * apPort, const char *acpPath );
+void Scip2_StopRecord( S2Port * apPort );
+
+
+
+/** program function */
+void Scip2_Record( S2Port * apPort, const char *acpBuf, int aLen );
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __LIBSCIP2HAT_TRANSPORT_H__ */
@@ -0,0 +1,232 @@
+/****************************************************************/
+/**
+  @file   bench_decode.c
+  @brief  Library for Sokuiki-Sensor "URG" decoder benchmark
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "scip2hat.h"
+
+
+
+//! Number of steps in a scan ( UTM-30LX )
+#define NSTEP 1081
+//! Number of decoded scans for each case
+#define NLOOP 20000
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Encode a scan into SCIP2.0 data lines
+ * @param *apLines Buffer of encoded lines
+ * @param aNStep Number of steps
+ * @param acEnc Encode type
+ * @return Length of encoded lines
+ */
+/*--------------------------------------------------------------*/
+int encode( char *apLines, int aNStep, const S2EncType acEnc )
+{
+    //! Encoded characters
+    char *chars;
+    //! Number of characters
+    int nchar;
+    //! Length of lines
+    int len;
+    //! Check sum
+    int sum;
+    //! General
+    int i, j;
+
+    chars = ( char * )malloc( aNStep * acEnc );
+    for ( nchar = 0, i = 0; i < aNStep; i++ )
+    {
+        for ( j = acEnc - 1; j >= 0; j-- )
+            chars[nchar++] = ( ( ( 20 + i * 37 ) >> ( j * 6 ) ) & 0x3F ) + 0x30;
+    }
+
+    //! 64 characters, checksum and LF in each line
+    for ( len = 0, i = 0; i < nchar; i += 64 )
+    {
+        for ( sum = 0, j = i; j < nchar && j < i + 64; j++ )
+        {
+            apLines[len++] = chars[j];
+            sum += chars[j];
+        }
+        apLines[len++] = ( sum & 0x3F ) + 0x30;
+        apLines[len++] = '\n';
+    }
+    apLines[len++] = '\n';
+
+    free( chars );
+    return len;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Find length of each encoded line
+ * @param *apLines Encoded lines
+ * @param *apLen Buffer of length of lines
+ * @return Number of lines
+ */
+/*--------------------------------------------------------------*/
+int split( const char *apLines, int *apLen )
+{
+    //! End of line
+    const char *term;
+    //! Number of lines
+    int n;
+
+    for ( n = 0; *apLines != '\n'; n++ )
+    {
+        term = strchr( apLines, '\n' );
+        apLen[n] = term - apLines + 1;
+        apLines = term + 1;
+    }
+    apLen[n++] = 1;
+    return n;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Decode encoded lines of a scan
+ * @param *apLines Encoded lines
+ * @param *apLen Length of each line
+ * @param *apBuf Buffer of decoded data
+ * @param acType Type of decoded data
+ * @param aNBuf Size of Buffer
+ * @param acEnc Encode type
+ * @return Number of decoded data
+ */
+/*--------------------------------------------------------------*/
+int decode( const char *apLines, const int *apLen, void *apBuf, const S2ValType acType, int aNBuf,
+            const S2EncType acEnc )
+{
+    //! Remains value of line
+    unsigned long value;
+    //! Number of remains value of line
+    int nrem;
+    //! Number of decoded data
+    int size;
+    //! Returned value
+    int ret;
+
+    value = 0;
+    nrem = 0;
+    size = 0;
+    while( ( ret = Scip2_DecodeLineAs( apLines, *apLen, ( char * )apBuf + size * Scip2_ValSize( acType ), acType,
+                                       aNBuf - size, acEnc, &value, &nrem ) ) > 0 )
+    {
+        size += ret;
+        apLines += *apLen;
+        apLen++;
+    }
+    return size;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief  Main function
+ * @param  aArgc Number of Arguments
+ * @param  appArgv Arguments
+ * @return failed: 1, succeeded: 0
+ */
+/*--------------------------------------------------------------*/
+int main( int aArgc, char **appArgv )
+{
+    //! Encode types
+    const S2EncType encs[] = { SCIP2_ENC_2BYTE, SCIP2_ENC_3BYTE };
+    //! SIMD levels
+    const S2Simd simds[] = { SCIP2_SIMD_NONE, SCIP2_SIMD_SSE2, SCIP2_SIMD_AVX2 };
+    //! Name of SIMD levels
+    const char *names[] = { "scalar", "sse2", "avx2" };
+    //! Compact type for each encode type
+    const S2ValType types[] = { SCIP2_VAL_UINT16, SCIP2_VAL_UINT32 };
+    //! Encoded lines
+    char lines[NSTEP * 4 * 2];
+    //! Length of each line
+    int len[NSTEP];
+    //! Decoded data
+    unsigned long ref[NSTEP + 64], buf[NSTEP + 64];
+    //! Decoded data in compact type
+    uint32_t buf32[NSTEP + 64];
+    //! Pointer to compact data
+    uint16_t *buf16;
+    //! Time of start and end
+    struct timeval tms, tme;
+    //! Nano seconds per scan
+    double ns, base;
+    //! Number of decoded data
+    int size;
+    //! General
+    int e, s, i;
+
+    buf16 = ( uint16_t * ) buf32;
+    for ( e = 0; e < 2; e++ )
+    {
+        encode( lines, NSTEP, encs[e] );
+        split( lines, len );
+        Scip2_SetSimd( SCIP2_SIMD_NONE );
+        decode( lines, len, ref, SCIP2_VAL_ULONG, NSTEP + 64, encs[e] );
+        base = 0;
+
+        for ( s = 0; s < 3; s++ )
+        {
+            if( Scip2_SetSimd( simds[s] ) != simds[s] )
+                continue;
+            memset( buf, 0, sizeof ( buf ) );
+            size = decode( lines, len, buf, SCIP2_VAL_ULONG, NSTEP + 64, encs[e] );
+            if( size != NSTEP || memcmp( buf, ref, sizeof ( unsigned long ) * NSTEP ) != 0 )
+            {
+                fprintf( stderr, "ERROR: %s decoder mismatch.\n", names[s] );
+                return 1;
+            }
+            memset( buf32, 0, sizeof ( buf32 ) );
+            size = decode( lines, len, buf32, types[e], NSTEP + 64, encs[e] );
+            for ( i = 0; i < NSTEP; i++ )
+            {
+                if( ( types[e] == SCIP2_VAL_UINT16 ? buf16[i] : buf32[i] ) != ref[i] )
+                    size = -1;
+            }
+            if( size != NSTEP )
+            {
+                fprintf( stderr, "ERROR: %s compact decoder mismatch.\n", names[s] );
+                return 1;
+            }
+
+            gettimeofday( &tms, NULL );
+            for ( i = 0; i < NLOOP; i++ )
+                decode( lines, len, buf, SCIP2_VAL_ULONG, NSTEP + 64, encs[e] );
+            gettimeofday( &tme, NULL );
+
+            ns = ( ( tme.tv_sec - tms.tv_sec ) * 1e9 + ( tme.tv_usec - tms.tv_usec ) * 1e3 ) / NLOOP;
+            if( s == 0 )
+                base = ns;
+            printf( "%d bytes encoding, %-6s: %8.0f ns/scan ( x%.2f )", encs[e], names[s], ns, base / ns );
+
+            gettimeofday( &tms, NULL );
+            for ( i = 0; i < NLOOP; i++ )
+                decode( lines, len, buf32, types[e], NSTEP + 64, encs[e] );
+            gettimeofday( &tme, NULL );
+
+            ns = ( ( tme.tv_sec - tms.tv_sec ) * 1e9 + ( tme.tv_usec - tms.tv_usec ) * 1e3 ) / NLOOP;
+            printf( ", compact: %8.0f ns/scan ( x%.2f )\n", ns, base / ns );
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+/****************************************************************/
+/**
+  @file   sim_urg.c
+  @brief  Library for Sokuiki-Sensor "URG" simulator program
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include "scip2hat.h"
+
+
+
+//! Maximum number of simulated sensors
+#define MAX_SIM 256
+
+//! Shut off Flag
+int gShutoff;
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Ctrl+C trap
+ * @param aN not used
+ */
+/*--------------------------------------------------------------*/
+void ctrlc( int aN )
+{
+    gShutoff = 1;
+    signal( SIGINT, NULL );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief  Main function
+ * @param  aArgc Number of Arguments
+ * @param  appArgv Arguments
+ * @return failed: 0, succeeded: 1
+ */
+/*--------------------------------------------------------------*/
+int main( int aArgc, char **appArgv )
+{
+    static S2Sim_t sim[MAX_SIM];   //! Simulated sensors
+    S2SimModel_t model;            //! Model of the sensors
+    int ntcp = 1;                  //! Number of sensors on TCP
+    int npty = 0;                  //! Number of sensors on pseudo-terminal
+    int port = 0;                  //! First TCP port ( 0: chosen by system )
+    int nsim;                      //! Number of started sensors
+    int opt;                       //! Option charactor
+    int i;                         //! Loop valiant
+
+    S2Sim_InitModel( &model );
+    while( ( opt = getopt( aArgc, appArgv, "t:y:p:s:e:r:P:n:g:w:" ) ) != -1 ){
+        switch( opt ){
+        case 't': ntcp = atoi( optarg ); break;
+        case 'y': npty = atoi( optarg ); break;
+        case 'p': port = atoi( optarg ); break;
+        case 's': model.param.step_min = atoi( optarg ); break;
+        case 'e': model.param.step_max = atoi( optarg ); break;
+        case 'r': model.param.revolution = atoi( optarg ); break;
+        case 'P': model.pattern = ( S2SimPattern )atoi( optarg ); break;
+        case 'n': model.noise = atoi( optarg ); break;
+        case 'g': model.glitch = atoi( optarg ); break;
+        case 'w': model.time_offset = 0x1000000 - atoi( optarg ); break;
+        default:
+            fprintf( stderr, "USAGE: %s [-t tcp_sensors] [-y pty_sensors] [-p first_port]\n"
+                     "        [-s step_min] [-e step_max] [-r rpm] [-P pattern(0:flat 1:ramp 2:wave)]\n"
+                     "        [-n noise(1/N lines)] [-g glitch(1/N frames)] [-w ms_before_timestamp_wraps]\n", appArgv[0] );
+            return 0;
+        }
+    }
+    if( ntcp + npty > MAX_SIM ){
+        fprintf( stderr, "ERROR: Too many sensors.\n" );
+        return 0;
+    }
+
+    //! Start trapping ctrl+c signal
+    gShutoff = 0;
+    signal( SIGINT, ctrlc );
+
+    //! Start sensors ( each has its own seed of noise )
+    for( nsim = 0; nsim < ntcp + npty; nsim++ ){
+        model.seed = nsim + 1;
+        if( nsim < ntcp ){
+            if( !S2Sim_OpenTcp( &sim[nsim], &model, port ? port + nsim : 0 ) ){
+                fprintf( stderr, "ERROR: Failed to open TCP sensor.\n" );
+                break;
+            }
+        }
+        else if( !S2Sim_OpenPty( &sim[nsim], &model ) ){
+            fprintf( stderr, "ERROR: Failed to open pty sensor.\n" );
+            break;
+        }
+        printf( "%s\n", S2Sim_GetName( &sim[nsim] ) );
+    }
+    fflush( stdout );
+
+    while( !gShutoff && nsim == ntcp + npty )
+        usleep( 100000 );
+    printf( "\nStopping\n" );
+
+    for( i = 0; i < nsim; i++ ){
+        printf( "%s: %ld scans, %ld broken lines, %ld broken frames\n",
+                S2Sim_GetName( &sim[i] ), S2Sim_GetFrames( &sim[i] ), S2Sim_GetNoise( &sim[i] ),
+                S2Sim_GetGlitch( &sim[i] ) );
+        S2Sim_Close( &sim[i] );
+    }
+
+    return 1;
+}
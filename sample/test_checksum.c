@@ -0,0 +1,119 @@
+/****************************************************************/
+/**
+  @file   test_checksum.c
+  @brief  Library for Sokuiki-Sensor "URG" test program
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "scip2hat.h"
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief  Main function
+ * @param  aArgc Number of Arguments
+ * @param  appArgv Arguments
+ * @return failed: 0, succeeded: 1
+ * @attention Prints "OK" if scans broken by line noise of the simulator are counted
+ *            as lines with bad checksum exactly when checksum is enabled on the port.
+ */
+/*--------------------------------------------------------------*/
+int main( int aArgc, char **appArgv )
+{
+    S2Sim_t sim;             //! Simulated sensor
+    S2SimModel_t model;      //! Model of the sensor
+    S2Port *port;            //! Device Port
+    S2Sdd_t buf;             //! Data recive buffer
+    S2Scan_t *data;          //! Pointer to data buffer
+    int nscan;               //! Number of scans to recive par run
+    int count;               //! Number of scans recived
+    int nbroken;             //! Number of scans with broken data
+    int nbadsum;             //! Number of scans with bad checksum
+    int broken;              //! Data of the scan is broken
+    int ok;                  //! Scans are valid
+    int ret;                 //! Returned value
+    time_t limit;            //! Time to give up
+    int run;                 //! Checksum is enabled
+    int i;                   //! Loop valiant
+
+    nscan = aArgc > 1 ? atoi( appArgv[1] ) : 50;
+
+    //! One of 100 data lines has a bit flipped ( about 2 of 5 scans are broken )
+    S2Sim_InitModel( &model );
+    model.param.revolution = 6000;
+    model.noise = 100;
+    if( !S2Sim_OpenTcp( &sim, &model, 0 ) ){
+        fprintf( stderr, "ERROR: Failed to open TCP sensor.\n" );
+        return 0;
+    }
+    port = Scip2_OpenEthernet( "127.0.0.1", S2Sim_GetPort( &sim ) );
+    if( port == 0 ){
+        fprintf( stderr, "ERROR: Failed to open device.\n" );
+        return 0;
+    }
+    S2Sdd_Init( &buf );
+
+    ok = 1;
+    for( run = 0; run < 2 && ok; run++ ){
+        Scip2_SetChecksum( port, run );
+        if( !Scip2CMD_StartMS( port, 0, 1080, 1, 0, 0, &buf, SCIP2_ENC_3BYTE ) ){
+            fprintf( stderr, "ERROR: StartMS failed.\n" );
+            return 0;
+        }
+        count = 0;
+        nbroken = 0;
+        nbadsum = 0;
+        limit = time( NULL ) + 10;
+        while( ok && count < nscan && time( NULL ) < limit ){
+            ret = S2Sdd_Begin( &buf, &data );
+            if( ret < 0 ){
+                fprintf( stderr, "NG: fatal error.\n" );
+                ok = 0;
+            }
+            else if( ret == 0 ){
+                S2Sdd_Wait( &buf, 100 );
+                continue;
+            }
+            for( i = 1; i < data->size; i++ ){
+                if( data->data[i] != data->data[0] + 10 * i )
+                    break;
+            }
+            broken = data->size != 1081 || i < data->size;
+            nbroken += broken;
+            nbadsum += data->nbadsum > 0;
+            //! Broken scan is still published, but reported only when checksum is enabled
+            if( data->nbadsum < 0 || ( run == 0 && data->nbadsum != 0 )
+                || ( run == 1 && broken != ( data->nbadsum > 0 ) ) ){
+                fprintf( stderr, "NG: checksum %d: scan %lu with %d bad lines is %s.\n",
+                         run, data->seq, data->nbadsum, broken ? "broken" : "whole" );
+                ok = 0;
+            }
+            S2Sdd_End( &buf );
+            count++;
+        }
+        Scip2CMD_StopMS( port, &buf );
+        printf( "checksum %d: %d scans recived, %d broken, %d with bad checksum\n",
+                run, count, nbroken, nbadsum );
+        if( count < nscan || nbroken == 0 )
+            ok = 0;
+    }
+
+    S2Sdd_Dest( &buf );
+    Scip2_Close( port );
+    S2Sim_Close( &sim );
+
+    if( !ok ){
+        printf( "NG\n" );
+        return 0;
+    }
+    printf( "OK ( lines with bad checksum counted par scan )\n" );
+    return 1;
+}
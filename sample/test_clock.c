@@ -0,0 +1,188 @@
+/****************************************************************/
+/**
+  @file   test_clock.c
+  @brief  Library for Sokuiki-Sensor "URG" test program
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "scip2hat.h"
+
+//! Skew of synthetic sensor clock [ppm]
+#define SKEW 200.0
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Convert time of host to milliseconds
+ * @param *acpTime Pointer to CLOCK_MONOTONIC time
+ * @return Time [ms]
+ */
+/*--------------------------------------------------------------*/
+double to_ms( const struct timespec *acpTime )
+{
+    return acpTime->tv_sec * 1000.0 + acpTime->tv_nsec / 1000000.0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Fit clock model to synthetic scans over wrap around of time stamp
+ * @return failed: 0, succeeded: 1
+ */
+/*--------------------------------------------------------------*/
+int check_model( void )
+{
+    S2Clock_t clock;             //! Clock model
+    struct timespec arrival;     //! Arrival time of scan
+    struct timespec host;        //! Time of host by the model
+    unsigned long start;         //! Time stamp of first scan
+    long long utime;             //! Unwrapped time stamp
+    double ms;                   //! Arrival time [ms]
+    double error;                //! Error of the model [ms]
+    unsigned int seed;           //! Seed of delay
+    int ok;                      //! Model is valid
+    long dev;                    //! Loop valiant
+
+    //! Scans of 25 ms for 100 s, with time stamp wrapping around after 10 s and delay up to 3 ms
+    S2Clock_Init( &clock );
+    start = 0x1000000 - 10000;
+    seed = 1;
+    ok = 1;
+    for( dev = 0; dev < 100000 && ok; dev += 25 ){
+        utime = S2Clock_Unwrap( &clock, ( start + dev ) & 0xFFFFFF );
+        if( utime != ( long long )( start + dev ) ){
+            fprintf( stderr, "NG: time stamp %lu unwrapped to %lld.\n", ( start + dev ) & 0xFFFFFF, utime );
+            ok = 0;
+        }
+        ms = 5000000.0 + dev * ( 1.0 + SKEW * 1e-6 ) + ( rand_r( &seed ) % 3000 ) / 1000.0;
+        arrival.tv_sec = ( time_t )( ms / 1000.0 );
+        arrival.tv_nsec = ( long )( ( ms - arrival.tv_sec * 1000.0 ) * 1000000.0 );
+        S2Clock_Update( &clock, utime, &arrival );
+    }
+
+    //! Model gives time without delay
+    S2Clock_ToHost( &clock, start + dev, &host );
+    error = to_ms( &host ) - ( 5000000.0 + dev * ( 1.0 + SKEW * 1e-6 ) );
+    printf( "model: skew %.1f ppm ( %.1f ppm given ), error %.3f ms\n",
+            S2Clock_GetSkew( &clock ), SKEW, error );
+    if( S2Clock_GetSkew( &clock ) < SKEW - 20 || S2Clock_GetSkew( &clock ) > SKEW + 20
+        || error < -1.0 || error > 1.0 )
+        ok = 0;
+    return ok;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief  Main function
+ * @param  aArgc Number of Arguments
+ * @param  appArgv Arguments
+ * @return failed: 0, succeeded: 1
+ * @attention Prints "OK" if clock model fits synthetic scans of skewed clock, and
+ *            stamps scans of the simulator increasing over wrap around of time stamp
+ *            and synchronization by TM command in the middle of scanning.
+ */
+/*--------------------------------------------------------------*/
+int main( int aArgc, char **appArgv )
+{
+    S2Sim_t sim;             //! Simulated sensor
+    S2SimModel_t model;      //! Model of the sensor
+    S2Port *port;            //! Device Port
+    S2Sdd_t buf;             //! Data recive buffer
+    S2Scan_t *data;          //! Pointer to data buffer
+    unsigned long last;      //! Sequence number of last scan
+    long long lastutime;     //! Unwrapped time stamp of last scan
+    double laststamp;        //! Stamp of last scan [ms]
+    double delay;            //! Delay of echo back from stamp [ms]
+    int nscan;               //! Number of scans to recive
+    int count;               //! Number of scans recived
+    int nwrap;               //! Number of time stamps going back
+    int ok;                  //! Scans are valid
+    int ret;                 //! Returned value
+    time_t limit;            //! Time to give up
+
+    nscan = aArgc > 1 ? atoi( appArgv[1] ) : 60;
+
+    ok = check_model(  );
+
+    //! Time stamp of the simulator wraps around 200 ms after start
+    S2Sim_InitModel( &model );
+    model.param.revolution = 6000;
+    model.time_offset = 0x1000000 - 200;
+    if( !S2Sim_OpenTcp( &sim, &model, 0 ) ){
+        fprintf( stderr, "ERROR: Failed to open TCP sensor.\n" );
+        return 0;
+    }
+    port = Scip2_OpenEthernet( "127.0.0.1", S2Sim_GetPort( &sim ) );
+    if( port == 0 ){
+        fprintf( stderr, "ERROR: Failed to open device.\n" );
+        return 0;
+    }
+    S2Sdd_Init( &buf );
+    S2Sdd_SyncClock( &buf );
+    if( !Scip2CMD_StartMS( port, 0, 1080, 1, 0, 0, &buf, SCIP2_ENC_3BYTE ) ){
+        fprintf( stderr, "ERROR: StartMS failed.\n" );
+        return 0;
+    }
+
+    last = 0;
+    lastutime = 0;
+    laststamp = 0;
+    count = 0;
+    nwrap = 0;
+    limit = time( NULL ) + 10;
+    while( ok && count < nscan && time( NULL ) < limit ){
+        ret = S2Sdd_Begin( &buf, &data );
+        if( ret < 0 ){
+            fprintf( stderr, "NG: fatal error.\n" );
+            ok = 0;
+        }
+        else if( ret == 0 ){
+            S2Sdd_Wait( &buf, 100 );
+            continue;
+        }
+        if( count > 0 && data->time < ( lastutime & 0xFFFFFF ) )
+            nwrap++;
+        //! Stamp is before arrival of echo back by transfer of the scan at most
+        delay = to_ms( &data->techo ) - to_ms( &data->stamp );
+        if( data->seq <= last || ( long long )( data->utime & 0xFFFFFF ) != ( long long )data->time
+            || ( count > 0 && ( data->utime <= lastutime || to_ms( &data->stamp ) <= laststamp ) )
+            || delay < -2.0 || delay > 10.0 ){
+            fprintf( stderr, "NG: time stamp %lu unwrapped to %lld after %lld, delay %.3f ms.\n",
+                     data->time, data->utime, lastutime, delay );
+            ok = 0;
+        }
+        last = data->seq;
+        lastutime = data->utime;
+        laststamp = to_ms( &data->stamp );
+        S2Sdd_End( &buf );
+        //! Synchronize again in the middle of scanning
+        if( ++count == nscan / 2 )
+            S2Sdd_SyncClock( &buf );
+    }
+    Scip2CMD_StopMS( port, &buf );
+    printf( "%d scans recived, time stamp wrapped %d times, last %lld\n", count, nwrap, lastutime );
+    if( count < nscan || nwrap != 1 )
+        ok = 0;
+
+    S2Sdd_Dest( &buf );
+    Scip2_Close( port );
+    S2Sim_Close( &sim );
+
+    if( !ok ){
+        printf( "NG\n" );
+        return 0;
+    }
+    printf( "OK ( clock model over wrap around and synchronization )\n" );
+    return 1;
+}
@@ -9,6 +9,7 @@
 
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <sys/time.h>
 #include <signal.h>
@@ -58,16 +59,22 @@ int main( int aArgc, char **appArgv )
     S2Scan_t *data;
     //! Loop valiant
     int j;
+    //! Number of scans to recive ( 0: until ctrl+c )
+    int nscan;
+    //! Number of scans recived
+    int count;
     //! Returned value
     int ret;
     //! Local time
     struct timeval tm;
 
-    if( aArgc != 2 )
+    if( aArgc != 2 && aArgc != 3 )
     {
-        fprintf( stderr, "USAGE: %s device\n", appArgv[0] );
+        fprintf( stderr, "USAGE: %s device [number_of_scans]\n", appArgv[0] );
         return 0;
     }
+    nscan = aArgc == 3 ? atoi( appArgv[2] ) : 0;
+    count = 0;
 
     //! Start trapping ctrl+c signal
     gShutoff = 0;
@@ -123,6 +130,10 @@ int main( int aArgc, char **appArgv )
 
             //! Don't forget S2Sdd_End to unlock buffer
             S2Sdd_End( &buf );
+
+            count++;
+            if( nscan > 0 && count >= nscan )
+                break;
         }
         else if( ret == -1 )
         {
@@ -131,10 +142,11 @@ int main( int aArgc, char **appArgv )
         }
         else
         {
-            usleep( 100 );
+            //! Wait for next scan ( up to 100ms to check ctrl+c )
+            S2Sdd_Wait( &buf, 100 );
         }
     }
-    printf( "\nStopping\n" );
+    printf( "\nStopping ( %d scans recived )\n", count );
 
     //! Power laser OFF
     Scip2CMD_StopGS( port, &buf );
@@ -0,0 +1,30 @@
+#!/bin/sh
+# ------------------------------------------------------------
+#  Run test_gs against pty sensor of sim_urg
+#
+#    $ test_gs_sim.sh <sample_dir> [number_of_scans]
+#  test_gs issues GS between S2Sdd_Begin and S2Sdd_End,
+#  so this fails by timeout if that path locks up.
+# ------------------------------------------------------------
+
+dir=$1
+nscan=${2:-20}
+out=$(mktemp)
+
+"$dir/sim_urg" -t 0 -y 1 > "$out" &
+sim=$!
+trap 'kill -INT $sim 2> /dev/null; wait $sim; rm -f "$out"' EXIT
+
+# wait for name of pty
+i=0
+while [ -z "$(head -n 1 "$out")" ] && [ $i -lt 50 ]; do
+    sleep 0.1
+    i=$((i + 1))
+done
+dev=$(head -n 1 "$out")
+if [ -z "$dev" ]; then
+    echo "ERROR: sim_urg did not start." >&2
+    exit 1
+fi
+
+"$dir/test_gs" "$dev" "$nscan"
@@ -0,0 +1,200 @@
+/****************************************************************/
+/**
+  @file   test_latency.c
+  @brief  Library for Sokuiki-Sensor "URG" test program
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "scip2hat.h"
+
+//! Number of synthetic latencies
+#define NLAT 10000
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Compare latencies for qsort
+ * @param *acpA Pointer to latency
+ * @param *acpB Pointer to latency
+ * @return Order of latencies
+ */
+/*--------------------------------------------------------------*/
+int compare( const void *acpA, const void *acpB )
+{
+    return *( const long * )acpA < *( const long * )acpB ? -1 : *( const long * )acpA > *( const long * )acpB;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Count synthetic latencies and compare percentiles with sorted latencies
+ * @return failed: 0, succeeded: 1
+ */
+/*--------------------------------------------------------------*/
+int check_hist( void )
+{
+    static long lat[NLAT];                              //! Latencies [us]
+    static const double ratio[] = { 0.1, 0.5, 0.9, 0.99, 1.0 };   //! Ratios of percentiles
+    S2Hist_t hist;                                      //! Latency histogram
+    S2LatStat_t stat;                                   //! Summary of histogram
+    struct timespec from, to;                           //! Start and end of latency
+    unsigned int seed;                                  //! Seed of latencies
+    long exact;                                         //! Percentile of sorted latencies
+    long p;                                             //! Percentile of histogram
+    int ok;                                             //! Histogram is valid
+    int i;                                              //! Loop valiant
+
+    S2Hist_Init( &hist );
+    S2Hist_GetStat( &hist, &stat );
+    if( stat.count != 0 || stat.p50 != -1 || stat.max != -1 )
+        return 0;
+
+    //! Latencies from 0 us to about 16 s spread over octaves
+    seed = 1;
+    from.tv_sec = 100;
+    from.tv_nsec = 999999000;
+    for( i = 0; i < NLAT; i++ ){
+        lat[i] = ( long )( rand_r( &seed ) % 1000 ) << ( rand_r( &seed ) % 15 );
+        to.tv_sec = from.tv_sec + ( from.tv_nsec / 1000 + lat[i] ) / 1000000;
+        to.tv_nsec = ( ( from.tv_nsec / 1000 + lat[i] ) % 1000000 ) * 1000;
+        S2Hist_Add( &hist, &from, &to );
+    }
+    qsort( lat, NLAT, sizeof ( long ), compare );
+
+    //! Percentile is upper edge of its bin, at most 1/8 above
+    S2Hist_GetStat( &hist, &stat );
+    printf( "histogram: %lu latencies, p50 %ld us ( %ld ), p99 %ld us ( %ld ), max %ld us ( %ld )\n",
+            stat.count, stat.p50, lat[NLAT / 2 - 1], stat.p99, lat[NLAT * 99 / 100 - 1], stat.max, lat[NLAT - 1] );
+    ok = stat.count == NLAT && stat.max == lat[NLAT - 1];
+    for( i = 0; i < ( int )( sizeof ( ratio ) / sizeof ( ratio[0] ) ); i++ ){
+        exact = lat[( int )( ratio[i] * NLAT + 0.5 ) - 1];
+        p = S2Hist_Percentile( &hist, ratio[i] );
+        if( p < exact || p > exact + exact / 8 ){
+            fprintf( stderr, "NG: percentile %.2f is %ld us for %ld us.\n", ratio[i], p, exact );
+            ok = 0;
+        }
+    }
+    return ok;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Check stamps of scan given to callback
+ * @param *aScan Pointer to scan
+ * @param *aUser Pointer to number of scans with valid stamps
+ * @return 1
+ */
+/*--------------------------------------------------------------*/
+int callback( S2Scan_t * aScan, void *aUser )
+{
+    struct timespec *t[3];   //! Stamps of stages
+    int i;                   //! Loop valiant
+
+    //! Callback runs in reciver before the scan is published
+    t[0] = &aScan->techo;
+    t[1] = &aScan->tdecode;
+    t[2] = &aScan->tcallback;
+    for( i = 0; i < 2; i++ ){
+        if( t[i]->tv_sec == 0 || t[i]->tv_sec > t[i + 1]->tv_sec
+            || ( t[i]->tv_sec == t[i + 1]->tv_sec && t[i]->tv_nsec > t[i + 1]->tv_nsec ) )
+            return 1;
+    }
+    if( aScan->tpublish.tv_sec == 0 && aScan->tpublish.tv_nsec == 0 )
+        __atomic_add_fetch( ( int * )aUser, 1, __ATOMIC_RELAXED );
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief  Main function
+ * @param  aArgc Number of Arguments
+ * @param  appArgv Arguments
+ * @return failed: 0, succeeded: 1
+ * @attention Prints "OK" if percentiles of latency histogram are within their bins
+ *            from sorted latencies, and histograms of scans of the simulator count
+ *            every scan with end to end latency not below transfer.
+ */
+/*--------------------------------------------------------------*/
+int main( int aArgc, char **appArgv )
+{
+    S2Sim_t sim;                          //! Simulated sensor
+    S2SimModel_t model;                   //! Model of the sensor
+    S2Port *port;                         //! Device Port
+    S2Sdd_t buf;                          //! Data recive buffer
+    S2LatStat_t stat[SCIP2_LAT_NSTAGE];   //! Latency of stages
+    int nscan;                            //! Number of scans to recive
+    int count;                            //! Number of scans with valid stamps
+    int ok;                               //! Latencies are valid
+    int tries;                            //! Number of waits
+    int i;                                //! Loop valiant
+
+    nscan = aArgc > 1 ? atoi( appArgv[1] ) : 50;
+
+    ok = check_hist(  );
+
+    S2Sim_InitModel( &model );
+    model.param.revolution = 6000;
+    if( !S2Sim_OpenTcp( &sim, &model, 0 ) ){
+        fprintf( stderr, "ERROR: Failed to open TCP sensor.\n" );
+        return 0;
+    }
+    port = Scip2_OpenEthernet( "127.0.0.1", S2Sim_GetPort( &sim ) );
+    if( port == 0 ){
+        fprintf( stderr, "ERROR: Failed to open device.\n" );
+        return 0;
+    }
+    S2Sdd_Init( &buf );
+    count = 0;
+    S2Sdd_setCallback( &buf, callback, &count );
+    if( !Scip2CMD_StartMS( port, 0, 1080, 1, 0, nscan, &buf, SCIP2_ENC_3BYTE ) ){
+        fprintf( stderr, "ERROR: StartMS failed.\n" );
+        return 0;
+    }
+    for( tries = 0; tries < 500 && __atomic_load_n( &count, __ATOMIC_RELAXED ) < nscan; tries++ )
+        usleep( 10000 );
+    Scip2CMD_StopMS( port, &buf );
+
+    for( i = 0; i < SCIP2_LAT_NSTAGE; i++ ){
+        S2Sdd_GetLatency( &buf, ( S2LatStage )i, &stat[i] );
+        printf( "stage %d: %lu scans, p50 %ld us, p99 %ld us, max %ld us\n",
+                i, stat[i].count, stat[i].p50, stat[i].p99, stat[i].max );
+        if( stat[i].p50 < 0 || stat[i].p50 > stat[i].p99 || stat[i].p99 > stat[i].max )
+            ok = 0;
+    }
+    //! Every scan is counted once in each stage, end to end includes transfer
+    if( count != nscan || stat[SCIP2_LAT_TRANSFER].count != ( unsigned long )nscan
+        || stat[SCIP2_LAT_CALLBACK].count != ( unsigned long )nscan
+        || stat[SCIP2_LAT_TOTAL].count != ( unsigned long )nscan
+        || stat[SCIP2_LAT_TOTAL].p50 < stat[SCIP2_LAT_TRANSFER].p50
+        || stat[SCIP2_LAT_TOTAL].max < stat[SCIP2_LAT_TRANSFER].max )
+        ok = 0;
+    S2Sdd_ResetLatency( &buf );
+    S2Sdd_GetLatency( &buf, SCIP2_LAT_TOTAL, &stat[SCIP2_LAT_TOTAL] );
+    if( stat[SCIP2_LAT_TOTAL].count != 0 )
+        ok = 0;
+
+    S2Sdd_Dest( &buf );
+    Scip2_Close( port );
+    S2Sim_Close( &sim );
+
+    if( !ok ){
+        printf( "NG\n" );
+        return 0;
+    }
+    printf( "OK ( latency histograms par stage )\n" );
+    return 1;
+}
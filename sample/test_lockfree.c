@@ -0,0 +1,147 @@
+/****************************************************************/
+/**
+  @file   test_lockfree.c
+  @brief  Library for Sokuiki-Sensor "URG" test program
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "scip2hat.h"
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Check that scan of ramp pattern is not torn by reciver
+ * @param *apScan Pointer to scan
+ * @param aNStep Number of steps expected
+ * @return broken: 0, valid: 1
+ */
+/*--------------------------------------------------------------*/
+int check_ramp( S2Scan_t * apScan, int aNStep )
+{
+    int i;      //! Loop valiant
+
+    if( apScan->size != aNStep )
+        return 0;
+    for( i = 1; i < aNStep; i++ ){
+        if( apScan->data[i] != apScan->data[0] + 10 * i )
+            return 0;
+    }
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief  Main function
+ * @param  aArgc Number of Arguments
+ * @param  appArgv Arguments
+ * @return failed: 0, succeeded: 1
+ * @attention Prints "OK" if scans picked up in lock free mode are whole and
+ *            their sequence numbers strictly increase, over restarts of scanning.
+ *            Last run holds two scans by S2Sdd_Acquire, so that reciver takes spare buffers.
+ */
+/*--------------------------------------------------------------*/
+int main( int aArgc, char **appArgv )
+{
+    S2Sim_t sim;             //! Simulated sensor
+    S2SimModel_t model;      //! Model of the sensor
+    S2Port *port;            //! Device Port
+    S2Sdd_t buf;             //! Data recive buffer
+    S2Scan_t *data;          //! Pointer to data buffer
+    S2Scan_t *held;          //! Scan acquired before data
+    unsigned long last;      //! Sequence number of last scan
+    int nscan;               //! Number of scans to recive par run
+    int count;               //! Number of scans recived
+    int nstep;               //! Number of steps of the run
+    int ok;                  //! Scans are valid
+    int ret;                 //! Returned value
+    time_t limit;            //! Time to give up
+    int run;                 //! Loop valiant
+
+    nscan = aArgc > 1 ? atoi( appArgv[1] ) : 50;
+
+    S2Sim_InitModel( &model );
+    model.param.revolution = 6000;
+    if( !S2Sim_OpenTcp( &sim, &model, 0 ) ){
+        fprintf( stderr, "ERROR: Failed to open TCP sensor.\n" );
+        return 0;
+    }
+    port = Scip2_OpenEthernet( "127.0.0.1", S2Sim_GetPort( &sim ) );
+    if( port == 0 ){
+        fprintf( stderr, "ERROR: Failed to open device.\n" );
+        return 0;
+    }
+    S2Sdd_Init( &buf );
+    S2Sdd_setLockFree( &buf, 1 );
+    S2Sdd_setPool( &buf, 4 );
+
+    //! Scanning is restarted with larger scans, so that buffers are reserved again
+    ok = 1;
+    last = 0;
+    held = NULL;
+    for( run = 0; run < 4 && ok; run++ ){
+        nstep = 361 + ( run < 2 ? run : 2 ) * 360;
+        if( !Scip2CMD_StartMS( port, 0, nstep - 1, 1, 0, 0, &buf, SCIP2_ENC_3BYTE ) ){
+            fprintf( stderr, "ERROR: StartMS failed.\n" );
+            return 0;
+        }
+        count = 0;
+        limit = time( NULL ) + 10;
+        while( ok && count < nscan && time( NULL ) < limit ){
+            ret = run < 3 ? S2Sdd_Begin( &buf, &data ) : S2Sdd_Acquire( &buf, &data );
+            if( ret < 0 ){
+                fprintf( stderr, "NG: fatal error.\n" );
+                ok = 0;
+            }
+            else if( ret == 0 ){
+                S2Sdd_Wait( &buf, 100 );
+                continue;
+            }
+            //! Reader is slower than sensor now and then, so that reciver drops scans
+            usleep( ( count % 4 ) * 8000 );
+            if( !check_ramp( data, nstep ) || data->seq <= last || ( held && !check_ramp( held, nstep ) ) ){
+                fprintf( stderr, "NG: run %d: %d steps, sequence %lu after %lu.\n",
+                         run, data->size, data->seq, last );
+                ok = 0;
+            }
+            last = data->seq;
+            if( run < 3 )
+                S2Sdd_End( &buf );
+            else{
+                if( held )
+                    S2Sdd_Release( &buf, held );
+                held = data;
+            }
+            count++;
+        }
+        Scip2CMD_StopMS( port, &buf );
+        if( held )
+            S2Sdd_Release( &buf, held );
+        held = NULL;
+        printf( "run %d: %d scans recived, last sequence %lu, %d dropped\n",
+                run, count, last, S2Sdd_GetDropped( &buf ) );
+        if( count < nscan )
+            ok = 0;
+    }
+
+    S2Sdd_Dest( &buf );
+    Scip2_Close( port );
+    S2Sim_Close( &sim );
+
+    if( !ok ){
+        printf( "NG\n" );
+        return 0;
+    }
+    printf( "OK ( sequence strictly increasing in lock free mode )\n" );
+    return 1;
+}
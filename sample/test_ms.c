@@ -114,7 +114,8 @@ int main( int aArgc, char **appArgv )
             break;
         }
         else{
-            usleep( 100 );
+            //! Wait for next scan ( up to 100ms to check ctrl+c )
+            S2Sdd_Wait( &buf, 100 );
         }
     }
     printf( "\nStopping\n" );
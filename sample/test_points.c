@@ -0,0 +1,176 @@
+/****************************************************************/
+/**
+  @file   test_points.c
+  @brief  Library for Sokuiki-Sensor "URG" test program
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "scip2hat.h"
+
+//! Number of runs of scanning
+#define NRUN 4
+
+
+
+/** Setting of a run of scanning */
+typedef struct TEST_RUN
+{
+	S2Simd simd;
+	int storage;
+	S2EncType enc;
+	int group;
+} TestRun_t;
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Compare points of scan with points converted one by one in double
+ * @param *apScan Pointer to scan
+ * @param *acpParam Parameters of sensor
+ * @param *acpPose Mounting pose of sensor
+ * @return different: 0, same: 1
+ */
+/*--------------------------------------------------------------*/
+int check_points( S2Scan_t * apScan, const S2Param_t * acpParam, const S2Pose_t * acpPose )
+{
+    double angle;    //! Direction of step [rad]
+    double r;        //! Range of step [mm]
+    double x, y;     //! Point of step [mm]
+    int stride;      //! Number of values par step
+    int i;           //! Loop valiant
+
+    stride = apScan->enc == SCIP2_ENC_3X2BYTE ? 2 : 1;
+    for( i = 0; i < apScan->nstep; i++ ){
+        angle = acpPose->yaw + 2 * M_PI * ( apScan->start + i * apScan->group + ( apScan->group - 1 ) / 2.0
+                                            - acpParam->step_front ) / acpParam->step_resolution;
+        r = S2Scan_Value( apScan, i * stride );
+        if( r < acpParam->dist_min ){
+            if( !isnan( apScan->x[i] ) || !isnan( apScan->y[i] ) )
+                break;
+            continue;
+        }
+        x = r * cos( angle ) + acpPose->x;
+        y = r * sin( angle ) + acpPose->y;
+        if( fabs( apScan->x[i] - x ) > 0.05 || fabs( apScan->y[i] - y ) > 0.05 )
+            break;
+    }
+    if( i < apScan->nstep ){
+        fprintf( stderr, "NG: step %d of range %lu is ( %f, %f ).\n",
+                 i, S2Scan_Value( apScan, i * stride ), apScan->x[i], apScan->y[i] );
+        return 0;
+    }
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief  Main function
+ * @param  aArgc Number of Arguments
+ * @param  appArgv Arguments
+ * @return failed: 0, succeeded: 1
+ * @attention Prints "OK" if Cartesian points made by reciver are the same as points
+ *            converted one by one, over SIMD instruction sets, storage modes and groups.
+ */
+/*--------------------------------------------------------------*/
+int main( int aArgc, char **appArgv )
+{
+    static const TestRun_t runs[NRUN] = {
+        { SCIP2_SIMD_NONE, SCIP2_STORE_ULONG, SCIP2_ENC_3BYTE, 1 },
+        { SCIP2_SIMD_SSE2, SCIP2_STORE_COMPACT, SCIP2_ENC_2BYTE, 1 },
+        { SCIP2_SIMD_AVX2, SCIP2_STORE_COMPACT, SCIP2_ENC_3BYTE, 3 },
+        { SCIP2_SIMD_AVX2, SCIP2_STORE_COMPACT, SCIP2_ENC_3X2BYTE, 2 }
+    };                       //! Settings of runs
+    S2Sim_t sim;             //! Simulated sensor
+    S2SimModel_t model;      //! Model of the sensor
+    S2Port *port;            //! Device Port
+    S2Sdd_t buf;             //! Data recive buffer
+    S2Scan_t *data;          //! Pointer to data buffer
+    S2Param_t param;         //! Parameters of sensor
+    S2Pose_t pose;           //! Mounting pose of sensor
+    int nscan;               //! Number of scans to recive par run
+    int count;               //! Number of scans recived
+    int ok;                  //! Points are valid
+    int ret;                 //! Returned value
+    time_t limit;            //! Time to give up
+    int run;                 //! Loop valiant
+
+    nscan = aArgc > 1 ? atoi( appArgv[1] ) : 10;
+
+    //! Wave from 0 mm gives steps below dist_min
+    S2Sim_InitModel( &model );
+    model.param.revolution = 6000;
+    model.pattern = SCIP2_SIM_WAVE;
+    model.range = 0;
+    if( !S2Sim_OpenTcp( &sim, &model, 0 ) ){
+        fprintf( stderr, "ERROR: Failed to open TCP sensor.\n" );
+        return 0;
+    }
+    port = Scip2_OpenEthernet( "127.0.0.1", S2Sim_GetPort( &sim ) );
+    if( port == 0 ){
+        fprintf( stderr, "ERROR: Failed to open device.\n" );
+        return 0;
+    }
+    if( !Scip2CMD_PP( port, &param ) ){
+        fprintf( stderr, "ERROR: PP failed.\n" );
+        return 0;
+    }
+    pose.x = 100;
+    pose.y = -50;
+    pose.yaw = 0.3;
+    S2Sdd_Init( &buf );
+    S2Sdd_setPoints( &buf, &param, &pose );
+
+    ok = 1;
+    for( run = 0; run < NRUN && ok; run++ ){
+        Scip2_SetSimd( runs[run].simd );
+        S2Sdd_setStorage( &buf, runs[run].storage );
+        if( !Scip2CMD_StartMS( port, 44, 725, runs[run].group, 0, 0, &buf, runs[run].enc ) ){
+            fprintf( stderr, "ERROR: StartMS failed.\n" );
+            return 0;
+        }
+        count = 0;
+        limit = time( NULL ) + 10;
+        while( ok && count < nscan && time( NULL ) < limit ){
+            ret = S2Sdd_Begin( &buf, &data );
+            if( ret < 0 ){
+                fprintf( stderr, "NG: fatal error.\n" );
+                ok = 0;
+            }
+            else if( ret == 0 ){
+                S2Sdd_Wait( &buf, 100 );
+                continue;
+            }
+            if( data->nstep != ( 725 - 44 ) / runs[run].group + 1 || !data->x
+                || !check_points( data, &param, &pose ) )
+                ok = 0;
+            S2Sdd_End( &buf );
+            count++;
+        }
+        Scip2CMD_StopMS( port, &buf );
+        printf( "run %d: SIMD %d, %d scans recived\n", run, Scip2_GetSimd(  ), count );
+        if( count < nscan )
+            ok = 0;
+    }
+
+    S2Sdd_Dest( &buf );
+    Scip2_Close( port );
+    S2Sim_Close( &sim );
+
+    if( !ok ){
+        printf( "NG\n" );
+        return 0;
+    }
+    printf( "OK ( Cartesian points same as scalar conversion )\n" );
+    return 1;
+}
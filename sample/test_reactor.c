@@ -0,0 +1,115 @@
+/****************************************************************/
+/**
+  @file   test_reactor.c
+  @brief  Library for Sokuiki-Sensor "URG" test program
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "scip2hat.h"
+
+//! Number of simulated sensors serviced by one event loop
+#define NSENSOR 3
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief  Main function
+ * @param  aArgc Number of Arguments
+ * @param  appArgv Arguments
+ * @return failed: 0, succeeded: 1
+ * @attention Prints "OK" if every sensor delivered the scans in order through the event loop.
+ */
+/*--------------------------------------------------------------*/
+int main( int aArgc, char **appArgv )
+{
+    static S2Sim_t sim[NSENSOR];   //! Simulated sensors
+    static S2Sdd_t buf[NSENSOR];   //! Data recive buffers
+    S2Port *port[NSENSOR];         //! Device Ports
+    S2Reactor_t reactor;           //! Event loop servicing the sensors
+    S2SimModel_t model;            //! Model of the sensors
+    S2Scan_t *data;                //! Pointer to data buffer
+    unsigned long last[NSENSOR];   //! Sequence number of last scan
+    int count[NSENSOR];            //! Number of scans recived
+    int nscan;                     //! Number of scans to recive from each sensor
+    int done;                      //! Number of sensors which delivered nscan scans
+    int ok;                        //! Scans are valid
+    time_t limit;                  //! Time to give up
+    int i;                         //! Loop valiant
+
+    nscan = aArgc > 1 ? atoi( appArgv[1] ) : 20;
+
+    S2Sim_InitModel( &model );
+    model.param.revolution = 6000;
+    if( !S2Reactor_Init( &reactor ) ){
+        fprintf( stderr, "ERROR: Failed to start event loop.\n" );
+        return 0;
+    }
+    for( i = 0; i < NSENSOR; i++ ){
+        model.seed = i + 1;
+        if( !S2Sim_OpenTcp( &sim[i], &model, 0 ) ){
+            fprintf( stderr, "ERROR: Failed to open TCP sensor.\n" );
+            return 0;
+        }
+        port[i] = Scip2_OpenEthernet( "127.0.0.1", S2Sim_GetPort( &sim[i] ) );
+        if( port[i] == 0 ){
+            fprintf( stderr, "ERROR: Failed to open device.\n" );
+            return 0;
+        }
+        S2Sdd_Init( &buf[i] );
+        S2Sdd_setReactor( &buf[i], &reactor );
+        if( !Scip2CMD_StartMS( port[i], 0, 1080, 1, 0, 0, &buf[i], SCIP2_ENC_3BYTE ) ){
+            fprintf( stderr, "ERROR: StartMS failed.\n" );
+            return 0;
+        }
+        last[i] = 0;
+        count[i] = 0;
+    }
+
+    //! All sensors are recived by the thread of event loop
+    ok = 1;
+    done = 0;
+    limit = time( NULL ) + 10;
+    while( ok && done < NSENSOR && time( NULL ) < limit ){
+        for( i = 0; i < NSENSOR; i++ ){
+            if( count[i] >= nscan || S2Sdd_Wait( &buf[i], 10 ) == 0 )
+                continue;
+            if( S2Sdd_Begin( &buf[i], &data ) <= 0 ){
+                ok = 0;
+                break;
+            }
+            if( data->size != 1081 || data->seq <= last[i] ){
+                fprintf( stderr, "NG: sensor %d: %d steps, sequence %lu after %lu.\n",
+                         i, data->size, data->seq, last[i] );
+                ok = 0;
+            }
+            last[i] = data->seq;
+            S2Sdd_End( &buf[i] );
+            if( ++count[i] == nscan )
+                done++;
+        }
+    }
+
+    for( i = 0; i < NSENSOR; i++ ){
+        printf( "sensor %d: %d scans recived\n", i, count[i] );
+        Scip2CMD_StopMS( port[i], &buf[i] );
+        S2Sdd_Dest( &buf[i] );
+        Scip2_Close( port[i] );
+        S2Sim_Close( &sim[i] );
+    }
+    S2Reactor_Dest( &reactor );
+
+    if( !ok || done < NSENSOR ){
+        printf( "NG\n" );
+        return 0;
+    }
+    printf( "OK ( %d sensors by one event loop )\n", NSENSOR );
+    return 1;
+}
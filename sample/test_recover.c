@@ -0,0 +1,112 @@
+/****************************************************************/
+/**
+  @file   test_recover.c
+  @brief  Library for Sokuiki-Sensor "URG" test program
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "scip2hat.h"
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief  Main function
+ * @param  aArgc Number of Arguments
+ * @param  appArgv Arguments
+ * @return failed: 0, succeeded: 1
+ * @attention Prints "OK" if scanning goes on over frames broken by the simulator,
+ *            restarted by automatic recovery, and every scan picked up is whole.
+ */
+/*--------------------------------------------------------------*/
+int main( int aArgc, char **appArgv )
+{
+    S2Sim_t sim;             //! Simulated sensor
+    S2SimModel_t model;      //! Model of the sensor
+    S2Port *port;            //! Device Port
+    S2Sdd_t buf;             //! Data recive buffer
+    S2Scan_t *data;          //! Pointer to data buffer
+    unsigned long last;      //! Sequence number of last scan
+    int nscan;               //! Number of scans to recive
+    int count;               //! Number of scans recived
+    int ok;                  //! Scans are valid
+    int ret;                 //! Returned value
+    time_t limit;            //! Time to give up
+    int i;                   //! Loop valiant
+
+    nscan = aArgc > 1 ? atoi( appArgv[1] ) : 100;
+
+    //! One of 10 frames has broken echo back
+    S2Sim_InitModel( &model );
+    model.param.revolution = 6000;
+    model.glitch = 10;
+    if( !S2Sim_OpenTcp( &sim, &model, 0 ) ){
+        fprintf( stderr, "ERROR: Failed to open TCP sensor.\n" );
+        return 0;
+    }
+    port = Scip2_OpenEthernet( "127.0.0.1", S2Sim_GetPort( &sim ) );
+    if( port == 0 ){
+        fprintf( stderr, "ERROR: Failed to open device.\n" );
+        return 0;
+    }
+    S2Sdd_Init( &buf );
+    S2Sdd_setRecover( &buf, 1 );
+    if( !Scip2CMD_StartMS( port, 0, 1080, 1, 0, 0, &buf, SCIP2_ENC_3BYTE ) ){
+        fprintf( stderr, "ERROR: StartMS failed.\n" );
+        return 0;
+    }
+
+    ok = 1;
+    last = 0;
+    count = 0;
+    limit = time( NULL ) + 20;
+    while( ok && count < nscan && time( NULL ) < limit ){
+        ret = S2Sdd_Begin( &buf, &data );
+        if( ret < 0 ){
+            fprintf( stderr, "NG: fatal error.\n" );
+            ok = 0;
+        }
+        else if( ret == 0 ){
+            S2Sdd_Wait( &buf, 100 );
+            continue;
+        }
+        for( i = 1; i < data->size; i++ ){
+            if( data->data[i] != data->data[0] + 10 * i )
+                break;
+        }
+        if( data->size != 1081 || i < data->size || data->seq <= last ){
+            fprintf( stderr, "NG: %d steps, step %d broken, sequence %lu after %lu.\n",
+                     data->size, i, data->seq, last );
+            ok = 0;
+        }
+        last = data->seq;
+        S2Sdd_End( &buf );
+        count++;
+    }
+    Scip2CMD_StopMS( port, &buf );
+
+    printf( "%d scans recived, %ld frames broken, %d reconnects, last outage %ld ms\n",
+            count, S2Sim_GetGlitch( &sim ), S2Sdd_GetReconnect( &buf ), S2Sdd_GetOutage( &buf ) );
+    //! Each broken frame costs a restart, not the stream
+    if( count < nscan || S2Sim_GetGlitch( &sim ) == 0 || S2Sdd_GetReconnect( &buf ) == 0
+        || S2Sdd_GetOutage( &buf ) < 0 )
+        ok = 0;
+
+    S2Sdd_Dest( &buf );
+    Scip2_Close( port );
+    S2Sim_Close( &sim );
+
+    if( !ok ){
+        printf( "NG\n" );
+        return 0;
+    }
+    printf( "OK ( scanning recovered from broken frames )\n" );
+    return 1;
+}
@@ -0,0 +1,180 @@
+/****************************************************************/
+/**
+  @file   test_replay.c
+  @brief  Library for Sokuiki-Sensor "URG" test program
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "scip2hat.h"
+
+//! Maximum number of scans compared
+#define MAX_SCAN 99
+
+
+
+/** Scans recived in a session */
+typedef struct TEST_SESSION
+{
+	int count;
+	unsigned long time[MAX_SCAN];
+	unsigned long sum[MAX_SCAN];
+	struct timespec first;
+	struct timespec last;
+} TestSession_t;
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Keep time stamp and sum of data of the scan
+ * @param *aScan Pointer to scan
+ * @param *aUser Pointer to session
+ * @return 1
+ */
+/*--------------------------------------------------------------*/
+int callback( S2Scan_t * aScan, void *aUser )
+{
+    TestSession_t *s = ( TestSession_t * )aUser;   //! Session
+    int i;                                          //! Loop valiant
+
+    if( s->count >= MAX_SCAN )
+        return 1;
+    clock_gettime( CLOCK_MONOTONIC, s->count == 0 ? &s->first : &s->last );
+    s->time[s->count] = aScan->time;
+    s->sum[s->count] = aScan->size;
+    for( i = 0; i < aScan->size; i++ )
+        s->sum[s->count] = s->sum[s->count] * 31 + aScan->data[i];
+    __atomic_add_fetch( &s->count, 1, __ATOMIC_RELEASE );
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Recive scans by MS command
+ * @param *apPort Pointer to Device Port
+ * @param aNScan Number of scans
+ * @param *apSession Pointer to session
+ * @return failed: 0, succeeded: 1
+ */
+/*--------------------------------------------------------------*/
+int run_session( S2Port * apPort, int aNScan, TestSession_t * apSession )
+{
+    S2Sdd_t buf;        //! Data recive buffer
+    int tries;          //! Number of waits
+
+    apSession->count = 0;
+    S2Sdd_Init( &buf );
+    S2Sdd_setCallback( &buf, callback, apSession );
+    if( !Scip2CMD_StartMS( apPort, 0, 1080, 1, 0, aNScan, &buf, SCIP2_ENC_3BYTE ) ){
+        fprintf( stderr, "ERROR: StartMS failed.\n" );
+        return 0;
+    }
+    for( tries = 0; tries < 500 && __atomic_load_n( &apSession->count, __ATOMIC_ACQUIRE ) < aNScan; tries++ )
+        usleep( 10000 );
+    Scip2CMD_StopMS( apPort, &buf );
+    S2Sdd_Dest( &buf );
+    return apSession->count == aNScan;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief  Main function
+ * @param  aArgc Number of Arguments
+ * @param  appArgv Arguments
+ * @return failed: 0, succeeded: 1
+ * @attention Prints "OK" if scans replayed from recorded log, as fast as possible and
+ *            at original pacing, are the same as recorded scans of the simulator.
+ */
+/*--------------------------------------------------------------*/
+int main( int aArgc, char **appArgv )
+{
+    static TestSession_t s[3];                  //! Recorded, fast and real time sessions
+    S2Sim_t sim;                                //! Simulated sensor
+    S2SimModel_t model;                         //! Model of the sensor
+    S2Port *port;                               //! Device Port
+    char path[] = "/tmp/test_replay_XXXXXX";    //! Path of recorded log
+    double span[3];                             //! Time from first to last scan [s]
+    int nscan;                                  //! Number of scans to record
+    int fd;                                     //! File descriptor of log
+    int ok;                                     //! Scans are the same
+    int run;                                    //! Loop valiant
+    int i;                                      //! Loop valiant
+
+    nscan = aArgc > 1 ? atoi( appArgv[1] ) : 20;
+    if( nscan > MAX_SCAN )
+        nscan = MAX_SCAN;
+    fd = mkstemp( path );
+    if( fd < 0 ){
+        fprintf( stderr, "ERROR: Failed to create log.\n" );
+        return 0;
+    }
+    close( fd );
+
+    S2Sim_InitModel( &model );
+    model.param.revolution = 6000;
+    if( !S2Sim_OpenTcp( &sim, &model, 0 ) ){
+        fprintf( stderr, "ERROR: Failed to open TCP sensor.\n" );
+        return 0;
+    }
+
+    ok = 1;
+    for( run = 0; run < 3 && ok; run++ ){
+        if( run == 0 ){
+            port = Scip2_OpenEthernet( "127.0.0.1", S2Sim_GetPort( &sim ) );
+            if( port && !Scip2_StartRecord( port, path ) ){
+                Scip2_Close( port );
+                port = NULL;
+            }
+        }
+        else
+            port = Scip2_OpenReplay( path, run == 2 );
+        if( port == 0 ){
+            fprintf( stderr, "ERROR: Failed to open device.\n" );
+            ok = 0;
+            break;
+        }
+        //! Replay gets the same commands as recorded session to consume their replies
+        if( !run_session( port, nscan, &s[run] ) )
+            ok = 0;
+        if( run == 0 )
+            Scip2_StopRecord( port );
+        Scip2_Close( port );
+
+        span[run] = ( s[run].last.tv_sec - s[run].first.tv_sec )
+            + ( s[run].last.tv_nsec - s[run].first.tv_nsec ) * 1e-9;
+        printf( "%s: %d scans in %.3f s\n", run == 0 ? "recorded" : run == 1 ? "fast replay" : "real time replay",
+                s[run].count, span[run] );
+        for( i = 0; i < s[run].count && run > 0; i++ ){
+            if( s[run].time[i] != s[0].time[i] || s[run].sum[i] != s[0].sum[i] ){
+                fprintf( stderr, "NG: scan %d replayed at %lu is not recorded one at %lu.\n",
+                         i, s[run].time[i], s[0].time[i] );
+                ok = 0;
+            }
+        }
+    }
+    //! Original pacing is kept by real time replay only
+    if( ok && ( span[2] < span[0] * 0.8 || span[1] > span[0] * 0.5 ) )
+        ok = 0;
+
+    S2Sim_Close( &sim );
+    unlink( path );
+
+    if( !ok ){
+        printf( "NG\n" );
+        return 0;
+    }
+    printf( "OK ( recorded log replayed )\n" );
+    return 1;
+}
@@ -0,0 +1,154 @@
+/****************************************************************/
+/**
+  @file   test_ring.c
+  @brief  Library for Sokuiki-Sensor "URG" test program
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "scip2hat.h"
+
+
+
+/** Reader thread following broadcast ring */
+typedef struct TEST_READER
+{
+	S2Reader_t reader;
+	int nscan;
+	int delay;
+	int count;
+	unsigned long first;
+	int ok;
+	pthread_t thread;
+} TestReader_t;
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Read scans of broadcast ring in order
+ * @param *aArg Pointer to reader thread
+ * @return NULL
+ */
+/*--------------------------------------------------------------*/
+void *read_ring( void *aArg )
+{
+    TestReader_t *r = ( TestReader_t * )aArg;   //! Reader thread
+    S2Scan_t *data;                             //! Pointer to data buffer
+    unsigned long last;                         //! Sequence number of last scan
+    int ret;                                    //! Returned value
+    int tries;                                  //! Number of waits
+    int i;                                      //! Loop valiant
+
+    last = r->reader.seq;
+    for( tries = 0; r->count < r->nscan && tries < 1000; tries++ ){
+        if( S2Reader_Wait( &( r->reader ), 100 ) < 0 )
+            break;
+        while( r->count < r->nscan && ( ret = S2Reader_Next( &( r->reader ), &data ) ) > 0 ){
+            if( r->count == 0 )
+                r->first = data->seq;
+            //! Scan is held while it is read slowly
+            usleep( r->delay );
+            for( i = 1; i < data->size; i++ ){
+                if( data->data[i] != data->data[0] + 10 * i )
+                    break;
+            }
+            if( data->seq <= last || i < data->size || data->size != 1081 ){
+                fprintf( stderr, "NG: sequence %lu after %lu, step %d of %d broken.\n",
+                         data->seq, last, i, data->size );
+                r->ok = 0;
+            }
+            last = data->seq;
+            S2Reader_Release( &( r->reader ), data );
+            r->count++;
+        }
+    }
+    return NULL;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief  Main function
+ * @param  aArgc Number of Arguments
+ * @param  appArgv Arguments
+ * @return failed: 0, succeeded: 1
+ * @attention Prints "OK" if fast and slow readers of the ring both get whole scans
+ *            in order, and only the slow one skips scans.
+ */
+/*--------------------------------------------------------------*/
+int main( int aArgc, char **appArgv )
+{
+    S2Sim_t sim;             //! Simulated sensor
+    S2SimModel_t model;      //! Model of the sensor
+    S2Port *port;            //! Device Port
+    S2Sdd_t buf;             //! Data recive buffer
+    TestReader_t r[2];       //! Fast and slow readers
+    int nscan;               //! Number of scans to read
+    int ok;                  //! Readers succeeded
+    int i;                   //! Loop valiant
+
+    nscan = aArgc > 1 ? atoi( appArgv[1] ) : 40;
+
+    S2Sim_InitModel( &model );
+    model.param.revolution = 6000;
+    if( !S2Sim_OpenTcp( &sim, &model, 0 ) ){
+        fprintf( stderr, "ERROR: Failed to open TCP sensor.\n" );
+        return 0;
+    }
+    port = Scip2_OpenEthernet( "127.0.0.1", S2Sim_GetPort( &sim ) );
+    if( port == 0 ){
+        fprintf( stderr, "ERROR: Failed to open device.\n" );
+        return 0;
+    }
+    S2Sdd_Init( &buf );
+    S2Sdd_setRing( &buf, 4 );
+    //! One more buffer for each scan held by readers
+    S2Sdd_setPool( &buf, 4 + 3 + 2 );
+
+    for( i = 0; i < 2; i++ ){
+        S2Reader_Init( &( r[i].reader ), &buf );
+        r[i].nscan = i == 0 ? nscan : nscan / 4;
+        r[i].delay = i == 0 ? 0 : 50000;
+        r[i].count = 0;
+        r[i].first = 0;
+        r[i].ok = 1;
+        pthread_create( &( r[i].thread ), NULL, read_ring, &r[i] );
+    }
+    if( !Scip2CMD_StartMS( port, 0, 1080, 1, 0, 0, &buf, SCIP2_ENC_3BYTE ) ){
+        fprintf( stderr, "ERROR: StartMS failed.\n" );
+        return 0;
+    }
+    ok = 1;
+    for( i = 0; i < 2; i++ ){
+        pthread_join( r[i].thread, NULL );
+        printf( "reader %d: %d scans read from %lu, %lu skipped\n",
+                i, r[i].count, r[i].first, r[i].reader.skipped );
+        if( !r[i].ok || r[i].count < r[i].nscan )
+            ok = 0;
+    }
+    Scip2CMD_StopMS( port, &buf );
+
+    //! Slow reader holding a scan for 5 periods of sensor must lose some
+    if( r[1].reader.skipped == 0 || r[0].reader.skipped >= r[1].reader.skipped )
+        ok = 0;
+
+    S2Sdd_Dest( &buf );
+    Scip2_Close( port );
+    S2Sim_Close( &sim );
+
+    if( !ok ){
+        printf( "NG\n" );
+        return 0;
+    }
+    printf( "OK ( readers of broadcast ring in order )\n" );
+    return 1;
+}
@@ -0,0 +1,196 @@
+/****************************************************************/
+/**
+  @file   test_validity.c
+  @brief  Library for Sokuiki-Sensor "URG" test program
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "scip2hat.h"
+
+//! Number of runs of scanning
+#define NRUN 4
+
+
+
+/** Setting of a run of scanning */
+typedef struct TEST_RUN
+{
+	S2Simd simd;
+	int storage;
+	S2EncType enc;
+	int group;
+} TestRun_t;
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Compare validity mask of scan with steps classified one by one
+ * @param *apScan Pointer to scan
+ * @param aMin Minimum valid range
+ * @param aMax Maximum valid range
+ * @return different: 0, same: 1
+ */
+/*--------------------------------------------------------------*/
+int check_validity( S2Scan_t * apScan, unsigned long aMin, unsigned long aMax )
+{
+    int count[SCIP2_RANGE_NCLASS];   //! Counts of invalid steps par class
+    unsigned long r;                 //! Range of step [mm]
+    int nvalid;                      //! Number of valid steps
+    int stride;                      //! Number of values par step
+    int valid;                       //! Step is valid
+    int i;                           //! Loop valiant
+
+    stride = apScan->enc == SCIP2_ENC_3X2BYTE ? 2 : 1;
+    for( i = 0; i < SCIP2_RANGE_NCLASS; i++ )
+        count[i] = 0;
+    for( i = 0; i < apScan->nstep; i++ ){
+        r = S2Scan_Value( apScan, i * stride );
+        valid = 0;
+        if( r == 0 )
+            count[SCIP2_RANGE_ZERO]++;
+        else if( r < aMin )
+            count[SCIP2_RANGE_CODE]++;
+        else if( r > aMax )
+            count[SCIP2_RANGE_FAR]++;
+        else
+            valid = 1;
+        if( S2Scan_IsValid( apScan, i ) != valid ){
+            fprintf( stderr, "NG: step %d of range %lu is %s.\n", i, r, valid ? "invalid" : "valid" );
+            return 0;
+        }
+    }
+    //! Bits after last step are cleared
+    for( ; i < SCIP2_MASK_WORDS( apScan->nstep ) * 64; i++ ){
+        if( S2Scan_IsValid( apScan, i ) ){
+            fprintf( stderr, "NG: bit %d after %d steps is set.\n", i, apScan->nstep );
+            return 0;
+        }
+    }
+    nvalid = apScan->nstep - count[SCIP2_RANGE_ZERO] - count[SCIP2_RANGE_CODE] - count[SCIP2_RANGE_FAR];
+    if( apScan->nvalid != nvalid || apScan->ninvalid[SCIP2_RANGE_ZERO] != count[SCIP2_RANGE_ZERO]
+        || apScan->ninvalid[SCIP2_RANGE_CODE] != count[SCIP2_RANGE_CODE]
+        || apScan->ninvalid[SCIP2_RANGE_FAR] != count[SCIP2_RANGE_FAR] ){
+        fprintf( stderr, "NG: %d valid, %d zero, %d code and %d far steps for %d, %d, %d and %d.\n",
+                 apScan->nvalid, apScan->ninvalid[SCIP2_RANGE_ZERO], apScan->ninvalid[SCIP2_RANGE_CODE],
+                 apScan->ninvalid[SCIP2_RANGE_FAR], nvalid, count[SCIP2_RANGE_ZERO],
+                 count[SCIP2_RANGE_CODE], count[SCIP2_RANGE_FAR] );
+        return 0;
+    }
+    //! Every class is in the scan
+    if( nvalid == 0 || count[SCIP2_RANGE_ZERO] == 0 || count[SCIP2_RANGE_CODE] == 0 || count[SCIP2_RANGE_FAR] == 0 ){
+        fprintf( stderr, "NG: scan of %d steps lacks a class.\n", apScan->nstep );
+        return 0;
+    }
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief  Main function
+ * @param  aArgc Number of Arguments
+ * @param  appArgv Arguments
+ * @return failed: 0, succeeded: 1
+ * @attention Prints "OK" if validity mask and counts of invalid steps made by reciver are
+ *            the same as steps classified one by one, over SIMD instruction sets, storage modes
+ *            and groups.
+ */
+/*--------------------------------------------------------------*/
+int main( int aArgc, char **appArgv )
+{
+    static const TestRun_t runs[NRUN] = {
+        { SCIP2_SIMD_NONE, SCIP2_STORE_ULONG, SCIP2_ENC_3BYTE, 1 },
+        { SCIP2_SIMD_SSE2, SCIP2_STORE_COMPACT, SCIP2_ENC_2BYTE, 1 },
+        { SCIP2_SIMD_AVX2, SCIP2_STORE_COMPACT, SCIP2_ENC_3BYTE, 3 },
+        { SCIP2_SIMD_AVX2, SCIP2_STORE_COMPACT, SCIP2_ENC_3X2BYTE, 2 }
+    };                       //! Settings of runs
+    S2Sim_t sim;             //! Simulated sensor
+    S2SimModel_t model;      //! Model of the sensor
+    S2Port *port;            //! Device Port
+    S2Sdd_t buf;             //! Data recive buffer
+    S2Scan_t *data;          //! Pointer to data buffer
+    S2Param_t param;         //! Parameters of sensor
+    int nscan;               //! Number of scans to recive par run
+    int count;               //! Number of scans recived
+    int ok;                  //! Validity masks are valid
+    int ret;                 //! Returned value
+    time_t limit;            //! Time to give up
+    int run;                 //! Loop valiant
+
+    nscan = aArgc > 1 ? atoi( appArgv[1] ) : 10;
+
+    //! Wave from 0 mm to 1000 mm gives steps of 0 and below dist_min
+    S2Sim_InitModel( &model );
+    model.param.revolution = 6000;
+    model.pattern = SCIP2_SIM_WAVE;
+    model.range = 0;
+    if( !S2Sim_OpenTcp( &sim, &model, 0 ) ){
+        fprintf( stderr, "ERROR: Failed to open TCP sensor.\n" );
+        return 0;
+    }
+    port = Scip2_OpenEthernet( "127.0.0.1", S2Sim_GetPort( &sim ) );
+    if( port == 0 ){
+        fprintf( stderr, "ERROR: Failed to open device.\n" );
+        return 0;
+    }
+    if( !Scip2CMD_PP( port, &param ) ){
+        fprintf( stderr, "ERROR: PP failed.\n" );
+        return 0;
+    }
+    //! Steps beyond 600 mm are far
+    param.dist_max = 600;
+    S2Sdd_Init( &buf );
+    S2Sdd_setValidity( &buf, &param );
+
+    ok = 1;
+    for( run = 0; run < NRUN && ok; run++ ){
+        Scip2_SetSimd( runs[run].simd );
+        S2Sdd_setStorage( &buf, runs[run].storage );
+        if( !Scip2CMD_StartMS( port, 44, 725, runs[run].group, 0, 0, &buf, runs[run].enc ) ){
+            fprintf( stderr, "ERROR: StartMS failed.\n" );
+            return 0;
+        }
+        count = 0;
+        limit = time( NULL ) + 10;
+        while( ok && count < nscan && time( NULL ) < limit ){
+            ret = S2Sdd_Begin( &buf, &data );
+            if( ret < 0 ){
+                fprintf( stderr, "NG: fatal error.\n" );
+                ok = 0;
+            }
+            else if( ret == 0 ){
+                S2Sdd_Wait( &buf, 100 );
+                continue;
+            }
+            if( data->nstep != ( 725 - 44 ) / runs[run].group + 1 || !data->valid
+                || !check_validity( data, param.dist_min, param.dist_max ) )
+                ok = 0;
+            S2Sdd_End( &buf );
+            count++;
+        }
+        Scip2CMD_StopMS( port, &buf );
+        printf( "run %d: SIMD %d, %d scans recived\n", run, Scip2_GetSimd(  ), count );
+        if( count < nscan )
+            ok = 0;
+    }
+
+    S2Sdd_Dest( &buf );
+    Scip2_Close( port );
+    S2Sim_Close( &sim );
+
+    if( !ok ){
+        printf( "NG\n" );
+        return 0;
+    }
+    printf( "OK ( validity mask same as scalar classification )\n" );
+    return 1;
+}
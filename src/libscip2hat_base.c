@@ -13,8 +13,14 @@
 #include <string.h>
 #include <unistd.h>
 #include <signal.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
 #include <sys/time.h>
 #include <sys/file.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
 
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -74,11 +80,11 @@ int bitrate2i( const speed_t acBitrate )
 /*--------------------------------------------------------------*/
 int Scip2_SendTerm( S2Port * apPort )
 {
-    //! return value of fwrite
-    size_t ret;
+    //! return value of write
+    int ret;
 
-    ret = fwrite( "\n", 1, sizeof ( char ), apPort );
-    if( ret == 0 )
+    ret = Scip2_Write( apPort, "\n", 1 );
+    if( ret <= 0 )
         return 0;
 
     return 1;
@@ -86,6 +92,251 @@ int Scip2_SendTerm( S2Port * apPort )
 
 
 
+/*--------------------------------------------------------------*/
+/**
+ * @brief Write raw bytes to port
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *apcBuf Pointer to bytes to write
+ * @param aNBuf Number of bytes
+ * @return failed: -1, succeeded: number of written bytes
+ */
+/*--------------------------------------------------------------*/
+int Scip2_Write( S2Port * apPort, const char *apcBuf, int aNBuf )
+{
+    //! return value of write
+    ssize_t ret;
+    //! Number of written bytes
+    int n;
+
+    for ( n = 0; n < aNBuf; n += ret )
+    {
+        ret = apPort->transport->write( apPort, apcBuf + n, aNBuf - n );
+        if( ret < 0 && errno == EINTR )
+        {
+            ret = 0;
+            continue;
+        }
+        if( ret <= 0 )
+            return -1;
+    }
+
+    return n;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Read bytes available on device into ring buffer
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @return error: -1, timed out, woken up or closed: 0, succeeded: number of read bytes
+ * @attention Returns 0 at once while the port is woken up by Scip2_Wake.
+ */
+/*--------------------------------------------------------------*/
+int Scip2_Fill( S2Port * apPort )
+{
+    //! Number of buffered bytes
+    int buffered;
+    //! Device and wake up pipe to wait
+    struct pollfd fds[2];
+    //! return value of read
+    ssize_t ret;
+
+    //! Recycle ring buffer when the rest of it is too short for a line
+    buffered = apPort->tail - apPort->head;
+    if( SCIP2_RECV_BUFSIZE - apPort->tail < SCIP2_MAX_LENGTH || buffered == 0 )
+    {
+        memmove( apPort->ring, apPort->ring + apPort->head, buffered );
+        apPort->head = 0;
+        apPort->tail = buffered;
+    }
+
+    //! Wait for device or wake up ( device without fd is always ready )
+    fds[0].fd = apPort->fd;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = apPort->wake[0];
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+    do
+    {
+        if( apPort->fd < 0 )
+            ret = poll( fds + 1, 1, 0 );
+        else
+            ret = poll( fds, 2, apPort->timeout );
+    }
+    while( ret < 0 && errno == EINTR );
+    if( ret < 0 || ( ret == 0 && apPort->fd >= 0 ) )
+        return ret;
+    //! Wake up is kept until Scip2_ClearWake
+    if( fds[1].revents & POLLIN )
+        return 0;
+
+    do
+    {
+        ret = apPort->transport->read( apPort, apPort->ring + apPort->tail, SCIP2_RECV_BUFSIZE - apPort->tail );
+    }
+    while( ret < 0 && errno == EINTR );
+    if( ret > 0 )
+    {
+        if( apPort->record )
+            Scip2_Record( apPort, apPort->ring + apPort->tail, ret );
+        apPort->tail += ret;
+    }
+
+    return ret;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Wake up thread waiting for receive on the port
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @return failed: 0, succeeded: 1
+ * @attention Receive on the port fails at once until Scip2_ClearWake is called.
+ */
+/*--------------------------------------------------------------*/
+int Scip2_Wake( S2Port * apPort )
+{
+#ifdef __linux__
+    //! Value to add to eventfd
+    uint64_t one = 1;
+
+    return write( apPort->wake[1], &one, sizeof ( one ) ) == sizeof ( one );
+#else
+    //! Byte to write to pipe
+    char one = 1;
+
+    return write( apPort->wake[1], &one, 1 ) == 1;
+#endif											/* __linux__ */
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Clear wake up of the port
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ */
+/*--------------------------------------------------------------*/
+void Scip2_ClearWake( S2Port * apPort )
+{
+    //! Bytes read from pipe
+    char buf[16];
+
+    while( read( apPort->wake[0], buf, sizeof ( buf ) ) > 0 );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Take one line already in ring buffer ( Non-Blocking )
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *apLen Length of the line including LF terminater
+ * @return no complete line: NULL, succeeded: Pointer to the line in ring buffer
+ * @attention Returned line is not null terminated and valid until next receive.
+ */
+/*--------------------------------------------------------------*/
+char *Scip2_PollLine( S2Port * apPort, int *apLen )
+{
+    //! Head of the line
+    char *line;
+    //! Terminater of the line
+    char *term;
+    //! Number of buffered bytes
+    int buffered;
+
+    line = apPort->ring + apPort->head;
+    buffered = apPort->tail - apPort->head;
+    term = memchr( line, '\n', buffered );
+    if( term )
+    {
+        *apLen = term - line + 1;
+        apPort->head += *apLen;
+        return line;
+    }
+    if( buffered >= SCIP2_MAX_LENGTH - 1 )
+    {
+        //! Too long line is split as fgets does
+        *apLen = SCIP2_MAX_LENGTH - 1;
+        apPort->head += *apLen;
+        return line;
+    }
+
+    return NULL;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Recieve one line in place
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *apLen Length of the line including LF terminater
+ * @return failed: NULL, succeeded: Pointer to the line in ring buffer
+ * @attention Returned line is not null terminated and valid until next receive.
+ *            Line without LF is returned when device is timed out.
+ */
+/*--------------------------------------------------------------*/
+char *Scip2_RecvLine( S2Port * apPort, int *apLen )
+{
+    //! Head of the line
+    char *line;
+
+    while( ( line = Scip2_PollLine( apPort, apLen ) ) == NULL )
+    {
+        if( Scip2_Fill( apPort ) <= 0 )
+        {
+            if( apPort->tail == apPort->head )
+                return NULL;
+            //! Timed out: return partial line
+            line = apPort->ring + apPort->head;
+            *apLen = apPort->tail - apPort->head;
+            apPort->head = apPort->tail;
+            return line;
+        }
+    }
+
+    return line;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Recieve one line
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *apMes Pointer to Buffer ( null terminated, LF is kept )
+ * @param aNMes Size of Buffer
+ * @return failed: 0, succeeded: length of recived line
+ */
+/*--------------------------------------------------------------*/
+int Scip2_Recv( S2Port * apPort, char *apMes, int aNMes )
+{
+    //! Pointer to the line
+    char *line;
+    //! Length of the line
+    int len;
+
+    line = Scip2_RecvLine( apPort, &len );
+    if( line == NULL )
+        return 0;
+    if( len > aNMes - 1 )
+    {
+        //! Leave rest of the line in ring buffer
+        apPort->head -= len - ( aNMes - 1 );
+        len = aNMes - 1;
+    }
+    memcpy( apMes, line, len );
+    apMes[len] = 0;
+
+    return len;
+}
+
+
+
 /*--------------------------------------------------------------*/
 /**
  * @brief Recive Terminal Charactor
@@ -95,13 +346,13 @@ int Scip2_SendTerm( S2Port * apPort )
 /*--------------------------------------------------------------*/
 int Scip2_RecvTerm( S2Port * apPort )
 {
-    //! return value of fget
-    void *ret;
-    //! Recive Buffer
-    char buf[SCIP2_MAX_LENGTH] = "\0";
+    //! Pointer to the line
+    char *line;
+    //! Length of the line
+    int len;
 
-    ret = fgets( buf, SCIP2_MAX_LENGTH, apPort );
-    if( ret == NULL || buf[0] != '\n' ){
+    line = Scip2_RecvLine( apPort, &len );
+    if( line == NULL || line[0] != '\n' ){
 #ifdef SCIP2_DEBUG
         fprintf( stderr, "SCIP2 ERROR: Failed to read terminal character.\n" );
         fflush( stderr );
@@ -118,24 +369,17 @@ int Scip2_RecvTerm( S2Port * apPort )
 /**
  * @brief Recieve SCIP2.0 Status value
  * @param *apPort Pointer to SCIP2.0 Device Port
- * @return ERROR: -1, SUCCESS: Status Value
+ * @return ERROR: -1, SUCCESS: Status Value ( negative for non-numeric status, e.g. update mode )
  */
 /*--------------------------------------------------------------*/
 int Scip2_RecvStatus( S2Port * apPort )
 {
-    //! return value of fgets
-    void *ret2;
     //! return value of function
     int s_ret;
     //! Recive Buffer
     char buf[SCIP2_MAX_LENGTH] = "\0";
-#ifdef SCIP2_ENABLE_CHECKSUM
-    //! Checksum
-    char sum;
-#endif											/* SCIP2_ENABLE_CHECKSUM */
 
-    ret2 = fgets( buf, SCIP2_MAX_LENGTH, apPort );
-    if( ret2 == NULL )
+    if( Scip2_Recv( apPort, buf, SCIP2_MAX_LENGTH ) == 0 )
     {
 #ifdef SCIP2_DEBUG
         fprintf( stderr, "SCIP2 ERROR: Failed to read status.\n" );
@@ -168,16 +412,14 @@ int Scip2_RecvStatus( S2Port * apPort )
         }
         if( s_ret < -( '0' * 0x100 + 'I' ) )
         {
-            fprintf( stderr, "SCIP2 FATAL ERROR: Sensor is update mode (%d).\n", s_ret );
+#ifdef SCIP2_DEBUG
+            fprintf( stderr, "SCIP2 ERROR: Sensor is update mode (%d).\n", s_ret );
             fflush( stderr );
-            Scip2_Flush( apPort );
-            Scip2CMD_RS( apPort );
-            exit( 1 );
+#endif											/* SCIP2_DEBUG */
+            return s_ret;
         }
     }
-#ifdef SCIP2_ENABLE_CHECKSUM
-    sum = ( buf[0] + buf[1] ) & 0x3F + 0x30;
-    if( sum != buf[2] )
+    if( apPort->checksum && !Scip2_CheckSum( buf, 3 ) )
     {
 #ifdef SCIP2_DEBUG
         fprintf( stderr, "SCIP2 ERROR: Checksum mismatch.\n" );
@@ -185,7 +427,6 @@ int Scip2_RecvStatus( S2Port * apPort )
 #endif											/* SCIP2_DEBUG */
         return -1;
     }
-#endif											/* SCIP2_ENABLE_CHECKSUM */
 
     return s_ret;
 }
@@ -194,30 +435,29 @@ int Scip2_RecvStatus( S2Port * apPort )
 
 /*--------------------------------------------------------------*/
 /**
- * @brief Send SCIP2.0 Message
+ * @brief Send SCIP2.0 Message without reading its reply
  * @param *apPort Pointer to SCIP2.0 Device Port
  * @param *apcMes Pointer to SCIP2.0 Message( without LF terminater )
- * @return error: -1, otherwise: return value of device
+ * @return failed: -1, succeeded: 0
  */
 /*--------------------------------------------------------------*/
-int Scip2_Send( S2Port * apPort, const char *apcMes )
+int Scip2_SendNoWait( S2Port * apPort, const char *apcMes )
 {
-    //! return value of fwrite
-    size_t ret;
-    //! return value of fgets
-    void *ret2;
-    //! return value of function
-    int s_ret;
-    //! Recive Buffer
-    char buf[SCIP2_MAX_LENGTH] = "\0";
-    //! Strtok save ptr
-    char *ptr;
+    //! Length of message
+    int len;
+    //! Send Buffer
+    char buf[SCIP2_MAX_LENGTH];
 
 #ifdef SCIP2_DEBUG_ALL
     fprintf( stderr, "H:%s\n", apcMes );
 #endif											/* SCIP2_DEBUG_ALL */
-    ret = fwrite( apcMes, strlen( apcMes ), sizeof ( char ), apPort );
-    if( Scip2_SendTerm( apPort ) == 0 )
+    //! Send message and terminater at once
+    len = strlen( apcMes );
+    if( len > SCIP2_MAX_LENGTH - 2 )
+        len = SCIP2_MAX_LENGTH - 2;
+    memcpy( buf, apcMes, len );
+    buf[len] = '\n';
+    if( Scip2_Write( apPort, buf, len + 1 ) <= 0 )
     {
 #ifdef SCIP2_DEBUG
         fprintf( stderr, "SCIP2 ERROR: Failed to send message.\n" );
@@ -225,18 +465,33 @@ int Scip2_Send( S2Port * apPort, const char *apcMes )
 #endif											/* SCIP2_DEBUG */
         return -1;
     }
-    if( ret == 0 )
-    {
-#ifdef SCIP2_DEBUG
-        fprintf( stderr, "SCIP2 ERROR: Failed to send message.\n" );
-        fflush( stderr );
-#endif											/* SCIP2_DEBUG */
+    return 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Send SCIP2.0 Message
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *apcMes Pointer to SCIP2.0 Message( without LF terminater )
+ * @return error: -1, otherwise: return value of device
+ */
+/*--------------------------------------------------------------*/
+int Scip2_Send( S2Port * apPort, const char *apcMes )
+{
+    //! return value of function
+    int s_ret;
+    //! Recive Buffer
+    char buf[SCIP2_MAX_LENGTH] = "\0";
+    //! Strtok save ptr
+    char *ptr;
+
+    if( Scip2_SendNoWait( apPort, apcMes ) != 0 )
         return -1;
-    }
 
     buf[0] = 0;
-    ret2 = fgets( buf, SCIP2_MAX_LENGTH, apPort );
-    if( ret2 == NULL )
+    if( Scip2_Recv( apPort, buf, SCIP2_MAX_LENGTH ) == 0 )
     {
 #ifdef SCIP2_DEBUG
         fprintf( stderr, "SCIP2 ERROR: Failed to read echo back message.\n" );
@@ -264,6 +519,44 @@ int Scip2_Send( S2Port * apPort, const char *apcMes )
     return s_ret;
 }
 
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Recive echo back of SCIP2.0 Message sent by Scip2_SendNoWait
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *apcMes Pointer to SCIP2.0 Message( without LF terminater )
+ * @return error: -1, otherwise: return value of device
+ * @attention Lines before the echo back ( e.g. rest of the reply to
+ *            an earlier message ) are discarded.
+ */
+/*--------------------------------------------------------------*/
+int Scip2_RecvEcho( S2Port * apPort, const char *apcMes )
+{
+    //! Pointer to the line in ring buffer of port
+    char *line;
+    //! Length of the line
+    int len;
+    //! Length of message
+    int meslen;
+
+    meslen = strlen( apcMes );
+    while( ( line = Scip2_RecvLine( apPort, &len ) ) != NULL )
+    {
+#ifdef SCIP2_DEBUG_ALL
+        fprintf( stderr, "D:%.*s", len, line );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG_ALL */
+        if( len == meslen + 1 && line[meslen] == '\n' && memcmp( line, apcMes, meslen ) == 0 )
+            return Scip2_RecvStatus( apPort );
+    }
+#ifdef SCIP2_DEBUG
+    fprintf( stderr, "SCIP2 ERROR: Failed to read echo back message.\n" );
+    fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+    return -1;
+}
+
 #if defined(SCIP2_DEBUG_ALL) || defined(SCIP2_OUTPUT_CONTDATA)
 char scip2_debuf[SCIP2_MAX_LENGTH];
 #endif
@@ -272,90 +565,278 @@ char scip2_debuf[SCIP2_MAX_LENGTH];
 
 /*--------------------------------------------------------------*/
 /**
- * @brief Recive encoded data
- * @param *apPort Pointer to SCIP2.0 Device Port
+ * @brief Decode one encoded line into values of given type
+ * @param *apLine Pointer to the line ( LF terminated )
+ * @param aLen Length of the line including LF
  * @param *apBuf Pointer to Buffer
+ * @param acType Type of decoded value
  * @param *aNBuf Size of Buffer
  * @param acEnc Encode type
  * @param *apRemains Remaining value
  * @param *apNRemains Number of remaining bytes
- * @return failed: -1, succeeded: size of recived data
+ * @param *apNBadSum Number of lines with bad checksum, counted up on mismatch ( NULL: not validated )
+ * @return buffer over flow: -1, broken line: -2, end of data: 0,
+ *         succeeded: size of decoded data
+ * @attention Line with bad checksum is decoded as it is.
  */
 /*--------------------------------------------------------------*/
 int
-Scip2_RecvEncodedLine( S2Port * apPort, unsigned long *apBuf, int aNBuf,
-                       const S2EncType acEnc, unsigned long *apRemains, int *apNRemains )
+Scip2_DecodeLineSum( const char *apLine, int aLen, void *apBuf, const S2ValType acType, int aNBuf,
+                     const S2EncType acEnc, unsigned long *apRemains, int *apNRemains, int *apNBadSum )
 {
     //! Scanning Pointer
-    char *pos;
-    //! Recive Buffer
-    char buf[SCIP2_MAX_LENGTH];
+    const char *pos;
+    //! End of encoded data
+    const char *end;
     //! General
     int i, j;
+    //! Number of whole values in the line
+    int n;
     //! Decoded data
     unsigned long value;
     //! Decode mask
     unsigned long mask;
-#ifdef SCIP2_ENABLE_CHECKSUM
-    //! Check sum
-    unsigned int sum = 0;
-#endif											/* SCIP2_ENABLE_CHECKSUM */
 
     mask = 0xFFFFFFFF >> ( 32 - acEnc * 6 );
 
-    if( fgets( buf, sizeof ( buf ), apPort ) == NULL )
-        return -1;
     j = 0;
     i = *apNRemains;
     value = *apRemains;
 
 #if defined(SCIP2_DEBUG_ALL) || defined(SCIP2_OUTPUT_CONTDATA)
-    memcpy( scip2_debuf, buf, strlen( buf ) );
-    scip2_debuf[strlen( buf )] = 0;
+    memcpy( scip2_debuf, apLine, aLen );
+    scip2_debuf[aLen] = 0;
 #endif
-    if( buf[0] == '\n' )
+    if( apLine[0] == '\n' )
         return 0;
-    if( strlen( buf ) < 2 )
+    if( aLen < 2 || apLine[aLen - 1] != '\n' )
     {
         return -2;
     }
 
-    for ( pos = buf; ( *( pos + 1 ) != '\n' ) && ( *pos ); pos++ )
+    //! Line is still in cache while decoding it
+    if( apNBadSum && !Scip2_CheckSum( apLine, aLen - 1 ) )
+        ( *apNBadSum )++;
+
+    //! Decode in place, last character before LF is checksum
+    end = apLine + aLen - 2;
+    pos = apLine;
+
+    //! Complete the value carried over from previous line
+    if( i > 0 )
     {
-        value = value << 6;
-        value |= ( *pos - 0x30 );
-#ifdef SCIP2_ENABLE_CHECKSUM
-        sum += *pos;
-#endif											/* SCIP2_ENABLE_CHECKSUM */
-        i++;
+        for ( ; i < acEnc && pos < end; i++, pos++ )
+            value = ( value << 6 ) | ( *pos - 0x30 );
         if( i == acEnc )
         {
-            i = 0;
-            apBuf[j] = value & mask;
-            j++;
-            if( j > aNBuf )
+            if( aNBuf < 1 )
             {
 #ifdef SCIP2_DEBUG
                 fprintf( stderr, "SCIP2 ERROR: Recive buffer over flow.\n" );
                 fflush( stderr );
 #endif											/* SCIP2_DEBUG */
-                Scip2_SendTerm( apPort );
                 return -1;
             }
+            switch ( acType )
+            {
+            case SCIP2_VAL_UINT16:
+                *( uint16_t * ) apBuf = ( uint16_t ) ( value & mask );
+                break;
+            case SCIP2_VAL_UINT32:
+                *( uint32_t * ) apBuf = ( uint32_t ) ( value & mask );
+                break;
+            default:
+                *( unsigned long * )apBuf = value & mask;
+                break;
+            }
+            j++;
+            i = 0;
+            value = 0;
         }
     }
+
+    //! Decode whole values at once
+    n = ( end - pos ) / acEnc;
+    if( n > aNBuf - j )
+    {
+#ifdef SCIP2_DEBUG
+        fprintf( stderr, "SCIP2 ERROR: Recive buffer over flow.\n" );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+        return -1;
+    }
+    j += Scip2_DecodeBlock( pos, n, ( char * )apBuf + j * Scip2_ValSize( acType ), acType, acEnc );
+    pos += n * acEnc;
+
+    //! Keep the rest for next line
+    for ( ; pos < end; pos++, i++ )
+        value = ( value << 6 ) | ( *pos - 0x30 );
     *apNRemains = i;
     *apRemains = value;
 
-#ifdef SCIP2_ENABLE_CHECKSUM
-    sum = sum & 0x3F + 0x30;
-    pos--;
-    if( sum != *pos )
+    return j;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Decode one encoded line into values of given type
+ * @param *apLine Pointer to the line ( LF terminated )
+ * @param aLen Length of the line including LF
+ * @param *apBuf Pointer to Buffer
+ * @param acType Type of decoded value
+ * @param *aNBuf Size of Buffer
+ * @param acEnc Encode type
+ * @param *apRemains Remaining value
+ * @param *apNRemains Number of remaining bytes
+ * @return buffer over flow: -1, broken line: -2, end of data: 0,
+ *         succeeded: size of decoded data
+ */
+/*--------------------------------------------------------------*/
+int
+Scip2_DecodeLineAs( const char *apLine, int aLen, void *apBuf, const S2ValType acType, int aNBuf,
+                    const S2EncType acEnc, unsigned long *apRemains, int *apNRemains )
+{
+    return Scip2_DecodeLineSum( apLine, aLen, apBuf, acType, aNBuf, acEnc, apRemains, apNRemains, NULL );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Validate checksum of one line
+ * @param *apLine Pointer to the line
+ * @param aLen Length of the line including checksum, excluding LF
+ * @return mismatch: 0, valid: 1
+ * @attention Sum is a plain loop over bytes, which compiler vectorizes.
+ */
+/*--------------------------------------------------------------*/
+int Scip2_CheckSum( const char *apLine, int aLen )
+{
+    //! Bytes of the line
+    const unsigned char *pos;
+    //! Sum of bytes
+    unsigned int sum;
+    //! Loop valiant
+    int i;
+
+    if( aLen < 2 )
+        return 0;
+    pos = ( const unsigned char * )apLine;
+    sum = 0;
+    for ( i = 0; i < aLen - 1; i++ )
+        sum += pos[i];
+    return ( ( sum & 0x3F ) + 0x30 ) == pos[aLen - 1];
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Enable checksum validation of lines recived by the port
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param aEnable Enable: 1, Disable: 0.
+ *        Status with bad checksum is error.
+ *        Data line with bad checksum is decoded and counted in nbadsum of the scan.
+ *        Default is enabled if built with SCIP2_ENABLE_CHECKSUM.
+ */
+/*--------------------------------------------------------------*/
+void Scip2_SetChecksum( S2Port * apPort, int aEnable )
+{
+    apPort->checksum = aEnable;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Decode one encoded line
+ * @param *apLine Pointer to the line ( LF terminated )
+ * @param aLen Length of the line including LF
+ * @param *apBuf Pointer to Buffer
+ * @param *aNBuf Size of Buffer
+ * @param acEnc Encode type
+ * @param *apRemains Remaining value
+ * @param *apNRemains Number of remaining bytes
+ * @return buffer over flow: -1, broken line: -2, end of data: 0,
+ *         succeeded: size of decoded data
+ */
+/*--------------------------------------------------------------*/
+int
+Scip2_DecodeLine( const char *apLine, int aLen, unsigned long *apBuf, int aNBuf,
+                  const S2EncType acEnc, unsigned long *apRemains, int *apNRemains )
+{
+    return Scip2_DecodeLineAs( apLine, aLen, apBuf, SCIP2_VAL_ULONG, aNBuf, acEnc, apRemains, apNRemains );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Recive encoded data into values of given type
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *apBuf Pointer to Buffer
+ * @param acType Type of decoded value
+ * @param *aNBuf Size of Buffer
+ * @param acEnc Encode type
+ * @param *apRemains Remaining value
+ * @param *apNRemains Number of remaining bytes
+ * @return failed: -1, succeeded: size of recived data
+ */
+/*--------------------------------------------------------------*/
+int
+Scip2_RecvEncodedLineAs( S2Port * apPort, void *apBuf, const S2ValType acType, int aNBuf,
+                         const S2EncType acEnc, unsigned long *apRemains, int *apNRemains )
+{
+    //! Pointer to the line
+    char *buf;
+    //! Length of the line
+    int len;
+    //! Returned value
+    int ret;
+    //! Number of lines with bad checksum
+    int nbadsum;
+
+    buf = Scip2_RecvLine( apPort, &len );
+    if( buf == NULL )
+        return -1;
+
+    nbadsum = 0;
+    ret = Scip2_DecodeLineSum( buf, len, apBuf, acType, aNBuf, acEnc, apRemains, apNRemains,
+                               apPort->checksum ? &nbadsum : NULL );
+    if( ret == -1 )
+        Scip2_SendTerm( apPort );
+#ifdef SCIP2_DEBUG
+    if( nbadsum )
+    {
         fprintf( stderr, "SCIP2 ERROR: Checksum mismatch.\n" );
-    fflush( stderr );
-#endif											/* SCIP2_ENABLE_CHECKSUM */
+        fflush( stderr );
+    }
+#endif											/* SCIP2_DEBUG */
 
-    return j;
+    return ret;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Recive encoded data
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *apBuf Pointer to Buffer
+ * @param *aNBuf Size of Buffer
+ * @param acEnc Encode type
+ * @param *apRemains Remaining value
+ * @param *apNRemains Number of remaining bytes
+ * @return failed: -1, succeeded: size of recived data
+ */
+/*--------------------------------------------------------------*/
+int
+Scip2_RecvEncodedLine( S2Port * apPort, unsigned long *apBuf, int aNBuf,
+                       const S2EncType acEnc, unsigned long *apRemains, int *apNRemains )
+{
+    return Scip2_RecvEncodedLineAs( apPort, apBuf, SCIP2_VAL_ULONG, aNBuf, acEnc, apRemains, apNRemains );
 }
 
 
@@ -369,18 +850,16 @@ Scip2_RecvEncodedLine( S2Port * apPort, unsigned long *apBuf, int aNBuf,
 /*--------------------------------------------------------------*/
 void Scip2_Flush( S2Port * apPort )
 {
-    //! File number of Port
-    int fn;
-
-    fn = fileno( apPort );
-
     //! Flash Input/Output Buffer
-    tcflush( fn, TCIFLUSH );
+    apPort->transport->flush( apPort );
     usleep( 5000 );
     Scip2_SendTerm( apPort );
     usleep( 5000 );
-    tcflush( fn, TCIFLUSH );
+    apPort->transport->flush( apPort );
     usleep( 5000 );
+
+    //! Discard received bytes left in ring buffer
+    apPort->head = apPort->tail = 0;
 }
 
 
@@ -402,7 +881,7 @@ int Scip2_ChangeBitrate( S2Port * apPort, const speed_t acBitrate )
     //! File number of Port
     int fn;
 
-    fn = fileno( apPort );
+    fn = apPort->fd;
     tcgetattr( fn, &term );
 
     cfsetospeed( &term, acBitrate );
@@ -418,6 +897,7 @@ int Scip2_ChangeBitrate( S2Port * apPort, const speed_t acBitrate )
     term.c_cflag &= ~CRTSCTS;					//! Don't control hardware flow
     term.c_cc[VTIME] = 6;						//! Set time out to 600 ms
     term.c_cc[VMIN] = 0;						//! Set minimum string length
+    apPort->timeout = 600;
 
     //! Apply setting
     ret = tcsetattr( fn, TCSANOW, &term );
@@ -438,6 +918,83 @@ int Scip2_ChangeBitrate( S2Port * apPort, const speed_t acBitrate )
 
 
 
+/*--------------------------------------------------------------*/
+/**
+ * @brief Allocate port handle on transport
+ * @param aFd File descriptor to poll ( -1: not pollable )
+ * @param *acpTransport Pointer to transport carrying bytes
+ * @param *apCtx Context of transport
+ * @return failed: NULL, succeeded: Pointer to Device Handle
+ * @attention Transport is left open when it is failed.
+ */
+/*--------------------------------------------------------------*/
+S2Port *Scip2_AllocPort( int aFd, const S2Transport * acpTransport, void *apCtx )
+{
+    //! Handle to the Device
+    S2Port *port;
+
+    port = ( S2Port * ) malloc( sizeof ( S2Port ) );
+    if( port == NULL )
+    {
+#ifdef SCIP2_DEBUG
+        fprintf( stderr, "SCIP2 ERROR: malloc failed.\n" );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+        return NULL;
+    }
+    port->fd = aFd;
+    port->transport = acpTransport;
+    port->ctx = apCtx;
+    port->record = NULL;
+    port->head = 0;
+    port->tail = 0;
+    port->timeout = -1;
+#ifdef SCIP2_ENABLE_CHECKSUM
+    port->checksum = 1;
+#else
+    port->checksum = 0;
+#endif											/* SCIP2_ENABLE_CHECKSUM */
+
+    //! Wake up pipe to stop receive immediately
+#ifdef __linux__
+    port->wake[0] = port->wake[1] = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+    if( port->wake[0] < 0 )
+#else
+    if( pipe( port->wake ) != 0
+        || fcntl( port->wake[0], F_SETFL, O_NONBLOCK ) != 0 || fcntl( port->wake[1], F_SETFL, O_NONBLOCK ) != 0 )
+#endif											/* __linux__ */
+    {
+#ifdef SCIP2_DEBUG
+        fprintf( stderr, "SCIP2 ERROR: Failed to create wake up pipe.\n" );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+        free( port );
+        return NULL;
+    }
+
+    return port;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Release port handle without talking to device
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ */
+/*--------------------------------------------------------------*/
+static void Scip2_FreePort( S2Port * apPort )
+{
+    Scip2_StopRecord( apPort );
+    apPort->transport->close( apPort );
+    close( apPort->wake[0] );
+    if( apPort->wake[1] != apPort->wake[0] )
+        close( apPort->wake[1] );
+    free( apPort );
+}
+
+
+
 /*--------------------------------------------------------------*/
 /**
  * @brief Close SCIP2.0 Device Port
@@ -447,10 +1004,19 @@ int Scip2_ChangeBitrate( S2Port * apPort, const speed_t acBitrate )
 /*--------------------------------------------------------------*/
 int Scip2_Close( S2Port * apPort )
 {
+    //! return value of close
+    int ret;
+
     Scip2CMD_RS( apPort );
     Scip2_SendTerm( apPort );
     Scip2_SendTerm( apPort );
-    if( fclose( apPort ) == 0 )
+    Scip2_StopRecord( apPort );
+    ret = apPort->transport->close( apPort );
+    close( apPort->wake[0] );
+    if( apPort->wake[1] != apPort->wake[0] )
+        close( apPort->wake[1] );
+    free( apPort );
+    if( ret == 0 )
         return 1;
     return 0;
 }
@@ -468,7 +1034,9 @@ int Scip2_Close( S2Port * apPort )
 S2Port *Scip2_Open( const char *acpDevice, const speed_t acBitrate )
 {
     //! Handle to the Device
-    FILE *this;
+    S2Port *this;
+    //! fd
+    int fd;
     //! Bitrate List ( order in which tried )
     speed_t rates[] = {
         B19200,
@@ -497,8 +1065,8 @@ S2Port *Scip2_Open( const char *acpDevice, const speed_t acBitrate )
 
     for ( i = 0; i < 2; i++ )
     {
-        this = fopen( acpDevice, "w+" );
-        if( this == NULL )
+        fd = open( acpDevice, O_RDWR | O_NOCTTY );
+        if( fd < 0 )
         {
 #ifdef SCIP2_DEBUG
             fprintf( stderr, "SCIP2 ERROR: Failed to Open '%s'.\n", acpDevice );
@@ -506,14 +1074,20 @@ S2Port *Scip2_Open( const char *acpDevice, const speed_t acBitrate )
 #endif											/* SCIP2_DEBUG */
             return NULL;
         }
-        if( lockf( fileno( this ), F_TLOCK, 0 ) != 0 )
+        this = Scip2_AllocPort( fd, &Scip2_SerialTransport, NULL );
+        if( this == NULL )
+        {
+            close( fd );
+            return NULL;
+        }
+        if( lockf( this->fd, F_TLOCK, 0 ) != 0 )
         {
             // if( flock( fileno(this), LOCK_EX | LOCK_NB ) != 0 ){
 #ifdef SCIP2_DEBUG
             fprintf( stderr, "SCIP2 ERROR: '%s' Locked.\n", acpDevice );
             fflush( stderr );
 #endif											/* SCIP2_DEBUG */
-            fclose( this );
+            Scip2_FreePort( this );
             return NULL;
         }
 
@@ -527,7 +1101,7 @@ S2Port *Scip2_Open( const char *acpDevice, const speed_t acBitrate )
 #endif											/* SCIP2_DEBUG */
             if( !Scip2_ChangeBitrate( this, *rate ) )
             {
-                fclose( this );
+                Scip2_FreePort( this );
                 return NULL;
             }
             Scip2_Flush( this );
@@ -559,7 +1133,7 @@ S2Port *Scip2_Open( const char *acpDevice, const speed_t acBitrate )
         fprintf( stderr, "SCIP2 ERROR: Failed to Fit Bitrate as.\n" );
         fflush( stderr );
 #endif											/* SCIP2_DEBUG */
-        fclose( this );
+        Scip2_FreePort( this );
         return NULL;
     }
 #ifdef SCIP2_DEBUG
@@ -578,7 +1152,7 @@ S2Port *Scip2_Open( const char *acpDevice, const speed_t acBitrate )
             fprintf( stderr, "SCIP2 ERROR: Failed to Change Device's Bitrate. (%02d)\n", ret );
             fflush( stderr );
 #endif											/* SCIP2_DEBUG */
-            // fclose( this );
+            // Scip2_FreePort( this );
             // return NULL;
         }
     }
@@ -599,7 +1173,7 @@ S2Port *Scip2_Open( const char *acpDevice, const speed_t acBitrate )
 S2Port *Scip2_OpenEthernet( const char *acpAddress, const int acPort )
 {
     //! Handle to the Device
-    FILE *self;
+    S2Port *self;
     //! fd
     int fd;
     //! IP address
@@ -627,25 +1201,27 @@ S2Port *Scip2_OpenEthernet( const char *acpAddress, const int acPort )
             fprintf( stderr, "SCIP2 ERROR: Failed to Connect to '%s:%d'.\n", acpAddress, acPort );
             fflush( stderr );
 #endif											/* SCIP2_DEBUG */
+            close( fd );
             return NULL;
         }
 
-        self = fdopen( fd, "w+" );
+        self = Scip2_AllocPort( fd, &Scip2_TcpTransport, NULL );
         if( self == NULL )
         {
+            close( fd );
 #ifdef SCIP2_DEBUG
             fprintf( stderr, "SCIP2 ERROR: Failed to Open '%s'.\n", acpAddress );
             fflush( stderr );
 #endif											/* SCIP2_DEBUG */
             return NULL;
         }
-        if( lockf( fileno( self ), F_TLOCK, 0 ) != 0 )
+        if( lockf( self->fd, F_TLOCK, 0 ) != 0 )
         {
 #ifdef SCIP2_DEBUG
             fprintf( stderr, "SCIP2 ERROR: '%s' Locked.\n", acpAddress );
             fflush( stderr );
 #endif											/* SCIP2_DEBUG */
-            fclose( self );
+            Scip2_FreePort( self );
             return NULL;
         }
 
@@ -0,0 +1,357 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_clock.c
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "scip2hat.h"
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Initialize clock model
+ * @param *aClock Pointer to clock model
+ */
+/*--------------------------------------------------------------*/
+void S2Clock_Init( S2Clock_t * aClock )
+{
+    memset( aClock, 0, sizeof ( S2Clock_t ) );
+    aClock->skew = 1.0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Convert time of host to milliseconds
+ * @param *acpTime Pointer to CLOCK_MONOTONIC time
+ * @return Time [ms]
+ */
+/*--------------------------------------------------------------*/
+static double S2Clock_Ms( const struct timespec *acpTime )
+{
+    return acpTime->tv_sec * 1000.0 + acpTime->tv_nsec / 1000000.0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Unwrap 24 bits time stamp of sensor
+ * @param *aClock Pointer to clock model
+ * @param aRaw Time stamp of sensor [ms] ( 24 bits )
+ * @return Unwrapped time stamp [ms]
+ * @attention Time stamp going back less than half of the range is kept going back.
+ */
+/*--------------------------------------------------------------*/
+long long S2Clock_Unwrap( S2Clock_t * aClock, unsigned long aRaw )
+{
+    //! Difference from previous time stamp
+    unsigned long diff;
+
+    aRaw &= 0xFFFFFF;
+    if( !aClock->started )
+    {
+        aClock->started = 1;
+        aClock->utime = aRaw;
+    }
+    else
+    {
+        diff = ( aRaw - aClock->raw ) & 0xFFFFFF;
+        if( diff < 0x800000 )
+            aClock->utime += diff;
+        else
+            aClock->utime -= 0x1000000 - diff;
+    }
+    aClock->raw = aRaw;
+
+    return aClock->utime;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Fit clock model to samples
+ * @param *aClock Pointer to clock model
+ */
+/*--------------------------------------------------------------*/
+static void S2Clock_Fit( S2Clock_t * aClock )
+{
+    //! Mean of samples
+    double mdev, mhost;
+    //! Sums of products of deviations
+    double sxy, sxx;
+    //! Skew
+    double skew;
+    //! Offset of sample
+    double offset;
+    //! Loop valiant
+    int i;
+
+    //! Skew by least squares over the window
+    if( aClock->nsample >= 2 )
+    {
+        mdev = mhost = 0;
+        for ( i = 0; i < aClock->nsample; i++ )
+        {
+            mdev += aClock->dev[i];
+            mhost += aClock->host[i];
+        }
+        mdev /= aClock->nsample;
+        mhost /= aClock->nsample;
+        sxy = sxx = 0;
+        for ( i = 0; i < aClock->nsample; i++ )
+        {
+            sxy += ( aClock->dev[i] - mdev ) * ( aClock->host[i] - mhost );
+            sxx += ( aClock->dev[i] - mdev ) * ( aClock->dev[i] - mdev );
+        }
+        if( sxx > 0 )
+        {
+            skew = sxy / sxx;
+            if( skew > 1.0 - SCIP2_CLOCK_MAX_SKEW * 1e-6 && skew < 1.0 + SCIP2_CLOCK_MAX_SKEW * 1e-6 )
+                aClock->skew = skew;
+        }
+    }
+
+    //! Offset by the sample of least delay ( lower envelope )
+    aClock->offset = aClock->candhost - aClock->skew * aClock->canddev;
+    for ( i = 0; i < aClock->nsample; i++ )
+    {
+        offset = aClock->host[i] - aClock->skew * aClock->dev[i];
+        if( offset < aClock->offset )
+            aClock->offset = offset;
+    }
+
+    //! Delay of recived scans against TM round trip while the anchor is in the window
+    if( aClock->anchored
+        && aClock->canddev - aClock->anchordev <= ( double )SCIP2_CLOCK_WINDOW * SCIP2_CLOCK_INTERVAL )
+        aClock->bias = aClock->offset + aClock->skew * aClock->anchordev - aClock->anchorhost;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Add scan to clock model
+ * @param *aClock Pointer to clock model
+ * @param aDevice Unwrapped time stamp of the scan [ms]
+ * @param *acpArrival CLOCK_MONOTONIC time when the scan arrived
+ * @attention Model is restarted when time stamp goes back ( sensor is reset ).
+ */
+/*--------------------------------------------------------------*/
+void S2Clock_Update( S2Clock_t * aClock, long long aDevice, const struct timespec *acpArrival )
+{
+    //! Time of host [ms]
+    double host;
+    //! Time of sensor [ms]
+    double dev;
+
+    host = S2Clock_Ms( acpArrival );
+    dev = ( double )aDevice;
+
+    if( aClock->ncand > 0 && dev < aClock->canddev - SCIP2_CLOCK_INTERVAL )
+    {
+        aClock->nsample = 0;
+        aClock->head = 0;
+        aClock->ncand = 0;
+        aClock->skew = 1.0;
+        aClock->anchored = 0;
+        aClock->bias = 0;
+    }
+
+    //! Keep the sample of least delay in the interval
+    if( aClock->ncand == 0 || host - dev < aClock->candhost - aClock->canddev )
+    {
+        aClock->canddev = dev;
+        aClock->candhost = host;
+    }
+    aClock->ncand++;
+
+    //! Close the interval
+    if( aClock->nsample == 0
+        || dev - aClock->dev[( aClock->head + SCIP2_CLOCK_WINDOW - 1 ) % SCIP2_CLOCK_WINDOW] >= SCIP2_CLOCK_INTERVAL )
+    {
+        aClock->dev[aClock->head] = aClock->canddev;
+        aClock->host[aClock->head] = aClock->candhost;
+        aClock->head = ( aClock->head + 1 ) % SCIP2_CLOCK_WINDOW;
+        if( aClock->nsample < SCIP2_CLOCK_WINDOW )
+            aClock->nsample++;
+        aClock->ncand = 0;
+        aClock->canddev = dev;
+        aClock->candhost = host;
+    }
+
+    S2Clock_Fit( aClock );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Convert time stamp of sensor to time of host
+ * @param *aClock Pointer to clock model
+ * @param aDevice Unwrapped time stamp [ms]
+ * @param *apHost CLOCK_MONOTONIC time
+ * @attention Must not be called while the model is updated by reciver thread,
+ *            stamp of scan is converted by reciver instead.
+ */
+/*--------------------------------------------------------------*/
+void S2Clock_ToHost( S2Clock_t * aClock, long long aDevice, struct timespec *apHost )
+{
+    //! Time of host [ms]
+    double host;
+    //! Whole seconds
+    long long sec;
+
+    host = aClock->offset + aClock->skew * ( double )aDevice - aClock->bias;
+    sec = ( long long )( host / 1000.0 );
+    if( sec * 1000.0 > host )
+        sec--;
+    apHost->tv_sec = sec;
+    apHost->tv_nsec = ( long )( ( host - sec * 1000.0 ) * 1000000.0 );
+    if( apHost->tv_nsec >= 1000000000L )
+    {
+        apHost->tv_sec++;
+        apHost->tv_nsec -= 1000000000L;
+    }
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get skew of sensor clock
+ * @param *aClock Pointer to clock model
+ * @return Skew against host clock [ppm] ( positive: sensor is slow )
+ */
+/*--------------------------------------------------------------*/
+double S2Clock_GetSkew( S2Clock_t * aClock )
+{
+    return ( aClock->skew - 1.0 ) * 1e6;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Synchronize clock model by TM command
+ * @param *aClock Pointer to clock model
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @return failed: 0, succeeded: 1
+ * @attention Sensor must not be scanning. Round trip of least delay in SCIP2_CLOCK_NSYNC
+ *            is taken as anchor, so that delay of recived scans is removed from their stamps.
+ */
+/*--------------------------------------------------------------*/
+int S2Clock_Sync( S2Clock_t * aClock, S2Port * apPort )
+{
+    //! Time stamp of sensor
+    unsigned long dtime;
+    //! Time before and after round trip
+    struct timespec ts, te;
+    //! Round trip time [ms]
+    double rtt;
+    //! Least round trip time [ms]
+    double best;
+    //! Remains value of line
+    unsigned long value;
+    //! Number of remains value of line
+    int nrem;
+    //! return value of function
+    int ret;
+    //! Loop valiant
+    int i;
+
+    ret = Scip2_Send( apPort, "TM0" );
+    if( !Scip2_RecvTerm( apPort ) || ( ret != 0 && ret != 2 ) )
+        return 0;
+
+    best = -1;
+    for ( i = 0; i < SCIP2_CLOCK_NSYNC; i++ )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &ts );
+        ret = Scip2_Send( apPort, "TM1" );
+        if( ret != 0 )
+        {
+            Scip2_RecvTerm( apPort );
+            break;
+        }
+        value = 0;
+        nrem = 0;
+        ret = Scip2_RecvEncodedLine( apPort, &dtime, 1, SCIP2_ENC_4BYTE, &value, &nrem );
+        clock_gettime( CLOCK_MONOTONIC, &te );
+        if( !Scip2_RecvTerm( apPort ) || ret != 1 )
+            break;
+        rtt = S2Clock_Ms( &te ) - S2Clock_Ms( &ts );
+        if( best < 0 || rtt < best )
+        {
+            best = rtt;
+            aClock->anchordev = ( double )S2Clock_Unwrap( aClock, dtime );
+            aClock->anchorhost = ( S2Clock_Ms( &ts ) + S2Clock_Ms( &te ) ) / 2;
+        }
+        else
+            S2Clock_Unwrap( aClock, dtime );
+    }
+
+    ret = Scip2_Send( apPort, "TM2" );
+    if( !Scip2_RecvTerm( apPort ) || ( ret != 0 && ret != 3 ) || best < 0 )
+        return 0;
+    aClock->anchored = 1;
+    if( aClock->nsample == 0 )
+    {
+        //! No scan yet: anchor is the first sample
+        aClock->canddev = aClock->anchordev;
+        aClock->candhost = aClock->anchorhost;
+        aClock->offset = aClock->anchorhost - aClock->skew * aClock->anchordev;
+        aClock->bias = 0;
+    }
+    else
+        S2Clock_Fit( aClock );
+
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Request synchronization of clock model by TM command
+ * @param *aData Pointer to dual buffer structure
+ * @attention Reciver of continuous scanning stops scanning after current scan,
+ *            synchronizes clock and re-issues the command, so that the stream goes on.
+ *        Requested before Scip2CMD_StartMS / Scip2CMD_StartND, it is done after first scan.
+ *        Not applied to scanning serviced by event loop, and to GS ( call S2Clock_Sync
+ *        with clock of the buffer while sensor is not scanning ).
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_SyncClock( S2Sdd_t * aData )
+{
+    __atomic_store_n( &( aData->clock.syncreq ), 1, __ATOMIC_RELEASE );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Stamp scan with time of host by clock model
+ * @param *aData Pointer to dual buffer structure
+ * @param *aScan Pointer to scan whose time stamp is decoded
+ * @attention Arrival of the scan must be set. Must be called by reciver.
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_Stamp( S2Sdd_t * aData, S2Scan_t * aScan )
+{
+    aScan->utime = S2Clock_Unwrap( &( aData->clock ), aScan->time );
+    S2Clock_Update( &( aData->clock ), aScan->utime, &( aData->clock.arrival ) );
+    S2Clock_ToHost( &( aData->clock ), aScan->utime, &( aScan->stamp ) );
+}
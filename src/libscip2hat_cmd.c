@@ -122,8 +122,8 @@ int Scip2CMD_QT( S2Port * apPort )
     int ret;
 
     strcpy( buf, "QT" );
-    ret = fwrite( buf, strlen( buf ), sizeof ( char ), apPort );
-    if( ret == 0 || Scip2_SendTerm( apPort ) == 0 )
+    ret = Scip2_Write( apPort, buf, strlen( buf ) );
+    if( ret <= 0 || Scip2_SendTerm( apPort ) == 0 )
     {
 #ifdef SCIP2_DEBUG
         fprintf( stderr, "SCIP2 ERROR: Failed to send message.\n" );
@@ -135,7 +135,7 @@ int Scip2CMD_QT( S2Port * apPort )
         //! Strtok save ptr
         char *ptr;
 
-        if( fgets( buf, SCIP2_MAX_LENGTH, apPort ) == NULL )
+        if( Scip2_Recv( apPort, buf, SCIP2_MAX_LENGTH ) == 0 )
         {
             return 0;
         }
@@ -172,6 +172,8 @@ int Scip2CMD_GS( S2Port * apPort, int aStart, int aEnd, int aGroup, S2Sdd_t * aD
 {
     //! Buffer to write
     S2Scan_t *scan;
+    //! Request queued for the worker
+    S2GSReq_t *req;
 
     switch ( acEnc )
     {
@@ -189,6 +191,35 @@ int Scip2CMD_GS( S2Port * apPort, int aStart, int aEnd, int aGroup, S2Sdd_t * aD
 
     if( aGroup == 0 )
         aGroup = 1;
+    if( aData->gsworker )
+    {
+        if( !aData->gsactive )
+        {
+            S2Sdd_SetupSwap( aData, 0 );
+            if( pthread_create( &( aData->thread ), NULL, S2Sdd_RecvDataWorker, ( void * )aData ) != 0 )
+                return 0;
+            aData->gsactive = 1;
+        }
+        pthread_mutex_lock( &( aData->mutexw ) );
+        //! Wait for free slot of request queue
+        while( aData->gsreq - aData->gsdone >= SCIP2_GS_QUEUE )
+            pthread_cond_wait( &( aData->condg ), &( aData->mutexw ) );
+        aData->nbuf = 2;
+        req = &( aData->gsq[aData->gsreq % SCIP2_GS_QUEUE] );
+        req->port = apPort;
+        req->start = aStart;
+        req->end = aEnd;
+        req->group = aGroup;
+        req->enc = acEnc;
+        aData->gsreq++;
+        pthread_cond_broadcast( &( aData->condg ) );
+        pthread_mutex_unlock( &( aData->mutexw ) );
+        return 1;
+    }
+
+    S2Sdd_SetupSwap( aData, 0 );
+    if( !S2Sdd_Reserve( aData, ( aEnd - aStart ) / aGroup + 1, acEnc ) )
+        return 0;
     pthread_mutex_lock( &( aData->mutexw ) );
     scan = aData->sec;
     aData->nbuf = 2;
@@ -201,9 +232,7 @@ int Scip2CMD_GS( S2Port * apPort, int aStart, int aEnd, int aGroup, S2Sdd_t * aD
     scan->enc = acEnc;
     pthread_mutex_unlock( &( scan->mutex ) );
 
-    pthread_create( &( aData->thread ), NULL, S2Sdd_RecvData, ( void * )aData );
-
-    return 1;
+    return S2Sdd_StartThread( aData, apPort, S2Sdd_RecvData );
 }
 
 
@@ -218,11 +247,16 @@ int Scip2CMD_GS( S2Port * apPort, int aStart, int aEnd, int aGroup, S2Sdd_t * aD
 /*--------------------------------------------------------------*/
 int Scip2CMD_StopGS( S2Port * apPort, S2Sdd_t * aData )
 {
-    if( aData->thread )
+    if( aData->gsactive )
     {
-        pthread_join( aData->thread, NULL );
-        aData->thread = 0;
+        //! Worker remains for next request
+        pthread_mutex_lock( &( aData->mutexw ) );
+        while( aData->gsdone != aData->gsreq )
+            pthread_cond_wait( &( aData->condg ), &( aData->mutexw ) );
+        pthread_mutex_unlock( &( aData->mutexw ) );
+        return 1;
     }
+    S2Sdd_JoinThread( aData );
     return 1;
 }
 
@@ -269,6 +303,9 @@ Scip2CMD_StartMS( S2Port * apPort, int aStart, int aEnd, int aGroup,
 
     if( aGroup == 0 )
         aGroup = 1;
+    if( aData->gsactive )
+        S2Sdd_StopThread( aData );
+    S2Sdd_SetupSwap( aData, aData->lockfree );
     aData->nbuf = 3;
     aData->thr->start = aData->sec->start = aData->pri->start = aStart;
     aData->thr->end = aData->sec->end = aData->pri->end = aEnd;
@@ -277,7 +314,8 @@ Scip2CMD_StartMS( S2Port * apPort, int aStart, int aEnd, int aGroup,
     aData->thr->enc = aData->sec->enc = aData->pri->enc = acEnc;
     aData->thr->port = aData->sec->port = aData->pri->port = apPort;
     aData->thr->num = aData->sec->num = aData->pri->num = aNum;
-    aData->thr->memsize = aData->sec->memsize = aData->pri->memsize = 0;
+    if( !S2Sdd_Reserve( aData, ( aEnd - aStart ) / aGroup + 1, acEnc ) )
+        return 0;
 
     switch ( acEnc )
     {
@@ -296,15 +334,16 @@ Scip2CMD_StartMS( S2Port * apPort, int aStart, int aEnd, int aGroup,
 #endif											/* SCIP2_DEBUG */
         return 0;
     }
+    strcpy( aData->cmd, mes );
     ret = Scip2_Send( apPort, mes );
     if( !Scip2_RecvTerm( apPort ) )
         return 0;
     if( ret != 0 )
         return 0;
 
-    pthread_create( &( aData->thread ), NULL, S2Sdd_RecvDataCont, ( void * )aData );
-
-    return 1;
+    if( aData->reactor )
+        return S2Reactor_Add( aData->reactor, aData );
+    return S2Sdd_StartThread( aData, apPort, S2Sdd_RecvDataCont );
 }
 
 
@@ -315,6 +354,7 @@ Scip2CMD_StartMS( S2Port * apPort, int aStart, int aEnd, int aGroup,
  * @param *apPort Pointer to SCIP2.0 Device Port
  * @param *aData Pointer to buffer structure
  * @return failed: false, succeeded: true
+ * @attention Reciver thread is woken up and stopped before QT is sent.
  */
 /*--------------------------------------------------------------*/
 int Scip2CMD_StopMS( S2Port * apPort, S2Sdd_t * aData )
@@ -508,13 +548,13 @@ int Scip2CMD_VV( S2Port * apPort, S2Ver_t * apVer )
     while( 1 )
     {
         //! Return value of function
-        void *ret;
+        int ret;
         //! Temporary
         char *tmp;
 
-        ret = fgets( buf, SCIP2_MAX_LENGTH, apPort );
+        ret = Scip2_Recv( apPort, buf, SCIP2_MAX_LENGTH );
 
-        if( ret == NULL || buf[0] == '\n' )
+        if( ret == 0 || buf[0] == '\n' )
             break;
 
         tmp = strchr( buf, ';' );
@@ -571,13 +611,13 @@ int Scip2CMD_PP( S2Port * apPort, S2Param_t * apParam )
     while( 1 )
     {
         //! Return value of function
-        void *ret;
+        int ret;
         //! Temporary
         char *tmp;
 
-        ret = fgets( buf, SCIP2_MAX_LENGTH, apPort );
+        ret = Scip2_Recv( apPort, buf, SCIP2_MAX_LENGTH );
 
-        if( ret == NULL || buf[0] == '\n' )
+        if( ret == 0 || buf[0] == '\n' )
             break;
 
         tmp = strchr( buf, ';' );
@@ -644,8 +684,8 @@ int Scip2CMD_RS( S2Port * apPort )
     int ret;
 
     strcpy( buf, "RS" );
-    ret = fwrite( buf, strlen( buf ), sizeof ( char ), apPort );
-    if( ret == 0 || Scip2_SendTerm( apPort ) == 0 )
+    ret = Scip2_Write( apPort, buf, strlen( buf ) );
+    if( ret <= 0 || Scip2_SendTerm( apPort ) == 0 )
     {
 #ifdef SCIP2_DEBUG
         fprintf( stderr, "SCIP2 ERROR: Failed to send message.\n" );
@@ -658,7 +698,7 @@ int Scip2CMD_RS( S2Port * apPort )
         //! Strtok save ptr
         char *ptr;
 
-        if( fgets( buf, SCIP2_MAX_LENGTH, apPort ) == NULL )
+        if( Scip2_Recv( apPort, buf, SCIP2_MAX_LENGTH ) == 0 )
         {
             return 0;
         }
@@ -717,6 +757,9 @@ Scip2CMD_StartND( S2Port * apPort, int aStart, int aEnd, int aGroup,
 
     if( aGroup == 0 )
         aGroup = 1;
+    if( aData->gsactive )
+        S2Sdd_StopThread( aData );
+    S2Sdd_SetupSwap( aData, aData->lockfree );
     aData->nbuf = 3;
     aData->thr->start = aData->sec->start = aData->pri->start = aStart;
     aData->thr->end = aData->sec->end = aData->pri->end = aEnd;
@@ -725,7 +768,8 @@ Scip2CMD_StartND( S2Port * apPort, int aStart, int aEnd, int aGroup,
     aData->thr->enc = aData->sec->enc = aData->pri->enc = acEnc;
     aData->thr->port = aData->sec->port = aData->pri->port = apPort;
     aData->thr->num = aData->sec->num = aData->pri->num = aNum;
-    aData->thr->memsize = aData->sec->memsize = aData->pri->memsize = 0;
+    if( !S2Sdd_Reserve( aData, ( aEnd - aStart ) / aGroup + 1, acEnc ) )
+        return 0;
 
     switch ( acEnc )
     {
@@ -741,15 +785,16 @@ Scip2CMD_StartND( S2Port * apPort, int aStart, int aEnd, int aGroup,
 #endif											/* SCIP2_DEBUG */
         return 0;
     }
+    strcpy( aData->cmd, mes );
     ret = Scip2_Send( apPort, mes );
     if( !Scip2_RecvTerm( apPort ) )
         return 0;
     if( ret != 0 )
         return 0;
 
-    pthread_create( &( aData->thread ), NULL, S2Sdd_RecvDataCont, ( void * )aData );
-
-    return 1;
+    if( aData->reactor )
+        return S2Reactor_Add( aData->reactor, aData );
+    return S2Sdd_StartThread( aData, apPort, S2Sdd_RecvDataCont );
 }
 
 
@@ -760,6 +805,7 @@ Scip2CMD_StartND( S2Port * apPort, int aStart, int aEnd, int aGroup,
  * @param *apPort Pointer to SCIP2.0 Device Port
  * @param *aData Pointer to buffer structure
  * @return failed: false, succeeded: true
+ * @attention Reciver thread is woken up and stopped before QT is sent.
  */
 /*--------------------------------------------------------------*/
 int Scip2CMD_StopND( S2Port * apPort, S2Sdd_t * aData )
@@ -12,6 +12,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <math.h>
+#include <poll.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
 
 #include "scip2hat.h"
 
@@ -25,33 +33,124 @@
 /*--------------------------------------------------------------*/
 void S2Sdd_Init( S2Sdd_t * aData )
 {
+    //! Attribute of condition variable
+    pthread_condattr_t attr;
+
+    //! Loop valiant
+    int i;
+
     aData->thread = 0;
+    for ( i = 0; i < SCIP2_SDD_MAX_BUF; i++ )
+    {
+        aData->buf[i].size = 0;
+        aData->buf[i].data = 0;
+        aData->buf[i].error = 0;
+        aData->buf[i].memsize = 0;
+        aData->buf[i].ref = 0;
+        aData->buf[i].seq = 0;
+        aData->buf[i].gen = 0;
+        aData->buf[i].nbadsum = 0;
+        aData->buf[i].utime = 0;
+        aData->buf[i].stamp.tv_sec = 0;
+        aData->buf[i].stamp.tv_nsec = 0;
+        memset( &( aData->buf[i].techo ), 0, sizeof ( struct timespec ) );
+        memset( &( aData->buf[i].tdecode ), 0, sizeof ( struct timespec ) );
+        memset( &( aData->buf[i].tpublish ), 0, sizeof ( struct timespec ) );
+        memset( &( aData->buf[i].tcallback ), 0, sizeof ( struct timespec ) );
+        aData->buf[i].type = SCIP2_VAL_ULONG;
+        aData->buf[i].values = NULL;
+        aData->buf[i].data16 = NULL;
+        aData->buf[i].data32 = NULL;
+        aData->buf[i].planar = 0;
+        aData->buf[i].nstep = 0;
+        aData->buf[i].intensity = NULL;
+        aData->buf[i].intensity32 = NULL;
+        aData->buf[i].steptime = NULL;
+        aData->buf[i].stepfirst = 0;
+        aData->buf[i].steppitch = 0;
+        aData->buf[i].x = NULL;
+        aData->buf[i].y = NULL;
+        aData->buf[i].valid = NULL;
+        aData->buf[i].nvalid = 0;
+        memset( aData->buf[i].ninvalid, 0, sizeof ( aData->buf[i].ninvalid ) );
+        pthread_mutex_init( &( aData->buf[i].mutex ), 0 );
+    }
     aData->pri = &( aData->buf[0] );
-    aData->pri->size = 0;
-    aData->pri->data = 0;
-    aData->pri->error = 0;
-    aData->pri->memsize = 0;
-    aData->pri->data = 0;
     aData->sec = &( aData->buf[1] );
-    aData->sec->size = 0;
-    aData->sec->data = 0;
-    aData->sec->error = 0;
-    aData->sec->memsize = 0;
-    aData->sec->data = 0;
     aData->thr = &( aData->buf[2] );
-    aData->thr->size = 0;
-    aData->thr->data = 0;
-    aData->thr->error = 0;
-    aData->thr->memsize = 0;
-    aData->thr->data = 0;
-    pthread_mutex_init( &( aData->pri->mutex ), 0 );
-    pthread_mutex_init( &( aData->sec->mutex ), 0 );
-    pthread_mutex_init( &( aData->thr->mutex ), 0 );
     pthread_mutex_init( &( aData->mutexr ), 0 );
     pthread_mutex_init( &( aData->mutexw ), 0 );
     aData->update = 0;
     aData->callback = NULL;
     aData->userdata = NULL;
+    aData->state = SCIP2_RECV_ECHO;
+    aData->reactor = NULL;
+    aData->active = 0;
+    aData->storage = SCIP2_STORE_ULONG;
+    aData->lockfree = 0;
+    aData->lfactive = 0;
+    aData->middle = 1;
+    aData->rsize = 0;
+    aData->rtype = SCIP2_VAL_ULONG;
+    aData->rplanar = 0;
+    aData->rsteptime = 0;
+    aData->rpoints = 0;
+    aData->rvalid = 0;
+    aData->rgen = 0;
+    aData->nstale = 0;
+    aData->held = NULL;
+
+    pthread_mutex_init( &( aData->mutexn ), 0 );
+    pthread_condattr_init( &attr );
+#ifdef __linux__
+    pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+#endif
+    pthread_cond_init( &( aData->condn ), &attr );
+    pthread_condattr_destroy( &attr );
+    pthread_cond_init( &( aData->condg ), 0 );
+    aData->gsworker = 0;
+    aData->gsactive = 0;
+    aData->gsquit = 0;
+    aData->gsreq = 0;
+    aData->gsdone = 0;
+    aData->gsdepth = 1;
+    aData->npool = 3;
+    aData->trio = 0x07;
+    aData->ndrop = 0;
+    aData->executor = NULL;
+    aData->njob = 0;
+    aData->jobbusy = 0;
+    aData->cbstop = 0;
+    S2Ring_Init( &( aData->ring ) );
+    aData->port = NULL;
+    aData->stopreq = 0;
+    aData->joining = 0;
+    aData->cmd[0] = 0;
+    aData->recover = 0;
+    aData->nreconnect = 0;
+    aData->down = 0;
+    aData->outage = 0;
+    aData->resync = 0;
+    aData->ndiscard = 0;
+    aData->nbadframe = 0;
+    S2Clock_Init( &( aData->clock ) );
+    for ( i = 0; i < SCIP2_LAT_NSTAGE; i++ )
+        S2Hist_Init( &( aData->latency[i] ) );
+    S2Conv_Init( &( aData->conv ) );
+    aData->nwait = 0;
+#ifdef __linux__
+    aData->notify[0] = aData->notify[1] = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+#else
+    if( pipe( aData->notify ) == 0 )
+    {
+        fcntl( aData->notify[0], F_SETFL, O_NONBLOCK );
+        fcntl( aData->notify[1], F_SETFL, O_NONBLOCK );
+    }
+    else
+    {
+        aData->notify[0] = aData->notify[1] = -1;
+    }
+#endif
 }
 
 
@@ -64,24 +163,34 @@ void S2Sdd_Init( S2Sdd_t * aData )
 /*--------------------------------------------------------------*/
 void S2Sdd_Dest( S2Sdd_t * aData )
 {
+    //! Loop valiant
+    int i;
+
     S2Sdd_StopThread( aData );
+    S2Sdd_SetupSwap( aData, 0 );
 
     pthread_mutex_lock( &( aData->mutexw ) );
     pthread_mutex_lock( &( aData->sec->mutex ) );
     pthread_mutex_unlock( &( aData->sec->mutex ) );
     pthread_mutex_unlock( &( aData->mutexw ) );
 
-    pthread_mutex_destroy( &( aData->pri->mutex ) );
-    pthread_mutex_destroy( &( aData->sec->mutex ) );
-    pthread_mutex_destroy( &( aData->thr->mutex ) );
-    if( aData->pri->data != 0 )
-        free( aData->pri->data );
-    if( aData->sec->data != 0 )
-        free( aData->sec->data );
-    if( aData->thr->data != 0 )
-        free( aData->thr->data );
+    for ( i = 0; i < SCIP2_SDD_MAX_BUF; i++ )
+    {
+        pthread_mutex_destroy( &( aData->buf[i].mutex ) );
+        if( aData->buf[i].values != NULL )
+            free( aData->buf[i].values );
+    }
     pthread_mutex_destroy( &( aData->mutexr ) );
     pthread_mutex_destroy( &( aData->mutexw ) );
+    pthread_cond_destroy( &( aData->condn ) );
+    pthread_cond_destroy( &( aData->condg ) );
+    pthread_mutex_destroy( &( aData->mutexn ) );
+    S2Ring_Dest( &( aData->ring ) );
+    S2Conv_Dest( &( aData->conv ) );
+    if( aData->notify[0] >= 0 )
+        close( aData->notify[0] );
+    if( aData->notify[1] != aData->notify[0] )
+        close( aData->notify[1] );
 }
 
 
@@ -108,82 +217,56 @@ void S2Sdd_setCallback( S2Sdd_t * aData, int ( *aCallback ) ( S2Scan_t *, void *
 
 /*--------------------------------------------------------------*/
 /**
- * @brief check data is error
- * @retval 1 error
- * @retval 0 normal
+ * @brief Set event loop which recives continuous scanning data
+ * @param *aData Pointer to dual buffer structure
+ * @param *aReactor Pointer to event loop, or NULL to recive in own thread.
+ *        Effective from next Scip2CMD_StartMS / Scip2CMD_StartND.
  */
 /*--------------------------------------------------------------*/
-int S2Sdd_IsError( S2Sdd_t * aData )
+void S2Sdd_setReactor( S2Sdd_t * aData, S2Reactor_t * aReactor )
 {
-    pthread_mutex_lock( &( aData->mutexw ) );
-    if( aData->sec->error || aData->pri->error || aData->thr->error )
-    {
-        pthread_mutex_unlock( &( aData->mutexw ) );
-        return 1;
-    }
-    pthread_mutex_unlock( &( aData->mutexw ) );
-    return 0;
+    aData->reactor = aReactor;
 }
 
 
 
 /*--------------------------------------------------------------*/
 /**
- * @brief Start using Data ( Non-Blocking )
+ * @brief Set worker pool which runs callback function
  * @param *aData Pointer to dual buffer structure
- * @param **aScan Pointer to buffer structure handle
- * @return failed: NULL, fatal error: -1, succeeded: Pointer to front buffer
+ * @param *aExecutor Pointer to worker pool, or NULL to run callback in reciver.
+ *        Reciver only queues recived scan, and goes on reading next one.
+ *        Callback returning 0 stops scanning at the end of the scan being recived.
+ *        Effective from next Scip2CMD_GS / Scip2CMD_StartMS / Scip2CMD_StartND.
+ * @attention Each scan in callback is held until it returns, so that the pool
+ *            should have spare buffers ( see S2Sdd_setPool ).
  */
 /*--------------------------------------------------------------*/
-int S2Sdd_Begin( S2Sdd_t * aData, S2Scan_t ** aScan )
+void S2Sdd_setExecutor( S2Sdd_t * aData, S2Executor_t * aExecutor )
 {
-    if( pthread_mutex_trylock( &( aData->mutexr ) ) != 0 )
-    {
-        return 0;
-    }
-    pthread_mutex_lock( &( aData->mutexw ) );
-    if( aData->sec->error || aData->pri->error || aData->thr->error )
-    {
-        pthread_mutex_unlock( &( aData->mutexw ) );
-        pthread_mutex_unlock( &( aData->mutexr ) );
-        return -1;
-    }
-    if( aData->update )
-    {
-        aData->update = 0;
-        switch ( aData->nbuf )
-        {
-        case 2:
-            *aScan = aData->pri;
-            break;
-        case 3:
-            *aScan = aData->sec;
-            aData->sec = aData->pri;
-            aData->pri = *aScan;
-            break;
-        default:
-            pthread_mutex_unlock( &( aData->mutexw ) );
-            pthread_mutex_unlock( &( aData->mutexr ) );
-            return 0;
-        }
-        pthread_mutex_unlock( &( aData->mutexw ) );
-        return 1;
-    }
-    pthread_mutex_unlock( &( aData->mutexw ) );
-    pthread_mutex_unlock( &( aData->mutexr ) );
-    return 0;
+    aData->executor = aExecutor;
 }
 
 
 
 /*--------------------------------------------------------------*/
 /**
- * @brief End using Data
+ * @brief Set number of scan buffers in pool
  * @param *aData Pointer to dual buffer structure
+ * @param aNBuf Number of buffers ( 3 - SCIP2_SDD_MAX_BUF ).
+ *        Buffers other than front, middle and back are spares,
+ *        which take the place of buffers still held by consumers.
+ *        Effective from next Scip2CMD_GS / Scip2CMD_StartMS / Scip2CMD_StartND.
  */
 /*--------------------------------------------------------------*/
-void S2Sdd_End( S2Sdd_t * aData )
+void S2Sdd_setPool( S2Sdd_t * aData, int aNBuf )
 {
+    if( aNBuf < 3 )
+        aNBuf = 3;
+    if( aNBuf > SCIP2_SDD_MAX_BUF )
+        aNBuf = SCIP2_SDD_MAX_BUF;
+    pthread_mutex_lock( &( aData->mutexr ) );
+    aData->npool = aNBuf;
     pthread_mutex_unlock( &( aData->mutexr ) );
 }
 
@@ -191,459 +274,1965 @@ void S2Sdd_End( S2Sdd_t * aData )
 
 /*--------------------------------------------------------------*/
 /**
- * @brief Stop thread which reads data of MS/GS command
- * @param *aData Pointer to buffer structure
+ * @brief Get number of scans dropped because no buffer was free
+ * @param *aData Pointer to dual buffer structure
+ * @return Number of dropped scans
  */
 /*--------------------------------------------------------------*/
-void S2Sdd_StopThread( S2Sdd_t * aData )
+int S2Sdd_GetDropped( S2Sdd_t * aData )
 {
-    if( aData->thread )
-    {
-        if( pthread_cancel( aData->thread ) == 0 )
-        {
-            pthread_join( aData->thread, NULL );
-        }
-        aData->thread = 0;
-    }
+    return __atomic_load_n( &( aData->ndrop ), __ATOMIC_RELAXED );
 }
 
 
 
 /*--------------------------------------------------------------*/
 /**
- * @brief Get Scanned data
- * @param *aArg Pointer to dual buffer structure
+ * @brief Enable automatic recovery of continuous scanning
+ * @param *aData Pointer to dual buffer structure
+ * @param aEnable Enable: 1, Disable: 0.
+ *        Broken echo, status or data line costs the scan being recived:
+ *        reciver flushes the port, re-issues MS / MD / ME / ND command and goes on,
+ *        instead of setting error and stopping.
+ *        Effective from next Scip2CMD_StartMS / Scip2CMD_StartND.
+ * @attention Not applied to scanning serviced by event loop ( see S2Sdd_setReactor ).
  */
 /*--------------------------------------------------------------*/
-void *S2Sdd_RecvData( void *aArg )
+void S2Sdd_setRecover( S2Sdd_t * aData, int aEnable )
 {
-    //! Pointer to dual buffer structure
-    S2Sdd_t *data;
-    //! Pointer to front buffer
-    S2Scan_t *scan;
-    //! Pointer to Buffer
-    unsigned long *pos;
-    //! Returned value
-    int ret;
-    //! Send & Recive Buffer
-    char buf[SCIP2_MAX_LENGTH];
-    //! Remains value of line
-    unsigned long value;
-    //! Number of remains value of line
-    int nrem;
+    aData->recover = aEnable;
+}
 
-    pthread_setcanceltype( PTHREAD_CANCEL_DEFERRED, NULL );
 
-    data = ( S2Sdd_t * ) aArg;
 
-    pthread_mutex_lock( &( data->mutexw ) );
-    scan = data->sec;
-    pthread_mutex_unlock( &( data->mutexw ) );
+/*--------------------------------------------------------------*/
+/**
+ * @brief Enable resynchronization of continuous scanning
+ * @param *aData Pointer to dual buffer structure
+ * @param aEnable Enable: 1, Disable: 0.
+ *        Scan broken by line noise is discarded, and parser skips lines until
+ *        echo back of next scan, instead of setting error and stopping.
+ *        Scan cut short is discarded too.
+ *        Error is set when echo back is not found in lines of two scans.
+ *        Effective from next Scip2CMD_StartMS / Scip2CMD_StartND.
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_setResync( S2Sdd_t * aData, int aEnable )
+{
+    aData->resync = aEnable;
+}
 
-    pthread_mutex_lock( &( scan->mutex ) );
 
-    switch ( scan->enc )
-    {
-    case SCIP2_ENC_2BYTE:
-        sprintf( buf, "GS%04d%04d%02d", scan->start, scan->end, scan->group );
-        break;
-    case SCIP2_ENC_3BYTE:
-        sprintf( buf, "GD%04d%04d%02d", scan->start, scan->end, scan->group );
-        break;
-    case SCIP2_ENC_3X2BYTE:
-        sprintf( buf, "GE%04d%04d%02d", scan->start, scan->end, scan->group );
-        break;
-    default:
-#ifdef SCIP2_DEBUG
-        fprintf( stderr, "SCIP2 ERROR: Unsupported encording type selected.\n" );
-        fflush( stderr );
-        fflush( stderr );
-#endif											/* SCIP2_DEBUG */
-        scan->error = 1;
-        pthread_mutex_unlock( &( scan->mutex ) );
-        pthread_testcancel(  );
-        pthread_detach( data->thread );
-        pthread_exit( NULL );
-        break;
-    }
 
-    ret = Scip2_Send( scan->port, buf );
-    if( ret != 0 )
-    {
-        scan->error = 2;
-        pthread_mutex_unlock( &( scan->mutex ) );
-        pthread_testcancel(  );
-        pthread_detach( data->thread );
-        pthread_exit( NULL );
-    }
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get number of bytes skipped by resynchronization
+ * @param *aData Pointer to dual buffer structure
+ * @return Number of bytes
+ */
+/*--------------------------------------------------------------*/
+long S2Sdd_GetDiscardedBytes( S2Sdd_t * aData )
+{
+    return __atomic_load_n( &( aData->ndiscard ), __ATOMIC_RELAXED );
+}
 
-    value = 0;
-    nrem = 0;
-    //! Start reading
-    ret = Scip2_RecvEncodedLine( scan->port, &scan->time, 1, SCIP2_ENC_4BYTE, &value, &nrem );
-    if( ret != 1 )
-    {
-#ifdef SCIP2_DEBUG
-        fprintf( stderr, "SCIP2 ERROR: Failed to recive time stamp.\n" );
-        fflush( stderr );
-        fflush( stderr );
-#endif											/* SCIP2_DEBUG */
-        scan->error = 1;
-        pthread_mutex_unlock( &( scan->mutex ) );
-        pthread_testcancel(  );
-        pthread_detach( data->thread );
-        pthread_exit( NULL );
-    }
-#ifdef SCIP2_DEBUG_ALL
-    fprintf( stderr, "SCIP2 INFO: Reciving data at %d.\n", ( int )scan->time );
-    fflush( stderr );
-#endif											/* SCIP2_DEBUG_ALL */
-    if( scan->memsize < ( scan->end - scan->start ) / scan->group + 1024 )
-    {
-        if( scan->data )
-            free( scan->data );
-        scan->memsize = ( scan->end - scan->start ) / scan->group + 1024;
-        scan->data = ( unsigned long * )malloc( sizeof ( unsigned long ) * scan->memsize );
-        if( scan->data == 0 )
-        {
-#ifdef SCIP2_DEBUG
-            fprintf( stderr, "SCIP2 ERROR: malloc failed.\n" );
-            fflush( stderr );
-#endif											/* SCIP2_DEBUG */
-            scan->memsize = -1;
-            scan->error = 2;
-            pthread_mutex_unlock( &( scan->mutex ) );
-            pthread_testcancel(  );
-            pthread_detach( data->thread );
-            pthread_exit( NULL );
-        }
-    }
-    value = 0;
-    nrem = 0;
-    pos = scan->data;
-    while( ( ret =
-             Scip2_RecvEncodedLine( scan->port, pos,
-                                    scan->memsize - ( pos - scan->data ), scan->enc, &value, &nrem ) ) > 0 )
-    {
-        pos += ret;
-    }
 
-    if( ret == -1 )
-    {
-        scan->error = 1;
-        pthread_mutex_unlock( &( scan->mutex ) );
-        pthread_testcancel(  );
-        pthread_detach( data->thread );
-        pthread_exit( NULL );
-    }
-    scan->size = pos - scan->data;
-#ifdef SCIP2_DEBUG_ALL
-    fprintf( stderr, "SCIP2 INFO: %d steps recived.\n", scan->size );
-    fflush( stderr );
-#endif											/* SCIP2_DEBUG_ALL */
 
-    pthread_mutex_unlock( &( scan->mutex ) );
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get number of broken scans discarded by resynchronization
+ * @param *aData Pointer to dual buffer structure
+ * @return Number of scans
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_GetDiscardedFrames( S2Sdd_t * aData )
+{
+    return __atomic_load_n( &( aData->nbadframe ), __ATOMIC_RELAXED );
+}
 
-    //! run callback function
-    if( data->callback )
-    {
-        pthread_mutex_lock( &( scan->mutex ) );
-        data->callback( scan, data->userdata );
-        pthread_mutex_unlock( &( scan->mutex ) );
-    }
 
-    //! swap buffer
-    pthread_mutex_lock( &( data->mutexw ) );
-    data->sec = data->pri;
-    data->pri = scan;
-    data->update = 1;
-    pthread_mutex_unlock( &( data->mutexw ) );
 
-    pthread_testcancel(  );
-    pthread_detach( data->thread );
-    pthread_exit( NULL );
-    return 0;
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get number of times continuous scanning was restarted by recovery
+ * @param *aData Pointer to dual buffer structure
+ * @return Number of restarts
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_GetReconnect( S2Sdd_t * aData )
+{
+    return __atomic_load_n( &( aData->nreconnect ), __ATOMIC_RELAXED );
 }
 
 
 
-#if defined(SCIP2_DEBUG_ALL) || defined(SCIP2_OUTPUT_CONTDATA)
-char errbuf[2][8192];
-int nerrbuf;
-char *perrbuf;
-char *perrbuf2;
-#endif										/* SCIP2_DEBUG_ALL */
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get length of last outage recovered
+ * @param *aData Pointer to dual buffer structure
+ * @return Time from broken scan to next published scan [ms]
+ */
+/*--------------------------------------------------------------*/
+long S2Sdd_GetOutage( S2Sdd_t * aData )
+{
+    return __atomic_load_n( &( aData->outage ), __ATOMIC_RELAXED );
+}
 
 
 
 /*--------------------------------------------------------------*/
 /**
- * @brief Recive scanned data continually
- * @param *aArg Pointer to dual buffer structure
+ * @brief Set storage mode of scanned data
+ * @param *aData Pointer to dual buffer structure
+ * @param aStorage SCIP2_STORE_ULONG or SCIP2_STORE_COMPACT, with SCIP2_STORE_PLANAR.
+ *        In compact mode, 2 bytes encoding is stored in data16 and others in data32.
+ *        In planar mode, range of ME / NE / GE is stored in data ( data32 ) and
+ *        intensity in intensity ( intensity32 ), nstep values each.
+ *        Effective from next Scip2CMD_GS / Scip2CMD_StartMS / Scip2CMD_StartND.
  */
 /*--------------------------------------------------------------*/
-void *S2Sdd_RecvDataCont( void *aArg )
+void S2Sdd_setStorage( S2Sdd_t * aData, int aStorage )
 {
-    //! Pointer to dual buffer structure
-    S2Sdd_t *data;
-    //! Pointer to front buffer
-    S2Scan_t *scan;
-    //! Pointer to Buffer
-    unsigned long *pos;
-    //! Returned value
-    void *ret;
-    //! Send & Recive Buffer
-    char buf[SCIP2_MAX_LENGTH];
-    //! Command
-    char mes[SCIP2_MAX_LENGTH];
-    //! Strtok save ptr
-    char *ptr;
-    //! Remaining scan number
-    char rem[3];
-    //! Remaining scan number
-    int remnum;
-    //! Remains value of line
-    unsigned long value;
-    //! Number of remains value of line
-    int nrem;
-    //! Number of data in 1 step
-    int multi;
-    //! Returned status number
-    int status;
-    //! Number of encoded/decoded lines
-    int nlines;
+    aData->storage = aStorage;
+}
 
-    int enc;
-#if defined(SCIP2_DEBUG_ALL) || defined(SCIP2_OUTPUT_CONTDATA)
-    int pid;
-    pid = getpid(  );
-#endif
 
-    pthread_setcanceltype( PTHREAD_CANCEL_DEFERRED, NULL );
 
-    data = ( S2Sdd_t * ) aArg;
-#ifdef SCIP2_OUTPUT_CONTDATA
-    nerrbuf = 0;
-#endif
+/*--------------------------------------------------------------*/
+/**
+ * @brief Set lock free mode of triple buffer for continuous scanning
+ * @param *aData Pointer to dual buffer structure
+ * @param aEnable Publish and pick up scans by atomic exchange instead of mutexes.
+ *        Effective from next Scip2CMD_StartMS / Scip2CMD_StartND.
+ *        In this mode S2Sdd_Begin never fails by contention and reciver never waits reader,
+ *        and the scan returned by S2Sdd_Begin is valid until next S2Sdd_Begin.
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_setLockFree( S2Sdd_t * aData, int aEnable )
+{
+    aData->lockfree = aEnable;
+}
 
-    pthread_mutex_lock( &( data->mutexw ) );
-    scan = data->thr;
-    multi = 1;
-    enc = scan->enc;
-    switch ( scan->enc )
-    {
-    case SCIP2_ENC_2BYTE:
-        sprintf( mes, "MS%04d%04d%02d%d", scan->start, scan->end, scan->group, scan->cull );
-        break;
-    case SCIP2_ENC_3BYTE:
-        sprintf( mes, "MD%04d%04d%02d%d", scan->start, scan->end, scan->group, scan->cull );
-        break;
-    case SCIP2_ENC_3X2BYTE:
-        sprintf( mes, "ME%04d%04d%02d%d", scan->start, scan->end, scan->group, scan->cull );
-        enc = SCIP2_ENC_3BYTE;
-        multi = 2;
-        break;
-    default:
-        scan->error = 2;
-        pthread_mutex_unlock( &( data->mutexw ) );
-        pthread_testcancel(  );
-        pthread_detach( data->thread );
-        pthread_exit( NULL );
-        break;
-    }
-    pthread_mutex_unlock( &( data->mutexw ) );
 
-    while( 1 )
-    {
-#ifdef SCIP2_OUTPUT_CONTDATA
-        perrbuf = errbuf[nerrbuf];
-        nerrbuf = ( nerrbuf + 1 ) & 1;
-        perrbuf2 = errbuf[nerrbuf];
-        *perrbuf = 0;
-#endif
 
-        pthread_mutex_lock( &( scan->mutex ) );
+/*--------------------------------------------------------------*/
+/**
+ * @brief Set persistent worker mode of GS
+ * @param *aData Pointer to dual buffer structure
+ * @param aEnable Recive scans of Scip2CMD_GS in one long-lived thread
+ *        instead of creating a thread par request.
+ *        The worker is stopped by disabling, Scip2CMD_StartMS / Scip2CMD_StartND or S2Sdd_Dest.
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_setGSWorker( S2Sdd_t * aData, int aEnable )
+{
+    if( !aEnable && aData->gsactive )
+        S2Sdd_StopThread( aData );
+    aData->gsworker = aEnable;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Set number of GS requests kept in flight by the worker
+ * @param *aData Pointer to dual buffer structure
+ * @param aDepth Number of requests sent before their replies are read ( 1 - SCIP2_GS_QUEUE ).
+ *        Replies are matched to requests by echo back with tag.
+ *        Depth larger than 1 enables persistent worker mode of GS.
+ * @attention Useful for Ethernet connection, on which each request pays a round trip.
+ *            Requests not sent yet are dropped when the worker is stopped.
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_setGSPipeline( S2Sdd_t * aData, int aDepth )
+{
+    if( aDepth < 1 )
+        aDepth = 1;
+    if( aDepth > SCIP2_GS_QUEUE )
+        aDepth = SCIP2_GS_QUEUE;
+    pthread_mutex_lock( &( aData->mutexw ) );
+    aData->gsdepth = aDepth;
+    pthread_mutex_unlock( &( aData->mutexw ) );
+    if( aDepth > 1 )
+        aData->gsworker = 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Switch how scans are swapped between reciver and reader
+ * @param *aData Pointer to dual buffer structure
+ * @param aLockFree Swap by atomic exchange of middle index
+ * @attention Reciver must be stopped.
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_SetupSwap( S2Sdd_t * aData, int aLockFree )
+{
+    pthread_mutex_lock( &( aData->mutexw ) );
+    if( aData->lfactive )
+    {
+        aData->sec = &( aData->buf[aData->middle & ~SCIP2_SDD_DIRTY] );
+        aData->update = ( aData->middle & SCIP2_SDD_DIRTY ) != 0;
+    }
+    aData->middle = ( int )( aData->sec - aData->buf ) | ( aData->update ? SCIP2_SDD_DIRTY : 0 );
+    aData->lfactive = aLockFree;
+    pthread_mutex_unlock( &( aData->mutexw ) );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Check error of any buffer without locking
+ * @param *aData Pointer to dual buffer structure
+ * @return error: 1, normal: 0
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_LoadError( S2Sdd_t * aData )
+{
+    //! Loop valiant
+    int i;
+
+    for ( i = 0; i < aData->npool; i++ )
+    {
+        if( __atomic_load_n( &( aData->buf[i].error ), __ATOMIC_ACQUIRE ) )
+            return 1;
+    }
+    return 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get type of decoded value in storage mode
+ * @param *aData Pointer to dual buffer structure
+ * @param acEnc Encode type
+ * @return Type of decoded value
+ */
+/*--------------------------------------------------------------*/
+static S2ValType S2Sdd_ValType( S2Sdd_t * aData, const S2EncType acEnc )
+{
+    if( !( aData->storage & SCIP2_STORE_COMPACT ) )
+        return SCIP2_VAL_ULONG;
+    if( acEnc == SCIP2_ENC_2BYTE )
+        return SCIP2_VAL_UINT16;
+    return SCIP2_VAL_UINT32;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Check whether range and intensity are stored in planes
+ * @param *aData Pointer to dual buffer structure
+ * @param aMulti Number of values par step
+ * @return interleaved: 0, planar: 1
+ */
+/*--------------------------------------------------------------*/
+static int S2Sdd_IsPlanar( S2Sdd_t * aData, int aMulti )
+{
+    return ( aData->storage & SCIP2_STORE_PLANAR ) && aMulti == 2;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Allocate buffer of decoded values
+ * @param *aScan Pointer to buffer structure
+ * @param acType Type of decoded value
+ * @param aPlanar Store range and intensity in planes
+ * @param aNValue Number of values
+ * @return failed: 0, succeeded: 1
+ */
+/*--------------------------------------------------------------*/
+static int S2Scan_Alloc( S2Scan_t * aScan, const S2ValType acType, int aPlanar, int aStepTime, int aPoints,
+                         int aValid, int aNValue )
+{
+    //! Pointer to intensity plane
+    char *plane;
+    //! Size of values aligned for validity mask, time of steps and points
+    size_t size;
+    //! Size of validity mask
+    size_t vsize;
+    //! Size of time of steps
+    size_t tsize;
+
+    if( aScan->values )
+        free( aScan->values );
+    aScan->data = NULL;
+    aScan->data16 = NULL;
+    aScan->data32 = NULL;
+    aScan->intensity = NULL;
+    aScan->intensity32 = NULL;
+    aScan->steptime = NULL;
+    aScan->x = NULL;
+    aScan->y = NULL;
+    aScan->valid = NULL;
+    aScan->type = acType;
+    aScan->planar = aPlanar;
+    if( aPlanar )
+        aNValue = ( aNValue + 1 ) & ~1;
+    aScan->memsize = aNValue;
+    size = ( Scip2_ValSize( acType ) * aNValue + sizeof ( uint64_t ) - 1 ) & ~( sizeof ( uint64_t ) - 1 );
+    vsize = aValid ? sizeof ( uint64_t ) * SCIP2_MASK_WORDS( aNValue ) : 0;
+    tsize = aStepTime ? sizeof ( int32_t ) * aNValue : 0;
+    aScan->values = malloc( size + vsize + tsize + ( aPoints ? sizeof ( float ) * 2 * aNValue : 0 ) );
+    if( aScan->values == NULL )
+    {
+#ifdef SCIP2_DEBUG
+        fprintf( stderr, "SCIP2 ERROR: malloc failed.\n" );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+        aScan->memsize = -1;
+        return 0;
+    }
+    plane = ( char * )aScan->values + Scip2_ValSize( acType ) * ( aNValue / 2 );
+    switch ( acType )
+    {
+    case SCIP2_VAL_UINT16:
+        aScan->data16 = ( uint16_t * ) aScan->values;
+        break;
+    case SCIP2_VAL_UINT32:
+        aScan->data32 = ( uint32_t * ) aScan->values;
+        if( aPlanar )
+            aScan->intensity32 = ( uint32_t * ) plane;
+        break;
+    default:
+        aScan->data = ( unsigned long * )aScan->values;
+        if( aPlanar )
+            aScan->intensity = ( unsigned long * )plane;
+        break;
+    }
+    if( aValid )
+        aScan->valid = ( uint64_t * ) ( ( char * )aScan->values + size );
+    if( aStepTime )
+        aScan->steptime = ( int32_t * ) ( ( char * )aScan->values + size + vsize );
+    if( aPoints )
+    {
+        aScan->x = ( float * )( ( char * )aScan->values + size + vsize + tsize );
+        aScan->y = aScan->x + aNValue;
+    }
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Decode one encoded line into buffer of scan
+ * @param *aScan Pointer to buffer structure
+ * @param *apLine Pointer to the line ( LF terminated )
+ * @param aLen Length of the line including LF
+ * @param *apNValue Number of values already decoded
+ * @param acEnc Encode type
+ * @param *apRemains Remaining value
+ * @param *apNRemains Number of remaining bytes
+ * @return buffer over flow: -1, broken line: -2, end of data: 0,
+ *         succeeded: size of decoded data
+ * @attention In planar storage, values are alternately stored into range and intensity plane.
+ *            Time of the steps is filled at the same time if enabled.
+ */
+/*--------------------------------------------------------------*/
+static int S2Scan_DecodeLine( S2Scan_t * aScan, const char *apLine, int aLen, int *apNValue,
+                              const S2EncType acEnc, unsigned long *apRemains, int *apNRemains )
+{
+    //! Values of the line before deinterleaving
+    unsigned long tmp[SCIP2_MAX_LENGTH];
+    //! Number of decoded data
+    int n;
+    //! Number of lines with bad checksum ( NULL: not validated )
+    int *nbadsum;
+    //! General
+    int i, j;
+
+    nbadsum = aScan->port->checksum ? &aScan->nbadsum : NULL;
+    if( !aScan->planar )
+    {
+        n = Scip2_DecodeLineSum( apLine, aLen, ( char * )aScan->values + *apNValue * Scip2_ValSize( aScan->type ),
+                                 aScan->type, aScan->memsize - *apNValue, acEnc, apRemains, apNRemains, nbadsum );
+        if( n > 0 )
+        {
+            if( aScan->steptime )
+                S2Scan_StepTime( aScan, *apNValue, *apNValue + n );
+            *apNValue += n;
+        }
+        return n;
+    }
+
+    n = Scip2_DecodeLineSum( apLine, aLen, tmp, aScan->type, SCIP2_MAX_LENGTH, acEnc, apRemains, apNRemains,
+                             nbadsum );
+    if( n <= 0 )
+        return n;
+    if( n > aScan->memsize - *apNValue )
+    {
+#ifdef SCIP2_DEBUG
+        fprintf( stderr, "SCIP2 ERROR: Recive buffer over flow.\n" );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+        return -1;
+    }
+    //! Even values are range and odd values are intensity
+    j = *apNValue;
+    switch ( aScan->type )
+    {
+    case SCIP2_VAL_UINT32:
+        for ( i = 0; i < n; i++, j++ )
+            ( j & 1 ? aScan->intensity32 : aScan->data32 )[j >> 1] = ( ( uint32_t * ) tmp )[i];
+        break;
+    default:
+        for ( i = 0; i < n; i++, j++ )
+            ( j & 1 ? aScan->intensity : aScan->data )[j >> 1] = tmp[i];
+        break;
+    }
+    if( aScan->steptime )
+        S2Scan_StepTime( aScan, *apNValue, j );
+    *apNValue = j;
+    return n;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Check whether buffer fits scans reserved by S2Sdd_Reserve
+ * @param *aData Pointer to dual buffer structure
+ * @param *aScan Pointer to buffer
+ * @return no: 0, yes: 1
+ */
+/*--------------------------------------------------------------*/
+static int S2Sdd_Fits( S2Sdd_t * aData, S2Scan_t * aScan )
+{
+    return aScan->memsize >= aData->rsize && aScan->type == aData->rtype && aScan->planar == aData->rplanar
+        && ( aScan->steptime != NULL ) == aData->rsteptime && ( aScan->x != NULL ) == aData->rpoints
+        && ( aScan->valid != NULL ) == aData->rvalid;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Allocate all buffers before reciving scans
+ * @param *aData Pointer to dual buffer structure
+ * @param aNStep Number of steps par scan ( e.g. step_max + 1 of Scip2CMD_PP )
+ * @param acEnc Encode type
+ * @return failed: 0, succeeded: 1
+ * @attention Buffers already large enough are kept, so that reciving scans never allocates memory.
+ *            May be called between S2Sdd_Begin and S2Sdd_End ( e.g. Scip2CMD_GS ), then buffers
+ *            in use are reallocated by consumer when they are let go, and never filled until then.
+ *            Reciver must not run. In lock free mode, scan not picked up yet is given up.
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_Reserve( S2Sdd_t * aData, int aNStep, const S2EncType acEnc )
+{
+    //! Type of decoded value
+    S2ValType type;
+    //! Number of values par step
+    int multi;
+    //! Store range and intensity in planes
+    int planar;
+    //! Store time of steps
+    int steptime;
+    //! Store Cartesian points
+    int points;
+    //! Store validity mask
+    int valid;
+    //! Index of buffer taken from middle
+    int mid;
+    //! Scan in broadcast ring
+    S2Scan_t *ring;
+    //! Loop valiant
+    int i;
+
+    multi = acEnc == SCIP2_ENC_3X2BYTE ? 2 : 1;
+    type = S2Sdd_ValType( aData, acEnc );
+    planar = S2Sdd_IsPlanar( aData, multi );
+    steptime = aData->conv.steppitch > 0;
+    points = aData->conv.points;
+    valid = aData->conv.validity;
+
+    //! Scans in ring are given up if they can not be reused
+    pthread_mutex_lock( &( aData->ring.mutex ) );
+    for ( i = 0; i < aData->ring.nring; i++ )
+    {
+        ring = aData->ring.scan[i];
+        if( ring && ( ring->memsize < aNStep * multi || ring->type != type || ring->planar != planar
+                      || ( ring->steptime != NULL ) != steptime || ( ring->x != NULL ) != points
+                      || ( ring->valid != NULL ) != valid ) )
+            break;
+    }
+    pthread_mutex_unlock( &( aData->ring.mutex ) );
+    if( i < aData->ring.nring )
+        S2Ring_Flush( &( aData->ring ) );
+
+    //! Reader lock is not taken, because S2Sdd_Begin may hold it in the calling thread
+    pthread_mutex_lock( &( aData->mutexw ) );
+    aData->rsize = aNStep * multi;
+    aData->rtype = type;
+    aData->rplanar = planar;
+    aData->rsteptime = steptime;
+    aData->rpoints = points;
+    aData->rvalid = valid;
+    __atomic_store_n( &( aData->rgen ), aData->rgen + 1, __ATOMIC_RELEASE );
+    __atomic_store_n( &( aData->nstale ), 0, __ATOMIC_RELEASE );
+    //! Middle buffer is taken back from reader in lock free mode, and back buffer takes its place
+    if( aData->lfactive )
+    {
+        mid = __atomic_exchange_n( &( aData->middle ), ( int )( aData->thr - aData->buf ), __ATOMIC_ACQ_REL );
+        aData->sec = aData->thr;
+        aData->thr = &( aData->buf[mid & ~SCIP2_SDD_DIRTY] );
+    }
+    for ( i = 0; i < aData->npool; i++ )
+    {
+        if( !S2Sdd_Fits( aData, &( aData->buf[i] ) ) )
+        {
+            //! Buffer held by consumer is reallocated when it is let go ( see S2Sdd_Refit )
+            if( __atomic_load_n( &( aData->buf[i].ref ), __ATOMIC_ACQUIRE ) > 0
+                || &( aData->buf[i] ) == __atomic_load_n( &( aData->held ), __ATOMIC_ACQUIRE ) )
+            {
+                __atomic_add_fetch( &( aData->nstale ), 1, __ATOMIC_RELEASE );
+                continue;
+            }
+            //! Scan not picked up yet is given up
+            if( aData->update && &( aData->buf[i] ) == ( aData->nbuf == 3 ? aData->sec : aData->pri ) )
+                aData->update = 0;
+            if( !S2Scan_Alloc( &( aData->buf[i] ), type, planar, steptime, points, valid, aNStep * multi ) )
+            {
+                aData->buf[i].error = 2;
+                break;
+            }
+        }
+        __atomic_store_n( &( aData->buf[i].gen ), aData->rgen, __ATOMIC_RELEASE );
+    }
+    pthread_mutex_unlock( &( aData->mutexw ) );
+    return i == aData->npool;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Check whether reciver can fill the buffer
+ * @param *aData Pointer to dual buffer structure
+ * @param *aScan Pointer to buffer
+ * @return no: 0, yes: 1
+ */
+/*--------------------------------------------------------------*/
+static int S2Sdd_IsFree( S2Sdd_t * aData, S2Scan_t * aScan )
+{
+    //! Generation of reserved size
+    int gen;
+
+    //! Buffers kept by S2Sdd_Reserve while they were in use are of older generation
+    gen = __atomic_load_n( &( aData->rgen ), __ATOMIC_ACQUIRE );
+    return __atomic_load_n( &( aScan->ref ), __ATOMIC_ACQUIRE ) == 0
+        && __atomic_load_n( &( aScan->gen ), __ATOMIC_ACQUIRE ) == gen;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get free spare buffer out of the three buffers in use
+ * @param *aData Pointer to dual buffer structure
+ * @param *aScan Pointer to buffer whose scanning parameters spare buffer takes over
+ * @return no free spare buffer: NULL, otherwise: spare buffer
+ * @attention Bit of spare buffer is not set in trio. Must be called by reciver.
+ */
+/*--------------------------------------------------------------*/
+static S2Scan_t *S2Sdd_TakeSpare( S2Sdd_t * aData, S2Scan_t * aScan )
+{
+    //! Loop valiant
+    int i;
+
+    for ( i = 0; i < aData->npool; i++ )
+    {
+        if( ( aData->trio & ( 1 << i ) ) || !S2Sdd_IsFree( aData, &( aData->buf[i] ) ) )
+            continue;
+        //! Parameters of scanning
+        aData->buf[i].start = aScan->start;
+        aData->buf[i].end = aScan->end;
+        aData->buf[i].group = aScan->group;
+        aData->buf[i].cull = aScan->cull;
+        aData->buf[i].num = aScan->num;
+        aData->buf[i].port = aScan->port;
+        aData->buf[i].enc = aScan->enc;
+        return &( aData->buf[i] );
+    }
+    return NULL;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get buffer which reciver fills next
+ * @param *aData Pointer to dual buffer structure
+ * @param *aScan Pointer to buffer going to be filled
+ * @return no free buffer: NULL, otherwise: aScan or spare buffer taking its place
+ * @attention Buffer held by consumers is returned to pool, and becomes spare when released.
+ *            Must be called by reciver.
+ */
+/*--------------------------------------------------------------*/
+static S2Scan_t *S2Sdd_TakeFree( S2Sdd_t * aData, S2Scan_t * aScan )
+{
+    //! Spare buffer taking place of aScan
+    S2Scan_t *spare;
+
+    if( S2Sdd_IsFree( aData, aScan ) )
+        return aScan;
+    spare = S2Sdd_TakeSpare( aData, aScan );
+    if( spare )
+    {
+        aData->trio &= ~( 1 << ( int )( aScan - aData->buf ) );
+        aData->trio |= 1 << ( int )( spare - aData->buf );
+    }
+    return spare;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Run callback function of recived scan in reciver
+ * @param *aData Pointer to dual buffer structure
+ * @param *aScan Pointer to recived scan
+ * @param aLocked Lock mutex of the scan while callback runs
+ * @return stop scanning: 0, continue: 1
+ * @attention Nothing is done with worker pool ( see S2Sdd_PostCallback ).
+ */
+/*--------------------------------------------------------------*/
+static int S2Sdd_RunCallback( S2Sdd_t * aData, S2Scan_t * aScan, int aLocked )
+{
+    //! Returned value of callback
+    int ret;
+
+    if( !aData->callback || aData->executor )
+        return 1;
+    if( aLocked )
+        pthread_mutex_lock( &( aScan->mutex ) );
+    S2Sdd_MarkCallback( aData, aScan );
+    ret = aData->callback( aScan, aData->userdata );
+    if( aLocked )
+        pthread_mutex_unlock( &( aScan->mutex ) );
+    return ret;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Queue published scan to worker pool running callback function
+ * @param *aData Pointer to dual buffer structure
+ * @param *aScan Pointer to recived scan
+ * @return stop scanning: 0, continue: 1
+ * @attention Returns whether earlier callbacks requested to stop.
+ *            Scan is dropped from callback if queue of the pool is full.
+ */
+/*--------------------------------------------------------------*/
+static int S2Sdd_PostCallback( S2Sdd_t * aData, S2Scan_t * aScan )
+{
+    if( !aData->callback || !aData->executor )
+        return 1;
+    if( !S2Executor_Post( aData->executor, aData, aScan ) )
+        __atomic_add_fetch( &( aData->ndrop ), 1, __ATOMIC_RELAXED );
+    return !__atomic_load_n( &( aData->cbstop ), __ATOMIC_ACQUIRE );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief check data is error
+ * @retval 1 error
+ * @retval 0 normal
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_IsError( S2Sdd_t * aData )
+{
+    if( aData->lfactive )
+        return S2Sdd_LoadError( aData );
+    pthread_mutex_lock( &( aData->mutexw ) );
+    if( aData->sec->error || aData->pri->error || aData->thr->error )
+    {
+        pthread_mutex_unlock( &( aData->mutexw ) );
+        return 1;
+    }
+    pthread_mutex_unlock( &( aData->mutexw ) );
+    return 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Check whether new scan is ready to S2Sdd_Begin
+ * @param *aData Pointer to dual buffer structure
+ * @param *aReader Pointer to reader of broadcast ring, or NULL for S2Sdd_Begin
+ * @return error: -1, not yet: 0, ready: 1
+ */
+/*--------------------------------------------------------------*/
+static int S2Sdd_IsReady( S2Sdd_t * aData, S2Reader_t * aReader )
+{
+    //! New scan is swapped in
+    int update;
+
+    if( S2Sdd_IsError( aData ) )
+        return -1;
+    if( aReader )
+        return __atomic_load_n( &( aData->ring.seq ), __ATOMIC_ACQUIRE ) > aReader->seq;
+    if( aData->lfactive )
+        return ( __atomic_load_n( &( aData->middle ), __ATOMIC_SEQ_CST ) & SCIP2_SDD_DIRTY ) != 0;
+    pthread_mutex_lock( &( aData->mutexw ) );
+    update = aData->update;
+    pthread_mutex_unlock( &( aData->mutexw ) );
+    return update;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Wait for new scan ( Blocking )
+ * @param *aData Pointer to dual buffer structure
+ * @param *aReader Pointer to reader of broadcast ring, or NULL for S2Sdd_Begin
+ * @param aTimeout Timeout in milliseconds ( negative: infinite )
+ * @return fatal error: -1, timeout: 0, new scan is ready: 1
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_WaitReady( S2Sdd_t * aData, S2Reader_t * aReader, int aTimeout )
+{
+    //! Time to give up
+    struct timespec limit;
+    //! Returned value
+    int ret;
+
+#ifdef __linux__
+    clock_gettime( CLOCK_MONOTONIC, &limit );
+#else
+    clock_gettime( CLOCK_REALTIME, &limit );
+#endif
+    limit.tv_sec += aTimeout / 1000;
+    limit.tv_nsec += ( long )( aTimeout % 1000 ) * 1000000;
+    if( limit.tv_nsec >= 1000000000 )
+    {
+        limit.tv_sec++;
+        limit.tv_nsec -= 1000000000;
+    }
+
+    //! Reciver signals only when someone is waiting
+    __atomic_add_fetch( &( aData->nwait ), 1, __ATOMIC_SEQ_CST );
+    pthread_mutex_lock( &( aData->mutexn ) );
+    while( ( ret = S2Sdd_IsReady( aData, aReader ) ) == 0 )
+    {
+        if( aTimeout < 0 )
+            pthread_cond_wait( &( aData->condn ), &( aData->mutexn ) );
+        else if( pthread_cond_timedwait( &( aData->condn ), &( aData->mutexn ), &limit ) == ETIMEDOUT )
+        {
+            ret = S2Sdd_IsReady( aData, aReader );
+            break;
+        }
+    }
+    pthread_mutex_unlock( &( aData->mutexn ) );
+    __atomic_sub_fetch( &( aData->nwait ), 1, __ATOMIC_SEQ_CST );
+
+    return ret;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Wait for new scan ( Blocking )
+ * @param *aData Pointer to dual buffer structure
+ * @param aTimeout Timeout in milliseconds ( negative: infinite )
+ * @return fatal error: -1, timeout: 0, new scan is ready to S2Sdd_Begin: 1
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_Wait( S2Sdd_t * aData, int aTimeout )
+{
+    return S2Sdd_WaitReady( aData, NULL, aTimeout );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get file descriptor which becomes readable when new scan is swapped in
+ * @param *aData Pointer to dual buffer structure
+ * @return unavailable: -1, succeeded: file descriptor for poll / select / epoll
+ * @attention Call S2Sdd_ClearEvent before S2Sdd_Begin to wait next scan.
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_GetEventFd( S2Sdd_t * aData )
+{
+    return aData->notify[0];
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Make file descriptor of S2Sdd_GetEventFd unreadable
+ * @param *aData Pointer to dual buffer structure
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_ClearEvent( S2Sdd_t * aData )
+{
+    //! Discarded counts
+    char buf[64];
+
+    if( aData->notify[0] < 0 )
+        return;
+    while( read( aData->notify[0], buf, sizeof ( buf ) ) > 0 )
+    {
+    }
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Notify waiting threads that new scan is swapped in or reciver stopped
+ * @param *aData Pointer to dual buffer structure
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_Notify( S2Sdd_t * aData )
+{
+#ifdef __linux__
+    //! Count added to eventfd
+    uint64_t count = 1;
+#else
+    //! Byte written to pipe
+    char count = 1;
+#endif
+    //! Returned value
+    int ret;
+
+    if( aData->notify[1] >= 0 )
+    {
+        //! Already readable if pipe is full
+        ret = write( aData->notify[1], &count, sizeof ( count ) );
+        ( void )ret;
+    }
+    if( __atomic_load_n( &( aData->nwait ), __ATOMIC_SEQ_CST ) > 0 )
+    {
+        pthread_mutex_lock( &( aData->mutexn ) );
+        pthread_cond_broadcast( &( aData->condn ) );
+        pthread_mutex_unlock( &( aData->mutexn ) );
+    }
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Reallocate buffers kept by S2Sdd_Reserve while they were in use
+ * @param *aData Pointer to dual buffer structure
+ * @attention Buffers still referenced or between S2Sdd_Begin and S2Sdd_End are skipped.
+ *            Must be called by consumer, with mutexw locked.
+ */
+/*--------------------------------------------------------------*/
+static void S2Sdd_Refit( S2Sdd_t * aData )
+{
+    //! Pointer to buffer
+    S2Scan_t *scan;
+    //! Loop valiant
+    int i;
+
+    for ( i = 0; i < aData->npool && aData->nstale > 0; i++ )
+    {
+        scan = &( aData->buf[i] );
+        if( scan->gen == aData->rgen || scan == __atomic_load_n( &( aData->held ), __ATOMIC_ACQUIRE )
+            || __atomic_load_n( &( scan->ref ), __ATOMIC_ACQUIRE ) > 0 )
+            continue;
+        if( !S2Sdd_Fits( aData, scan )
+            && !S2Scan_Alloc( scan, aData->rtype, aData->rplanar, aData->rsteptime, aData->rpoints,
+                              aData->rvalid, aData->rsize ) )
+        {
+            scan->error = 2;
+            continue;
+        }
+        __atomic_store_n( &( scan->gen ), aData->rgen, __ATOMIC_RELEASE );
+        __atomic_sub_fetch( &( aData->nstale ), 1, __ATOMIC_RELEASE );
+    }
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Reallocate buffers kept by S2Sdd_Reserve if there are
+ * @param *aData Pointer to dual buffer structure
+ * @attention Must be called by consumer.
+ */
+/*--------------------------------------------------------------*/
+static void S2Sdd_RefitStale( S2Sdd_t * aData )
+{
+    if( __atomic_load_n( &( aData->nstale ), __ATOMIC_ACQUIRE ) == 0 )
+        return;
+    pthread_mutex_lock( &( aData->mutexw ) );
+    S2Sdd_Refit( aData );
+    pthread_mutex_unlock( &( aData->mutexw ) );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Start using Data ( Non-Blocking )
+ * @param *aData Pointer to dual buffer structure
+ * @param **aScan Pointer to buffer structure handle
+ * @return failed: NULL, fatal error: -1, succeeded: Pointer to front buffer
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_Begin( S2Sdd_t * aData, S2Scan_t ** aScan )
+{
+    //! Index of buffer taken from middle
+    int mid;
+
+    if( aData->lfactive )
+    {
+        if( S2Sdd_LoadError( aData ) )
+            return -1;
+        if( !( __atomic_load_n( &( aData->middle ), __ATOMIC_RELAXED ) & SCIP2_SDD_DIRTY ) )
+            return 0;
+        //! Front buffer is fitted before given back
+        __atomic_store_n( &( aData->held ), NULL, __ATOMIC_RELEASE );
+        S2Sdd_RefitStale( aData );
+        //! Give back front buffer and take the latest scan, unless S2Sdd_Reserve took it back
+        mid = __atomic_load_n( &( aData->middle ), __ATOMIC_ACQUIRE );
+        do
+        {
+            if( !( mid & SCIP2_SDD_DIRTY ) )
+                return 0;
+        }
+        while( !__atomic_compare_exchange_n( &( aData->middle ), &mid, ( int )( aData->pri - aData->buf ),
+                                             0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) );
+        aData->pri = &( aData->buf[mid & ~SCIP2_SDD_DIRTY] );
+        __atomic_store_n( &( aData->held ), aData->pri, __ATOMIC_RELEASE );
+        *aScan = aData->pri;
+        return 1;
+    }
+
+    if( pthread_mutex_trylock( &( aData->mutexr ) ) != 0 )
+    {
+        return 0;
+    }
+    pthread_mutex_lock( &( aData->mutexw ) );
+    if( aData->nstale > 0 )
+        S2Sdd_Refit( aData );
+    if( aData->sec->error || aData->pri->error || aData->thr->error )
+    {
+        pthread_mutex_unlock( &( aData->mutexw ) );
+        pthread_mutex_unlock( &( aData->mutexr ) );
+        return -1;
+    }
+    if( aData->update )
+    {
+        aData->update = 0;
+        switch ( aData->nbuf )
+        {
+        case 2:
+            *aScan = aData->pri;
+            break;
+        case 3:
+            *aScan = aData->sec;
+            aData->sec = aData->pri;
+            aData->pri = *aScan;
+            break;
+        default:
+            pthread_mutex_unlock( &( aData->mutexw ) );
+            pthread_mutex_unlock( &( aData->mutexr ) );
+            return 0;
+        }
+        __atomic_store_n( &( aData->held ), *aScan, __ATOMIC_RELEASE );
+        pthread_mutex_unlock( &( aData->mutexw ) );
+        return 1;
+    }
+    pthread_mutex_unlock( &( aData->mutexw ) );
+    pthread_mutex_unlock( &( aData->mutexr ) );
+    return 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief End using Data
+ * @param *aData Pointer to dual buffer structure
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_End( S2Sdd_t * aData )
+{
+    __atomic_store_n( &( aData->held ), NULL, __ATOMIC_RELEASE );
+    S2Sdd_RefitStale( aData );
+    if( aData->lfactive )
+        return;
+    pthread_mutex_unlock( &( aData->mutexr ) );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Acquire latest scan and hold it until released ( Non-Blocking )
+ * @param *aData Pointer to dual buffer structure
+ * @param **aScan Pointer to buffer structure handle
+ * @return fatal error: -1, no new scan: 0, succeeded: 1
+ * @attention Scan must be released by S2Sdd_Release, and is never overwritten until then.
+ *            Reciver fills spare buffers of the pool instead, so that holding N scans
+ *            needs the pool of N + 2 buffers ( see S2Sdd_setPool ).
+ *            Scans not released are freed by S2Sdd_Dest.
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_Acquire( S2Sdd_t * aData, S2Scan_t ** aScan )
+{
+    //! Index of buffer taken from middle
+    int mid;
+
+    if( aData->lfactive )
+    {
+        if( S2Sdd_LoadError( aData ) )
+            return -1;
+        //! Give back front buffer and take the latest scan, unless S2Sdd_Reserve took it back
+        mid = __atomic_load_n( &( aData->middle ), __ATOMIC_ACQUIRE );
+        do
+        {
+            if( !( mid & SCIP2_SDD_DIRTY ) )
+                return 0;
+        }
+        while( !__atomic_compare_exchange_n( &( aData->middle ), &mid, ( int )( aData->pri - aData->buf ),
+                                             0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) );
+        aData->pri = &( aData->buf[mid & ~SCIP2_SDD_DIRTY] );
+        __atomic_add_fetch( &( aData->pri->ref ), 1, __ATOMIC_ACQ_REL );
+        *aScan = aData->pri;
+        return 1;
+    }
+
+    pthread_mutex_lock( &( aData->mutexw ) );
+    if( aData->sec->error || aData->pri->error || aData->thr->error )
+    {
+        pthread_mutex_unlock( &( aData->mutexw ) );
+        return -1;
+    }
+    if( !aData->update )
+    {
+        pthread_mutex_unlock( &( aData->mutexw ) );
+        return 0;
+    }
+    aData->update = 0;
+    //! Latest scan is front with 2 buffers ( GS ), and swapped to front with 3 buffers
+    *aScan = aData->pri;
+    if( aData->nbuf == 3 )
+    {
+        *aScan = aData->sec;
+        aData->sec = aData->pri;
+        aData->pri = *aScan;
+    }
+    __atomic_add_fetch( &( ( *aScan )->ref ), 1, __ATOMIC_ACQ_REL );
+    pthread_mutex_unlock( &( aData->mutexw ) );
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Release scan acquired by S2Sdd_Acquire
+ * @param *aData Pointer to dual buffer structure
+ * @param *aScan Pointer to acquired scan
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_Release( S2Sdd_t * aData, S2Scan_t * aScan )
+{
+    __atomic_sub_fetch( &( aScan->ref ), 1, __ATOMIC_RELEASE );
+    S2Sdd_RefitStale( aData );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Start thread which reads data of MS/GS command
+ * @param *aData Pointer to buffer structure
+ * @param *apPort Pointer to SCIP2.0 Device Port read by the thread
+ * @param *aFunc Thread function
+ * @return failed: 0, succeeded: 1
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_StartThread( S2Sdd_t * aData, S2Port * apPort, void *( *aFunc ) ( void * ) )
+{
+    //! Returned value
+    int ret;
+
+    //! Thread exiting by itself waits for its id to be stored
+    pthread_mutex_lock( &( aData->mutexw ) );
+    aData->port = apPort;
+    aData->stopreq = 0;
+    aData->joining = 0;
+    ret = pthread_create( &( aData->thread ), NULL, aFunc, ( void * )aData );
+    if( ret != 0 )
+        aData->thread = 0;
+    pthread_mutex_unlock( &( aData->mutexw ) );
+#ifdef SCIP2_DEBUG
+    if( ret != 0 )
+    {
+        fprintf( stderr, "SCIP2 ERROR: Failed to create reciver thread.\n" );
+        fflush( stderr );
+    }
+#endif											/* SCIP2_DEBUG */
+
+    return ret == 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief End reciver thread started by S2Sdd_StartThread
+ * @param *aData Pointer to buffer structure
+ * @attention Thread is detached unless S2Sdd_JoinThread is waiting for it.
+ */
+/*--------------------------------------------------------------*/
+static void S2Sdd_ExitThread( S2Sdd_t * aData )
+{
+    pthread_mutex_lock( &( aData->mutexw ) );
+    if( !aData->joining )
+    {
+        pthread_detach( aData->thread );
+        aData->thread = 0;
+    }
+    pthread_mutex_unlock( &( aData->mutexw ) );
+    pthread_exit( NULL );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Wait for reciver thread to end
+ * @param *aData Pointer to buffer structure
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_JoinThread( S2Sdd_t * aData )
+{
+    //! Thread to join
+    pthread_t thread;
+
+    pthread_mutex_lock( &( aData->mutexw ) );
+    thread = aData->thread;
+    aData->joining = ( thread != 0 );
+    pthread_mutex_unlock( &( aData->mutexw ) );
+    if( !thread )
+        return;
+
+    pthread_join( thread, NULL );
+    pthread_mutex_lock( &( aData->mutexw ) );
+    aData->thread = 0;
+    aData->joining = 0;
+    pthread_mutex_unlock( &( aData->mutexw ) );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Stop thread which reads data of MS/GS command
+ * @param *aData Pointer to buffer structure
+ * @attention Reciver waiting for the port is woken up at once, not canceled.
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_StopThread( S2Sdd_t * aData )
+{
+    //! Reciver thread is running
+    int running;
+
+    if( aData->reactor )
+        S2Reactor_Remove( aData->reactor, aData );
+    if( aData->gsactive )
+    {
+        pthread_mutex_lock( &( aData->mutexw ) );
+        aData->gsquit = 1;
+        pthread_cond_broadcast( &( aData->condg ) );
+        pthread_mutex_unlock( &( aData->mutexw ) );
+        pthread_join( aData->thread, NULL );
+        aData->thread = 0;
+        aData->gsactive = 0;
+        aData->gsquit = 0;
+    }
+
+    pthread_mutex_lock( &( aData->mutexw ) );
+    running = ( aData->thread != 0 );
+    __atomic_store_n( &( aData->stopreq ), 1, __ATOMIC_RELEASE );
+    pthread_mutex_unlock( &( aData->mutexw ) );
+    if( running )
+    {
+        Scip2_Wake( aData->port );
+        S2Sdd_JoinThread( aData );
+        Scip2_ClearWake( aData->port );
+    }
+
+    if( aData->executor )
+        S2Executor_Wait( aData->executor, aData );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Make GS / GD / GE command of the request
+ * @param *apMes Buffer of command ( SCIP2_MAX_LENGTH )
+ * @param *acpReq Pointer to parameters of the request
+ * @param aTag Tag appended to the command to match its echo back ( negative: no tag )
+ * @return failed: 0, succeeded: 1
+ */
+/*--------------------------------------------------------------*/
+static int S2Sdd_MakeGS( char *apMes, const S2GSReq_t * acpReq, int aTag )
+{
+    switch ( acpReq->enc )
+    {
+    case SCIP2_ENC_2BYTE:
+        sprintf( apMes, "GS%04d%04d%02d", acpReq->start, acpReq->end, acpReq->group );
+        break;
+    case SCIP2_ENC_3BYTE:
+        sprintf( apMes, "GD%04d%04d%02d", acpReq->start, acpReq->end, acpReq->group );
+        break;
+    case SCIP2_ENC_3X2BYTE:
+        sprintf( apMes, "GE%04d%04d%02d", acpReq->start, acpReq->end, acpReq->group );
+        break;
+    default:
+#ifdef SCIP2_DEBUG
+        fprintf( stderr, "SCIP2 ERROR: Unsupported encording type selected.\n" );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+        return 0;
+    }
+    if( aTag >= 0 )
+        sprintf( apMes + strlen( apMes ), ";%04X", aTag & 0xFFFF );
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get one scan replied to GS command and swap it to front
+ * @param *aData Pointer to dual buffer structure
+ * @param *aScan Pointer to buffer to fill
+ * @param *acpMes GS command already sent
+ * @return failed: 0, succeeded: 1
+ */
+/*--------------------------------------------------------------*/
+static int S2Sdd_RecvScan( S2Sdd_t * aData, S2Scan_t * aScan, const char *acpMes )
+{
+    //! Encode type of each value
+    S2EncType decenc;
+    //! Number of values par step
+    int multi;
+    //! Number of decoded data
+    int size;
+    //! Pointer to the line in ring buffer of port
+    char *line;
+    //! Length of the line
+    int len;
+    //! Returned value
+    int ret;
+    //! Remains value of line
+    unsigned long value;
+    //! Number of remains value of line
+    int nrem;
+
+    pthread_mutex_lock( &( aScan->mutex ) );
+
+    ret = Scip2_RecvEcho( aScan->port, acpMes );
+    if( ret != 0 )
+    {
+        aScan->error = 2;
+        pthread_mutex_unlock( &( aScan->mutex ) );
+        S2Sdd_Notify( aData );
+        return 0;
+    }
+    clock_gettime( CLOCK_MONOTONIC, &( aData->clock.arrival ) );
+
+    value = 0;
+    nrem = 0;
+    aScan->nbadsum = 0;
+    //! Start reading
+    ret = -1;
+    line = Scip2_RecvLine( aScan->port, &len );
+    if( line )
+        ret = Scip2_DecodeLineSum( line, len, &aScan->time, SCIP2_VAL_ULONG, 1, SCIP2_ENC_4BYTE, &value, &nrem,
+                                   aScan->port->checksum ? &aScan->nbadsum : NULL );
+    if( ret != 1 )
+    {
+#ifdef SCIP2_DEBUG
+        fprintf( stderr, "SCIP2 ERROR: Failed to recive time stamp.\n" );
+        fflush( stderr );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+        aScan->error = 1;
+        pthread_mutex_unlock( &( aScan->mutex ) );
+        S2Sdd_Notify( aData );
+        return 0;
+    }
+    S2Sdd_Stamp( aData, aScan );
+    S2Sdd_StampSteps( aData, aScan );
+#ifdef SCIP2_DEBUG_ALL
+    fprintf( stderr, "SCIP2 INFO: Reciving data at %d.\n", ( int )aScan->time );
+    fflush( stderr );
+#endif											/* SCIP2_DEBUG_ALL */
+    decenc = aScan->enc;
+    multi = 1;
+    if( aScan->enc == SCIP2_ENC_3X2BYTE )
+    {
+        decenc = SCIP2_ENC_3BYTE;
+        multi = 2;
+    }
+    value = 0;
+    nrem = 0;
+    size = 0;
+    do
+    {
+        ret = -1;
+        line = Scip2_RecvLine( aScan->port, &len );
+        if( line )
+            ret = S2Scan_DecodeLine( aScan, line, len, &size, decenc, &value, &nrem );
+    }
+    while( ret > 0 );
+    if( ret == -1 && line )
+        Scip2_SendTerm( aScan->port );
+
+    if( ret == -1 )
+    {
+        aScan->error = 1;
+        pthread_mutex_unlock( &( aScan->mutex ) );
+        S2Sdd_Notify( aData );
+        return 0;
+    }
+    aScan->size = size;
+    aScan->nstep = size / multi;
+    S2Sdd_MarkDecode( aData, aScan );
+    S2Sdd_ToPoints( aData, aScan );
+#ifdef SCIP2_DEBUG_ALL
+    fprintf( stderr, "SCIP2 INFO: %d steps recived.\n", aScan->size );
+    fflush( stderr );
+#endif											/* SCIP2_DEBUG_ALL */
+
+    pthread_mutex_unlock( &( aScan->mutex ) );
+
+    //! run callback function
+    aScan->seq = aData->ring.seq + 1;
+    S2Sdd_RunCallback( aData, aScan, 1 );
+
+    //! swap buffer
+    clock_gettime( CLOCK_MONOTONIC, &( aScan->tpublish ) );
+    pthread_mutex_lock( &( aData->mutexw ) );
+    aData->sec = aData->pri;
+    aData->pri = aScan;
+    aData->update = 1;
+    pthread_mutex_unlock( &( aData->mutexw ) );
+    S2Sdd_CountPublish( aData, aScan );
+    S2Ring_Put( &( aData->ring ), aScan );
+    S2Sdd_Notify( aData );
+    S2Sdd_PostCallback( aData, aScan );
+
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get Scanned data
+ * @param *aArg Pointer to dual buffer structure
+ */
+/*--------------------------------------------------------------*/
+void *S2Sdd_RecvData( void *aArg )
+{
+    //! Pointer to dual buffer structure
+    S2Sdd_t *data;
+    //! Pointer to front buffer
+    S2Scan_t *scan;
+    //! Parameters of the request
+    S2GSReq_t req;
+    //! Send Buffer
+    char buf[SCIP2_MAX_LENGTH];
+    //! Error code of sending
+    int error;
+
+    data = ( S2Sdd_t * ) aArg;
+
+    pthread_mutex_lock( &( data->mutexw ) );
+    scan = S2Sdd_TakeFree( data, data->sec );
+    if( scan )
+        data->sec = scan;
+    pthread_mutex_unlock( &( data->mutexw ) );
+    if( scan == NULL )
+    {
+        __atomic_add_fetch( &( data->ndrop ), 1, __ATOMIC_RELAXED );
+        S2Sdd_Notify( data );
+        S2Sdd_ExitThread( data );
+    }
+
+    pthread_mutex_lock( &( scan->mutex ) );
+    req.port = scan->port;
+    req.start = scan->start;
+    req.end = scan->end;
+    req.group = scan->group;
+    req.enc = scan->enc;
+    error = 0;
+    if( !S2Sdd_MakeGS( buf, &req, -1 ) )
+        error = 1;
+    else if( Scip2_SendNoWait( req.port, buf ) != 0 )
+        error = 2;
+    if( error )
+        scan->error = error;
+    pthread_mutex_unlock( &( scan->mutex ) );
+
+    if( error )
+        S2Sdd_Notify( data );
+    else
+        S2Sdd_RecvScan( data, scan, buf );
+
+    S2Sdd_ExitThread( data );
+    return 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get Scanned data for each GS request until the worker is stopped
+ * @param *aArg Pointer to dual buffer structure
+ * @attention Up to gsdepth requests are sent before their replies are read.
+ */
+/*--------------------------------------------------------------*/
+void *S2Sdd_RecvDataWorker( void *aArg )
+{
+    //! Pointer to dual buffer structure
+    S2Sdd_t *data;
+    //! Pointer to front buffer
+    S2Scan_t *scan;
+    //! Parameters of the request
+    S2GSReq_t req;
+    //! Number of requests sent
+    int sent;
+    //! Send Buffer
+    char buf[SCIP2_MAX_LENGTH];
+
+    data = ( S2Sdd_t * ) aArg;
+
+    pthread_mutex_lock( &( data->mutexw ) );
+    sent = data->gsdone;
+    while( 1 )
+    {
+        while( data->gsdone == data->gsreq && !data->gsquit )
+            pthread_cond_wait( &( data->condg ), &( data->mutexw ) );
+        //! Requests not sent yet are dropped, replies in flight are read
+        if( data->gsquit )
+            data->gsreq = sent;
+        if( data->gsdone == data->gsreq )
+            break;
+
+        //! Keep requests in flight
+        while( sent < data->gsreq && sent - data->gsdone < data->gsdepth )
+        {
+            req = data->gsq[sent % SCIP2_GS_QUEUE];
+            pthread_mutex_unlock( &( data->mutexw ) );
+            if( S2Sdd_MakeGS( buf, &req, sent ) )
+                Scip2_SendNoWait( req.port, buf );
+            pthread_mutex_lock( &( data->mutexw ) );
+            sent++;
+        }
+        req = data->gsq[data->gsdone % SCIP2_GS_QUEUE];
+        pthread_mutex_unlock( &( data->mutexw ) );
+
+        //! Buffers are reallocated only if the request became larger
+        scan = NULL;
+        if( S2Sdd_MakeGS( buf, &req, data->gsdone )
+            && S2Sdd_Reserve( data, ( req.end - req.start ) / req.group + 1, req.enc ) )
+        {
+            pthread_mutex_lock( &( data->mutexw ) );
+            scan = S2Sdd_TakeFree( data, data->sec );
+            if( scan )
+                data->sec = scan;
+            else
+                __atomic_add_fetch( &( data->ndrop ), 1, __ATOMIC_RELAXED );
+            pthread_mutex_unlock( &( data->mutexw ) );
+        }
+        if( scan )
+        {
+            pthread_mutex_lock( &( scan->mutex ) );
+            scan->port = req.port;
+            scan->start = req.start;
+            scan->end = req.end;
+            scan->group = req.group;
+            scan->enc = req.enc;
+            pthread_mutex_unlock( &( scan->mutex ) );
+
+            S2Sdd_RecvScan( data, scan, buf );
+        }
+        else
+        {
+            S2Sdd_Notify( data );
+        }
+
+        pthread_mutex_lock( &( data->mutexw ) );
+        data->gsdone++;
+        pthread_cond_broadcast( &( data->condg ) );
+    }
+    pthread_mutex_unlock( &( data->mutexw ) );
+
+    return NULL;
+}
+
+
+
+#if defined(SCIP2_DEBUG_ALL) || defined(SCIP2_OUTPUT_CONTDATA)
+char errbuf[2][8192];
+int nerrbuf;
+char *perrbuf;
+char *perrbuf2;
+#endif										/* SCIP2_DEBUG_ALL */
+
+
+
+#ifdef SCIP2_OUTPUT_CONTDATA
+/*--------------------------------------------------------------*/
+/**
+ * @brief Keep recived line to dump on error
+ * @param *apLine Pointer to the line
+ * @param aLen Length of the line
+ */
+/*--------------------------------------------------------------*/
+static void S2Sdd_DumpLine( const char *apLine, int aLen )
+{
+    if( perrbuf + aLen >= errbuf[( nerrbuf + 1 ) & 1] + sizeof ( errbuf[0] ) )
+        return;
+    memcpy( perrbuf, apLine, aLen );
+    perrbuf += aLen;
+    *perrbuf = 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Dump recived lines of last two scans
+ * @param *aData Pointer to dual buffer structure
+ */
+/*--------------------------------------------------------------*/
+static void S2Sdd_DumpError( S2Sdd_t * aData )
+{
+    fprintf( stderr,
+             "SCIP2 ERROR: %d: sz:%d,scaned:%d\n-------DUMP-------\n%s\n-----------------\n%s\n-----------------\n",
+             getpid(  ), ( int )aData->thr->memsize, aData->nvalue,
+             errbuf[( nerrbuf + 1 ) & 1], errbuf[nerrbuf] );
+    fflush( stderr );
+}
+#endif										/* SCIP2_OUTPUT_CONTDATA */
 
-        if( scan->memsize < ( scan->end - scan->start + 1 ) * multi / scan->group + 1024 )
-        {
-            if( scan->data )
-                free( scan->data );
-            scan->memsize = ( int )( scan->end - scan->start + 1 ) * multi / scan->group + 1024;
-            scan->data = ( unsigned long * )malloc( sizeof ( unsigned long ) * scan->memsize );
-            if( scan->data == 0 )
-            {
-#ifdef SCIP2_DEBUG
-                fprintf( stderr, "SCIP2 ERROR: malloc failed.\n" );
-                fflush( stderr );
-#endif											/* SCIP2_DEBUG */
-                scan->memsize = -1;
-                scan->error = 2;
-                pthread_mutex_unlock( &( scan->mutex ) );
-                pthread_testcancel(  );
-                pthread_detach( data->thread );
-                pthread_exit( NULL );
-            }
-        }
 
-        pos = scan->data;
-        buf[0] = 0;
-        ret = fgets( buf, SCIP2_MAX_LENGTH, scan->port );
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Prepare line parser for continuous scanning
+ * @param *aData Pointer to dual buffer structure
+ * @return failed: 0, succeeded: 1
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_InitCont( S2Sdd_t * aData )
+{
+    //! Pointer to back buffer
+    S2Scan_t *scan;
+
+    pthread_mutex_lock( &( aData->mutexw ) );
+    scan = S2Sdd_TakeFree( aData, aData->thr );
+    if( scan == NULL )
+    {
+        aData->thr->error = 2;
+        pthread_mutex_unlock( &( aData->mutexw ) );
+        return 0;
+    }
+    aData->thr = scan;
+    aData->multi = 1;
+    aData->decenc = scan->enc;
+    switch ( scan->enc )
+    {
+    case SCIP2_ENC_2BYTE:
+    case SCIP2_ENC_3BYTE:
+        break;
+    case SCIP2_ENC_3X2BYTE:
+        aData->decenc = SCIP2_ENC_3BYTE;
+        aData->multi = 2;
+        break;
+    default:
+        scan->error = 2;
+        pthread_mutex_unlock( &( aData->mutexw ) );
+        return 0;
+    }
+    pthread_mutex_unlock( &( aData->mutexw ) );
+
+    //! Echo back is the command without number of scans, which is replaced by remains
+    aData->meslen = strlen( aData->cmd ) - 2;
+    if( aData->meslen < 2 )
+    {
+        scan->error = 2;
+        return 0;
+    }
+    memcpy( aData->mes, aData->cmd, aData->meslen );
+    aData->mes[aData->meslen] = 0;
+    aData->state = SCIP2_RECV_ECHO;
+    aData->nvalue = 0;
+    aData->cbstop = 0;
+    aData->down = 0;
+    //! Lines of two scans ( 64 characters par line, echo, status, time stamp and LF )
+    aData->nskipmax = 2 * ( aData->rsize * aData->decenc / 64 + 5 );
 #ifdef SCIP2_OUTPUT_CONTDATA
-        memcpy( perrbuf, buf, strlen( buf ) );
-        perrbuf += strlen( buf );
-        *perrbuf = 0;
+    nerrbuf = 0;
+    perrbuf = errbuf[0];
+    *perrbuf = 0;
 #endif
-        if( ret == NULL )
+
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Give up the scan being recived because of invalid line
+ * @param *aData Pointer to dual buffer structure
+ * @param aError Error code of the scan
+ * @param aLen Length of the invalid line ( 0: no line to skip )
+ * @return resynchronizing: 1, error: -1
+ * @attention Back buffer is marked as error unless scanning is resynchronized or recovered.
+ */
+/*--------------------------------------------------------------*/
+static int S2Sdd_ContError( S2Sdd_t * aData, int aError, int aLen )
+{
+    if( aData->resync && aLen > 0 )
+    {
+        //! Skip lines until next echo back
+        __atomic_add_fetch( &( aData->nbadframe ), 1, __ATOMIC_RELAXED );
+        __atomic_add_fetch( &( aData->ndiscard ), aLen, __ATOMIC_RELAXED );
+        aData->nskip = 0;
+        aData->state = SCIP2_RECV_RESYNC;
+        return 1;
+    }
+    if( !aData->recover || aData->reactor )
+        __atomic_store_n( &( aData->thr->error ), aError, __ATOMIC_RELEASE );
+    return -1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Check echo back of continuous scanning
+ * @param *aData Pointer to dual buffer structure
+ * @param *apLine Pointer to the line
+ * @param aLen Length of the line without LF
+ * @return invalid: 0, valid: 1
+ */
+/*--------------------------------------------------------------*/
+static int S2Sdd_IsEcho( S2Sdd_t * aData, const char *apLine, int aLen )
+{
+    if( aLen != aData->meslen + 2 || memcmp( apLine, aData->mes, aData->meslen ) != 0 )
+        return 0;
+    if( apLine[aData->meslen] < '0' || apLine[aData->meslen] > '9'
+        || apLine[aData->meslen + 1] < '0' || apLine[aData->meslen + 1] > '9' )
+        return 0;
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Record length of outage when scan is published after recovery
+ * @param *aData Pointer to dual buffer structure
+ */
+/*--------------------------------------------------------------*/
+static void S2Sdd_EndOutage( S2Sdd_t * aData )
+{
+    //! Current time
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    __atomic_store_n( &( aData->outage ), ( now.tv_sec - aData->lost.tv_sec ) * 1000
+                      + ( now.tv_nsec - aData->lost.tv_nsec ) / 1000000, __ATOMIC_RELAXED );
+    aData->down = 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Make command to re-issue continuous scanning
+ * @param *aData Pointer to dual buffer structure
+ * @param *apCmd Pointer to command buffer ( SCIP2_MAX_LENGTH )
+ * @return no scan remains: 0, succeeded: 1
+ */
+/*--------------------------------------------------------------*/
+static int S2Sdd_RemainCmd( S2Sdd_t * aData, char *apCmd )
+{
+    strcpy( apCmd, aData->cmd );
+    if( aData->thr->num != 0 )
+    {
+        if( aData->remnum == 0 )
+            return 0;
+        //! Request only remains
+        apCmd[aData->meslen] = '0' + aData->remnum / 10;
+        apCmd[aData->meslen + 1] = '0' + aData->remnum % 10;
+    }
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Restart continuous scanning broken by invalid line
+ * @param *aData Pointer to dual buffer structure
+ * @return stopped: 0, restarted: 1
+ * @attention Retried every SCIP2_RECOVER_INTERVAL ms until restarted or S2Sdd_StopThread is called.
+ */
+/*--------------------------------------------------------------*/
+static int S2Sdd_Recover( S2Sdd_t * aData )
+{
+    //! Pointer to SCIP2.0 Device Port
+    S2Port *port;
+    //! Command to re-issue
+    char cmd[SCIP2_MAX_LENGTH];
+    //! Wake up pipe of the port
+    struct pollfd wake;
+
+    port = aData->thr->port;
+    //! Broken scan was the last one
+    if( !S2Sdd_RemainCmd( aData, cmd ) )
+        return 0;
+    if( !aData->down )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &aData->lost );
+        aData->down = 1;
+    }
+
+    wake.fd = port->wake[0];
+    wake.events = POLLIN;
+    while( !__atomic_load_n( &( aData->stopreq ), __ATOMIC_ACQUIRE ) )
+    {
+#ifdef SCIP2_DEBUG
+        fprintf( stderr, "SCIP2 INFO: Restarting \"%s\".\n", cmd );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+        //! Stop scanning, discard the rest of stream and start again
+        Scip2_Flush( port );
+        if( Scip2_SendNoWait( port, "QT" ) == 0 && Scip2_RecvEcho( port, "QT" ) == 0 && Scip2_RecvTerm( port ) &&
+            Scip2_SendNoWait( port, cmd ) == 0 && Scip2_RecvEcho( port, cmd ) == 0 && Scip2_RecvTerm( port ) )
         {
+            __atomic_add_fetch( &( aData->nreconnect ), 1, __ATOMIC_RELAXED );
+            aData->state = SCIP2_RECV_ECHO;
+            aData->nvalue = 0;
+            return 1;
+        }
+        poll( &wake, 1, SCIP2_RECOVER_INTERVAL );
+    }
+    return 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Synchronize clock model between scans of continuous scanning
+ * @param *aData Pointer to dual buffer structure
+ * @return failed: -1, no scan remains: 0, restarted: 1
+ * @attention Scanning is stopped by QT, synchronized by TM and re-issued.
+ */
+/*--------------------------------------------------------------*/
+static int S2Sdd_ClockSync( S2Sdd_t * aData )
+{
+    //! Pointer to SCIP2.0 Device Port
+    S2Port *port;
+    //! Command to re-issue
+    char cmd[SCIP2_MAX_LENGTH];
+
+    port = aData->thr->port;
+    if( !S2Sdd_RemainCmd( aData, cmd ) )
+        return 0;
+
+    Scip2_Flush( port );
+    if( Scip2_SendNoWait( port, "QT" ) != 0 || Scip2_RecvEcho( port, "QT" ) != 0 || !Scip2_RecvTerm( port ) )
+        return -1;
+    if( !S2Clock_Sync( &( aData->clock ), port ) )
+    {
 #ifdef SCIP2_DEBUG
-            fprintf( stderr, "SCIP2 ERROR: %d: Failed to read echo back message.\n", pid );
-            fflush( stderr );
+        fprintf( stderr, "SCIP2 ERROR: Failed to synchronize clock.\n" );
+        fflush( stderr );
 #endif											/* SCIP2_DEBUG */
+    }
+    if( Scip2_SendNoWait( port, cmd ) != 0 || Scip2_RecvEcho( port, cmd ) != 0 || !Scip2_RecvTerm( port ) )
+        return -1;
+    aData->state = SCIP2_RECV_ECHO;
+    aData->nvalue = 0;
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Parse one line of continuous scanning
+ * @param *aData Pointer to dual buffer structure
+ * @param *apLine Pointer to the line ( NULL if failed to recive )
+ * @param aLen Length of the line including LF
+ * @return error: -1, stop scanning: 0, continue: 1
+ * @attention Buffer of back side ( thr ) is owned by reciver until it is swapped,
+ *            so that it is filled without locking.
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_ParseCont( S2Sdd_t * aData, char *apLine, int aLen )
+{
+    //! Pointer to back buffer
+    S2Scan_t *scan;
+    //! Returned status number
+    int status;
+    //! Number of decoded data
+    int nlines;
+    //! Index of buffer taken from middle
+    int mid;
+    //! Index of back buffer published to middle
+    int back;
+    //! Buffer to fill next
+    S2Scan_t *next;
+    //! Length of the line without LF
+    int len;
+
+    scan = aData->thr;
 #ifdef SCIP2_OUTPUT_CONTDATA
-            fprintf( stderr,
-                     "SCIP2 ERROR: %d: sz:%d,scaned:%d\n-------DUMP-------\n%s\n-----------------\n%s\n-----------------\n",
-                     pid, ( int )scan->memsize, pos - scan->data, errbuf[( nerrbuf + 1 ) & 1], errbuf[nerrbuf] );
-            fflush( stderr );
+    if( aData->state == SCIP2_RECV_ECHO )
+    {
+        perrbuf = errbuf[nerrbuf];
+        nerrbuf = ( nerrbuf + 1 ) & 1;
+        perrbuf2 = errbuf[nerrbuf];
+        *perrbuf = 0;
+    }
+    if( apLine )
+        S2Sdd_DumpLine( apLine, aLen );
 #endif
-            scan->error = 2;
-            pthread_mutex_unlock( &( scan->mutex ) );
-            pthread_testcancel(  );
-            pthread_detach( data->thread );
-            pthread_exit( NULL );
-        }
-        strtok_r( buf, "\n", &ptr );
-        if( strlen( buf ) < 15 )
+
+    switch ( aData->state )
+    {
+    case SCIP2_RECV_ECHO:
+    case SCIP2_RECV_RESYNC:
+        aData->nvalue = 0;
+
+        if( apLine == NULL )
         {
 #ifdef SCIP2_DEBUG
-            fprintf( stderr, "SCIP2 ERROR: %d:  Invalid echo back returns \"%s\" \"%s\".\n", pid, buf, mes );
+            fprintf( stderr, "SCIP2 ERROR: %d: Failed to read echo back message.\n", getpid(  ) );
             fflush( stderr );
 #endif											/* SCIP2_DEBUG */
 #ifdef SCIP2_OUTPUT_CONTDATA
-            fprintf( stderr,
-                     "SCIP2 ERROR: %d: sz:%d,scaned:%d\n-------DUMP-------\n%s\n-----------------\n%s\n-----------------\n",
-                     pid, ( int )scan->memsize, pos - scan->data, errbuf[( nerrbuf + 1 ) & 1], errbuf[nerrbuf] );
-            fflush( stderr );
+            S2Sdd_DumpError( aData );
 #endif
-            scan->error = 2;
-            pthread_mutex_unlock( &( scan->mutex ) );
-            pthread_testcancel(  );
-            pthread_detach( data->thread );
-            pthread_exit( NULL );
+            return S2Sdd_ContError( aData, 2, 0 );
         }
-
-        rem[0] = buf[13];
-        rem[1] = buf[14];
-        rem[2] = 0;
-        remnum = atoi( rem );
-        buf[13] = 0;
-
-        if( strcmp( buf, mes ) != 0 )
+        len = aLen;
+        if( apLine[len - 1] == '\n' )
+            len--;
+        if( !S2Sdd_IsEcho( aData, apLine, len ) )
         {
-            buf[13] = rem[0];
+            if( aData->state == SCIP2_RECV_RESYNC )
+            {
+                //! Give up when echo back is not found in a few scans
+                __atomic_add_fetch( &( aData->ndiscard ), aLen, __ATOMIC_RELAXED );
+                aData->nskip++;
+                if( aData->nskip <= aData->nskipmax )
+                    return 1;
+                aData->state = SCIP2_RECV_ECHO;
+                return S2Sdd_ContError( aData, 2, 0 );
+            }
 #ifdef SCIP2_DEBUG
-            fprintf( stderr, "SCIP2 ERROR: %d: Invalid echo back returns \"%s\" \"%s\".\n", pid, buf, mes );
+            fprintf( stderr, "SCIP2 ERROR: %d: Invalid echo back returns \"%.*s\" \"%s\".\n",
+                     getpid(  ), len, apLine, aData->mes );
             fflush( stderr );
 #endif											/* SCIP2_DEBUG */
 #ifdef SCIP2_OUTPUT_CONTDATA
-            fprintf( stderr,
-                     "SCIP2 ERROR: %d: sz:%d,scaned:%d\n-------DUMP-------\n%s\n-----------------\n%s\n-----------------\n",
-                     pid, ( int )scan->memsize, pos - scan->data, errbuf[( nerrbuf + 1 ) & 1], errbuf[nerrbuf] );
-            fflush( stderr );
+            S2Sdd_DumpError( aData );
 #endif
-            scan->error = 2;
-            pthread_mutex_unlock( &( scan->mutex ) );
-            pthread_testcancel(  );
-            pthread_detach( data->thread );
-            pthread_exit( NULL );
+            return S2Sdd_ContError( aData, 2, aLen );
         }
+        clock_gettime( CLOCK_MONOTONIC, &( aData->clock.arrival ) );
+        aData->remnum = ( apLine[aData->meslen] - '0' ) * 10 + ( apLine[aData->meslen + 1] - '0' );
+        aData->state = SCIP2_RECV_STATUS;
+        return 1;
 
-        ret = fgets( buf, SCIP2_MAX_LENGTH, scan->port );
-#ifdef SCIP2_OUTPUT_CONTDATA
-        memcpy( perrbuf, buf, strlen( buf ) );
-        perrbuf += strlen( buf );
-        *perrbuf = 0;
-#endif
-        if( ret == NULL )
+    case SCIP2_RECV_STATUS:
+        if( apLine == NULL )
         {
 #ifdef SCIP2_DEBUG
-            fprintf( stderr, "SCIP2 ERROR: %d: Failed to read status.\n", pid );
+            fprintf( stderr, "SCIP2 ERROR: %d: Failed to read status.\n", getpid(  ) );
             fflush( stderr );
 #endif											/* SCIP2_DEBUG */
 #ifdef SCIP2_OUTPUT_CONTDATA
-            fprintf( stderr,
-                     "SCIP2 ERROR: %d: sz:%d,scaned:%d\n-------DUMP-------\n%s\n-----------------\n%s\n-----------------\n",
-                     pid, ( int )scan->memsize, pos - scan->data, errbuf[( nerrbuf + 1 ) & 1], errbuf[nerrbuf] );
-            fflush( stderr );
+            S2Sdd_DumpError( aData );
 #endif
-            scan->error = 2;
-            pthread_mutex_unlock( &( scan->mutex ) );
-            pthread_testcancel(  );
-            pthread_detach( data->thread );
-            pthread_exit( NULL );
+            return S2Sdd_ContError( aData, 2, 0 );
         }
 #ifdef SCIP2_DEBUG_ALL
-        fprintf( stderr, "D:%s", buf );
+        fprintf( stderr, "D:%.*s", aLen, apLine );
         fflush( stderr );
 #endif											/* SCIP2_DEBUG_ALL */
-        if( strlen( buf ) == 1 )
+        if( aLen < 3 )
         {
-            scan->error = 1;
-            pthread_mutex_unlock( &( scan->mutex ) );
-            pthread_testcancel(  );
-            pthread_detach( data->thread );
-            pthread_exit( NULL );
+            return S2Sdd_ContError( aData, 1, aLen );
         }
-        status = ( buf[0] - '0' ) * 10 + ( buf[1] - '0' );
-        if( buf[0] < '0' || buf[1] < '0' || buf[0] > '9' || buf[1] > '9' )
+        status = ( apLine[0] - '0' ) * 10 + ( apLine[1] - '0' );
+        if( apLine[0] < '0' || apLine[1] < '0' || apLine[0] > '9' || apLine[1] > '9' )
         {
-            status = -( int )( ( unsigned )buf[0] * 0x100 + ( unsigned )buf[1] );
+            status = -( int )( ( unsigned )apLine[0] * 0x100 + ( unsigned )apLine[1] );
+#ifdef SCIP2_DEBUG
             if( status < -( '0' * 0x100 + 'I' ) )
             {
-                fprintf( stderr, "SCIP2 FATAL ERROR: Sensor is update mode (%d).\n", status );
+                fprintf( stderr, "SCIP2 ERROR: Sensor is update mode (%d).\n", status );
                 fflush( stderr );
-                Scip2_Flush( scan->port );
-                Scip2CMD_RS( scan->port );
-                exit( 1 );
             }
+#endif											/* SCIP2_DEBUG */
+            //! Status broken by line noise ( sensor in update mode sends no more echo back )
+            return S2Sdd_ContError( aData, 1, aLen );
         }
-#ifdef SCIP2_ENABLE_CHECKSUM
-        sum = ( buf[0] + buf[1] ) & 0x3F + 0x30;
-        if( sum != buf[2] )
+        if( scan->port->checksum && !Scip2_CheckSum( apLine, 3 ) )
         {
 #ifdef SCIP2_DEBUG
             fprintf( stderr, "SCIP2 ERROR: Checksum mismatch.\n" );
             fflush( stderr );
 #endif											/* SCIP2_DEBUG */
-            scan->error = 2;
-            pthread_mutex_unlock( &( scan->mutex ) );
-            pthread_testcancel(  );
-            pthread_detach( data->thread );
-            pthread_exit( NULL );
+            return S2Sdd_ContError( aData, 2, aLen );
         }
-#endif											/* SCIP2_ENABLE_CHECKSUM */
         if( status != 99 )
         {
 #ifdef SCIP2_DEBUG
             fprintf( stderr, "SCIP2 ERROR: error status recived (%d).\n", status );
             fflush( stderr );
 #endif											/* SCIP2_DEBUG */
-            scan->error = 1;
-            pthread_mutex_unlock( &( scan->mutex ) );
-            pthread_testcancel(  );
-            pthread_detach( data->thread );
-            pthread_exit( NULL );
+            return S2Sdd_ContError( aData, 1, 0 );
         }
+        aData->state = SCIP2_RECV_TIME;
+        return 1;
 
-        value = 0;
-        nrem = 0;
-        //! Start reading
-        nlines = Scip2_RecvEncodedLine( scan->port, &scan->time, 1, SCIP2_ENC_4BYTE, &value, &nrem );
-#ifdef SCIP2_OUTPUT_CONTDATA
-        memcpy( perrbuf, scip2_debuf, strlen( scip2_debuf ) );
-        perrbuf += strlen( scip2_debuf );
-        *perrbuf = 0;
-#endif
-
+    case SCIP2_RECV_TIME:
+        aData->value = 0;
+        aData->nrem = 0;
+        scan->nbadsum = 0;
+        nlines = -1;
+        if( apLine )
+            nlines = Scip2_DecodeLineSum( apLine, aLen, &scan->time, SCIP2_VAL_ULONG, 1, SCIP2_ENC_4BYTE,
+                                          &aData->value, &aData->nrem, scan->port->checksum ? &scan->nbadsum : NULL );
         if( nlines != 1 )
         {
 #ifdef SCIP2_DEBUG
@@ -651,109 +2240,157 @@ void *S2Sdd_RecvDataCont( void *aArg )
             fflush( stderr );
 #endif											/* SCIP2_DEBUG */
 #ifdef SCIP2_OUTPUT_CONTDATA
-            fprintf( stderr,
-                     "SCIP2 ERROR: %d: sz:%d,scaned:%d\n-------DUMP-------\n%s\n-----------------\n%s\n-----------------\n",
-                     pid, ( int )scan->memsize, pos - scan->data, errbuf[( nerrbuf + 1 ) & 1], errbuf[nerrbuf] );
-            fflush( stderr );
+            S2Sdd_DumpError( aData );
 #endif
-            scan->error = 1;
-            pthread_mutex_unlock( &( scan->mutex ) );
-            pthread_testcancel(  );
-            pthread_detach( data->thread );
-            pthread_exit( NULL );
+            return S2Sdd_ContError( aData, 1, apLine ? aLen : 0 );
         }
+        S2Sdd_Stamp( aData, scan );
+        S2Sdd_StampSteps( aData, scan );
 #ifdef SCIP2_DEBUG_ALL
-        fprintf( stderr, "SCIP2 INFO: %d: Reciving data at %d.\n", pid, ( int )scan->time );
+        fprintf( stderr, "SCIP2 INFO: %d: Reciving data at %d.\n", getpid(  ), ( int )scan->time );
 #endif											/* SCIP2_DEBUG_ALL */
-        if( scan->memsize < ( scan->end - scan->start + 1 ) * multi / scan->group )
-        {
-            if( scan->data )
-                free( scan->data );
-            scan->memsize = ( scan->end - scan->start + 1 ) * multi / scan->group + 8;
-            scan->data = ( unsigned long * )malloc( sizeof ( unsigned long ) * scan->memsize );
-            if( scan->data == 0 )
-            {
-#ifdef SCIP2_DEBUG
-                fprintf( stderr, "SCIP2 ERROR: malloc failed.\n" );
-                fflush( stderr );
-#endif											/* SCIP2_DEBUG */
-                scan->memsize = -1;
-                scan->error = 1;
-                pthread_mutex_unlock( &( scan->mutex ) );
-                pthread_testcancel(  );
-                pthread_detach( data->thread );
-                pthread_exit( NULL );
-            }
-        }
-        value = 0;
-        nrem = 0;
-        pos = scan->data;
-
-        while( ( nlines =
-                 Scip2_RecvEncodedLine( scan->port, pos,
-                                        scan->memsize - ( pos - scan->data ), enc, &value, &nrem ) ) > 0 )
-        {
+        aData->value = 0;
+        aData->nrem = 0;
+        aData->nvalue = 0;
+        aData->state = SCIP2_RECV_DATA;
+        return 1;
 
-#ifdef SCIP2_OUTPUT_CONTDATA
-            memcpy( perrbuf, scip2_debuf, strlen( scip2_debuf ) );
-            perrbuf += strlen( scip2_debuf );
-            *perrbuf = 0;
-#endif
-            pos += nlines;
-        }
-#ifdef SCIP2_OUTPUT_CONTDATA
-        memcpy( perrbuf, scip2_debuf, strlen( scip2_debuf ) );
-        perrbuf += strlen( scip2_debuf );
-        *perrbuf = 0;
-#endif
+    case SCIP2_RECV_DATA:
+        nlines = -1;
+        if( apLine )
+            nlines = S2Scan_DecodeLine( scan, apLine, aLen, &aData->nvalue,
+                                        aData->decenc, &aData->value, &aData->nrem );
+        if( nlines > 0 )
+            return 1;
         if( nlines < 0 )
         {
 #ifdef SCIP2_OUTPUT_CONTDATA
-            fprintf( stderr,
-                     "SCIP2 ERROR: %d: sz:%d,scaned:%d\n-------DUMP-------\n%s\n-----------------\n%s\n-----------------\n",
-                     pid, ( int )scan->memsize, pos - scan->data, errbuf[( nerrbuf + 1 ) & 1], errbuf[nerrbuf] );
-            fflush( stderr );
+            S2Sdd_DumpError( aData );
 #endif
-            scan->error = 1;
-            pthread_mutex_unlock( &( scan->mutex ) );
-            pthread_testcancel(  );
-            pthread_detach( data->thread );
-            pthread_exit( NULL );
+            return S2Sdd_ContError( aData, 1, apLine ? aLen : 0 );
         }
-        scan->size = pos - scan->data;
+        //! Frame cut short by line noise
+        if( aData->resync && aData->nvalue != aData->rsize )
+            return S2Sdd_ContError( aData, 1, aLen );
+        scan->size = aData->nvalue;
+        scan->nstep = aData->nvalue / aData->multi;
+        S2Sdd_MarkDecode( aData, scan );
+        S2Sdd_ToPoints( aData, scan );
 #ifdef SCIP2_DEBUG_ALL
-        fprintf( stderr, "SCIP2 INFO: %d: %d steps recived.\n", pid, scan->size );
+        fprintf( stderr, "SCIP2 INFO: %d: %d steps recived.\n", getpid(  ), scan->size );
 #endif											/* SCIP2_DEBUG_ALL */
-        pthread_mutex_unlock( &( scan->mutex ) );
+        aData->state = SCIP2_RECV_ECHO;
 
-        //! run callback function
-        if( data->callback )
+        //! run callback function on back buffer owned by reciver
+        scan->seq = aData->ring.seq + 1;
+        if( !S2Sdd_RunCallback( aData, scan, !aData->lfactive ) )
+            return 0;
+
+        clock_gettime( CLOCK_MONOTONIC, &( scan->tpublish ) );
+        if( aData->lfactive )
         {
-            int ret;
-            pthread_mutex_lock( &( scan->mutex ) );
-            ret = data->callback( scan, data->userdata );
-            pthread_mutex_unlock( &( scan->mutex ) );
-            if( !ret )
-                break;
+            //! publish back buffer only in exchange for a free one, so that reader never gets older scan
+            next = NULL;
+            back = ( int )( scan - aData->buf ) | SCIP2_SDD_DIRTY;
+            mid = __atomic_load_n( &( aData->middle ), __ATOMIC_ACQUIRE );
+            while( S2Sdd_IsFree( aData, &( aData->buf[mid & ~SCIP2_SDD_DIRTY] ) ) )
+            {
+                if( __atomic_compare_exchange_n( &( aData->middle ), &mid, back, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+                {
+                    next = &( aData->buf[mid & ~SCIP2_SDD_DIRTY] );
+                    break;
+                }
+            }
+            //! Buffer given back by reader is held: spare buffer takes its place, or scan is dropped
+            if( next == NULL && ( next = S2Sdd_TakeSpare( aData, scan ) ) != NULL )
+            {
+                mid = __atomic_exchange_n( &( aData->middle ), back, __ATOMIC_ACQ_REL );
+                aData->trio &= ~( 1 << ( mid & ~SCIP2_SDD_DIRTY ) );
+                aData->trio |= 1 << ( int )( next - aData->buf );
+            }
+            aData->thr = next ? next : scan;
+        }
+        else
+        {
+            //! swap buffer
+            pthread_mutex_lock( &( aData->mutexw ) );
+            next = S2Sdd_TakeFree( aData, aData->sec );
+            if( next )
+            {
+                aData->thr = next;
+                aData->sec = scan;
+                aData->update = 1;
+            }
+            pthread_mutex_unlock( &( aData->mutexw ) );
+        }
+        if( aData->thr == scan )
+        {
+            //! No free buffer: scan is overwritten by next one
+            __atomic_add_fetch( &( aData->ndrop ), 1, __ATOMIC_RELAXED );
+        }
+        else
+        {
+            if( aData->down )
+                S2Sdd_EndOutage( aData );
+            S2Sdd_CountPublish( aData, scan );
+            S2Ring_Put( &( aData->ring ), scan );
+            S2Sdd_Notify( aData );
+            if( !S2Sdd_PostCallback( aData, scan ) )
+                return 0;
         }
 
-        //! swap buffer
-        pthread_mutex_lock( &( data->mutexw ) );
-        data->thr = data->sec;
-        data->sec = scan;
-        scan = data->thr;
-        data->update = 1;
-        pthread_mutex_unlock( &( data->mutexw ) );
+        //! Stop if remain number is 0
+        if( aData->remnum == 0 && scan->num != 0 )
+            return 0;
+        return 1;
+    }
+
+    return -1;
+}
 
-        pthread_testcancel(  );
 
-        //! Stop if remain number is 0
-        if( remnum == 0 && scan->num != 0 )
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Recive scanned data continually
+ * @param *aArg Pointer to dual buffer structure
+ */
+/*--------------------------------------------------------------*/
+void *S2Sdd_RecvDataCont( void *aArg )
+{
+    //! Pointer to dual buffer structure
+    S2Sdd_t *data;
+    //! Pointer to the line in ring buffer of port
+    char *line;
+    //! Length of the line
+    int len;
+    //! Returned value of parser
+    int ret;
+
+    data = ( S2Sdd_t * ) aArg;
+
+    if( S2Sdd_InitCont( data ) )
+    {
+        while( 1 )
         {
+            line = Scip2_RecvLine( data->thr->port, &len );
+            //! Stopped by S2Sdd_StopThread, line is cut by wake up
+            if( __atomic_load_n( &( data->stopreq ), __ATOMIC_ACQUIRE ) )
+                break;
+            ret = S2Sdd_ParseCont( data, line, len );
+            //! Synchronize clock between scans
+            if( ret > 0 && data->state == SCIP2_RECV_ECHO && data->nvalue > 0
+                && __atomic_exchange_n( &( data->clock.syncreq ), 0, __ATOMIC_ACQ_REL ) )
+                ret = S2Sdd_ClockSync( data );
+            if( ret > 0 )
+                continue;
+            if( ret < 0 && data->recover && S2Sdd_Recover( data ) )
+                continue;
             break;
         }
     }
-    pthread_testcancel(  );
-    pthread_detach( data->thread );
-    pthread_exit( NULL );
+    S2Sdd_Notify( data );
+
+    S2Sdd_ExitThread( data );
+    return 0;
 }
@@ -0,0 +1,449 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_decode.c
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <limits.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "scip2hat.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SCIP2_X86_SIMD
+#include <immintrin.h>
+#endif
+
+
+
+/** SIMD level detected on this CPU */
+static S2Simd gSimdDetected = SCIP2_SIMD_NONE;
+/** SIMD level in use */
+static S2Simd gSimd = SCIP2_SIMD_NONE;
+/** SSSE3 is available */
+static int gSsse3 = 0;
+/** Detect CPU only once */
+static pthread_once_t gSimdOnce = PTHREAD_ONCE_INIT;
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Detect SIMD instruction set of CPU
+ */
+/*--------------------------------------------------------------*/
+static void Scip2_DetectSimd( void )
+{
+#ifdef SCIP2_X86_SIMD
+    __builtin_cpu_init(  );
+    gSimdDetected = SCIP2_SIMD_SSE2;
+    gSsse3 = __builtin_cpu_supports( "ssse3" );
+    if( __builtin_cpu_supports( "avx2" ) )
+        gSimdDetected = SCIP2_SIMD_AVX2;
+#endif											/* SCIP2_X86_SIMD */
+    gSimd = gSimdDetected;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Limit SIMD instruction set used by decoder
+ * @param acSimd Highest instruction set allowed
+ * @return Instruction set in use
+ */
+/*--------------------------------------------------------------*/
+S2Simd Scip2_SetSimd( const S2Simd acSimd )
+{
+    pthread_once( &gSimdOnce, Scip2_DetectSimd );
+    gSimd = acSimd < gSimdDetected ? acSimd : gSimdDetected;
+    return gSimd;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get SIMD instruction set in use
+ * @return Instruction set in use
+ */
+/*--------------------------------------------------------------*/
+S2Simd Scip2_GetSimd( void )
+{
+    pthread_once( &gSimdOnce, Scip2_DetectSimd );
+    return gSimd;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get size of a decoded value in memory
+ * @param acType Type of decoded value
+ * @return Size in bytes
+ */
+/*--------------------------------------------------------------*/
+int Scip2_ValSize( const S2ValType acType )
+{
+    switch ( acType )
+    {
+    case SCIP2_VAL_UINT16:
+        return sizeof ( uint16_t );
+    case SCIP2_VAL_UINT32:
+        return sizeof ( uint32_t );
+    default:
+        return sizeof ( unsigned long );
+    }
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Store a decoded value
+ * @param *apBuf Pointer to Buffer
+ * @param acType Type of decoded value
+ * @param aIndex Index in Buffer
+ * @param aValue Decoded value
+ */
+/*--------------------------------------------------------------*/
+static inline void Scip2_StoreValue( void *apBuf, const S2ValType acType, int aIndex, unsigned long aValue )
+{
+    switch ( acType )
+    {
+    case SCIP2_VAL_UINT16:
+        ( ( uint16_t * ) apBuf )[aIndex] = ( uint16_t ) aValue;
+        break;
+    case SCIP2_VAL_UINT32:
+        ( ( uint32_t * ) apBuf )[aIndex] = ( uint32_t ) aValue;
+        break;
+    default:
+        ( ( unsigned long * )apBuf )[aIndex] = aValue;
+        break;
+    }
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Decode values one by one
+ * @param *apSrc Pointer to encoded characters
+ * @param aNValue Number of values
+ * @param *apBuf Pointer to Buffer
+ * @param acType Type of decoded value
+ * @param acEnc Encode type
+ */
+/*--------------------------------------------------------------*/
+static void Scip2_DecodeScalar( const char *apSrc, int aNValue, void *apBuf, const S2ValType acType,
+                                const S2EncType acEnc )
+{
+    //! Decoded data
+    unsigned long value;
+    //! General
+    int i, j;
+
+    switch ( acEnc )
+    {
+    case SCIP2_ENC_2BYTE:
+        for ( j = 0; j < aNValue; j++, apSrc += 2 )
+            Scip2_StoreValue( apBuf, acType, j, ( ( apSrc[0] - 0x30 ) << 6 ) | ( apSrc[1] - 0x30 ) );
+        break;
+    case SCIP2_ENC_3BYTE:
+        for ( j = 0; j < aNValue; j++, apSrc += 3 )
+            Scip2_StoreValue( apBuf, acType, j,
+                              ( ( apSrc[0] - 0x30 ) << 12 ) | ( ( apSrc[1] - 0x30 ) << 6 ) | ( apSrc[2] - 0x30 ) );
+        break;
+    default:
+        for ( j = 0; j < aNValue; j++ )
+        {
+            value = 0;
+            for ( i = 0; i < acEnc; i++, apSrc++ )
+                value = ( value << 6 ) | ( *apSrc - 0x30 );
+            Scip2_StoreValue( apBuf, acType, j, value );
+        }
+        break;
+    }
+}
+
+
+
+#ifdef SCIP2_X86_SIMD
+/*--------------------------------------------------------------*/
+/**
+ * @brief Store 4 values of 32 bits
+ * @param *apBuf Pointer to Buffer
+ * @param acType Type of decoded value ( except SCIP2_VAL_UINT16 )
+ * @param aIndex Index in Buffer
+ * @param aV Values
+ */
+/*--------------------------------------------------------------*/
+static inline void Scip2_Store4( void *apBuf, const S2ValType acType, int aIndex, __m128i aV )
+{
+    //! Pointer to unsigned long values
+    unsigned long *buf;
+
+    if( acType == SCIP2_VAL_UINT32 )
+    {
+        _mm_storeu_si128( ( __m128i * ) ( ( uint32_t * ) apBuf + aIndex ), aV );
+        return;
+    }
+    buf = ( unsigned long * )apBuf + aIndex;
+#if ULONG_MAX > 0xFFFFFFFFUL
+    _mm_storeu_si128( ( __m128i * ) buf, _mm_unpacklo_epi32( aV, _mm_setzero_si128(  ) ) );
+    _mm_storeu_si128( ( __m128i * ) ( buf + 2 ), _mm_unpackhi_epi32( aV, _mm_setzero_si128(  ) ) );
+#else
+    _mm_storeu_si128( ( __m128i * ) buf, aV );
+#endif
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Decode 2 bytes encoding with SSE2
+ * @param *apSrc Pointer to encoded characters
+ * @param aNValue Number of values
+ * @param *apBuf Pointer to Buffer
+ * @param acType Type of decoded value
+ * @return Number of decoded values
+ */
+/*--------------------------------------------------------------*/
+static int Scip2_Decode2Sse2( const char *apSrc, int aNValue, void *apBuf, const S2ValType acType )
+{
+    //! Character offset
+    const __m128i offset = _mm_set1_epi8( 0x30 );
+    //! Mask of first character
+    const __m128i low = _mm_set1_epi16( 0x00FF );
+    //! Characters and values
+    __m128i v;
+    //! General
+    int j;
+
+    for ( j = 0; j + 8 <= aNValue; j += 8, apSrc += 16 )
+    {
+        v = _mm_sub_epi8( _mm_loadu_si128( ( const __m128i * )apSrc ), offset );
+        //! first character is upper 6 bits
+        v = _mm_or_si128( _mm_slli_epi16( _mm_and_si128( v, low ), 6 ), _mm_srli_epi16( v, 8 ) );
+        if( acType == SCIP2_VAL_UINT16 )
+        {
+            _mm_storeu_si128( ( __m128i * ) ( ( uint16_t * ) apBuf + j ), v );
+            continue;
+        }
+        Scip2_Store4( apBuf, acType, j, _mm_unpacklo_epi16( v, _mm_setzero_si128(  ) ) );
+        Scip2_Store4( apBuf, acType, j + 4, _mm_unpackhi_epi16( v, _mm_setzero_si128(  ) ) );
+    }
+    return j;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Decode 3 bytes encoding with SSSE3
+ * @param *apSrc Pointer to encoded characters
+ * @param aNValue Number of values
+ * @param *apBuf Pointer to Buffer
+ * @param acType Type of decoded value
+ * @return Number of decoded values
+ */
+/*--------------------------------------------------------------*/
+__attribute__ ( ( target( "ssse3" ) ) )
+static int Scip2_Decode3Ssse3( const char *apSrc, int aNValue, void *apBuf, const S2ValType acType )
+{
+    //! Character offset
+    const __m128i offset = _mm_set1_epi8( 0x30 );
+    //! Arrange characters as ( middle, lower, upper, none )
+    const __m128i shuffle = _mm_setr_epi8( 1, 2, 0, -1, 4, 5, 3, -1, 7, 8, 6, -1, 10, 11, 9, -1 );
+    //! Weight of ( middle, lower ) and ( upper, none )
+    const __m128i weight8 = _mm_set1_epi32( 0x00010140 );
+    //! Weight of 12 bits and upper 6 bits
+    const __m128i weight16 = _mm_set1_epi32( 0x10000001 );
+    //! Characters and values
+    __m128i v;
+    //! General
+    int j;
+
+    //! 16 characters are loaded to decode 12 characters
+    for ( j = 0; ( j + 4 ) * 3 + 4 <= aNValue * 3; j += 4, apSrc += 12 )
+    {
+        v = _mm_sub_epi8( _mm_loadu_si128( ( const __m128i * )apSrc ), offset );
+        v = _mm_shuffle_epi8( v, shuffle );
+        v = _mm_madd_epi16( _mm_maddubs_epi16( v, weight8 ), weight16 );
+        Scip2_Store4( apBuf, acType, j, v );
+    }
+    return j;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Store 8 values of 32 bits
+ * @param *apBuf Pointer to Buffer
+ * @param acType Type of decoded value ( except SCIP2_VAL_UINT16 )
+ * @param aIndex Index in Buffer
+ * @param aV Values
+ */
+/*--------------------------------------------------------------*/
+__attribute__ ( ( target( "avx2" ) ) )
+static inline void Scip2_Store8( void *apBuf, const S2ValType acType, int aIndex, __m256i aV )
+{
+    //! Pointer to unsigned long values
+    unsigned long *buf;
+
+    if( acType == SCIP2_VAL_UINT32 )
+    {
+        _mm256_storeu_si256( ( __m256i * ) ( ( uint32_t * ) apBuf + aIndex ), aV );
+        return;
+    }
+    buf = ( unsigned long * )apBuf + aIndex;
+#if ULONG_MAX > 0xFFFFFFFFUL
+    _mm256_storeu_si256( ( __m256i * ) buf, _mm256_cvtepu32_epi64( _mm256_castsi256_si128( aV ) ) );
+    _mm256_storeu_si256( ( __m256i * ) ( buf + 4 ), _mm256_cvtepu32_epi64( _mm256_extracti128_si256( aV, 1 ) ) );
+#else
+    _mm256_storeu_si256( ( __m256i * ) buf, aV );
+#endif
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Decode 2 bytes encoding with AVX2
+ * @param *apSrc Pointer to encoded characters
+ * @param aNValue Number of values
+ * @param *apBuf Pointer to Buffer
+ * @param acType Type of decoded value
+ * @return Number of decoded values
+ */
+/*--------------------------------------------------------------*/
+__attribute__ ( ( target( "avx2" ) ) )
+static int Scip2_Decode2Avx2( const char *apSrc, int aNValue, void *apBuf, const S2ValType acType )
+{
+    //! Character offset
+    const __m256i offset = _mm256_set1_epi8( 0x30 );
+    //! Mask of first character
+    const __m256i low = _mm256_set1_epi16( 0x00FF );
+    //! Characters and values
+    __m256i v;
+    //! General
+    int j;
+
+    for ( j = 0; j + 16 <= aNValue; j += 16, apSrc += 32 )
+    {
+        v = _mm256_sub_epi8( _mm256_loadu_si256( ( const __m256i * )apSrc ), offset );
+        //! first character is upper 6 bits
+        v = _mm256_or_si256( _mm256_slli_epi16( _mm256_and_si256( v, low ), 6 ), _mm256_srli_epi16( v, 8 ) );
+        if( acType == SCIP2_VAL_UINT16 )
+        {
+            _mm256_storeu_si256( ( __m256i * ) ( ( uint16_t * ) apBuf + j ), v );
+            continue;
+        }
+        Scip2_Store8( apBuf, acType, j, _mm256_cvtepu16_epi32( _mm256_castsi256_si128( v ) ) );
+        Scip2_Store8( apBuf, acType, j + 8, _mm256_cvtepu16_epi32( _mm256_extracti128_si256( v, 1 ) ) );
+    }
+    return j;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Decode 3 bytes encoding with AVX2
+ * @param *apSrc Pointer to encoded characters
+ * @param aNValue Number of values
+ * @param *apBuf Pointer to Buffer
+ * @param acType Type of decoded value
+ * @return Number of decoded values
+ */
+/*--------------------------------------------------------------*/
+__attribute__ ( ( target( "avx2" ) ) )
+static int Scip2_Decode3Avx2( const char *apSrc, int aNValue, void *apBuf, const S2ValType acType )
+{
+    //! Character offset
+    const __m256i offset = _mm256_set1_epi8( 0x30 );
+    //! Arrange characters as ( middle, lower, upper, none ) in each 128 bits
+    const __m256i shuffle = _mm256_setr_epi8( 1, 2, 0, -1, 4, 5, 3, -1, 7, 8, 6, -1, 10, 11, 9, -1,
+                                              1, 2, 0, -1, 4, 5, 3, -1, 7, 8, 6, -1, 10, 11, 9, -1 );
+    //! Weight of ( middle, lower ) and ( upper, none )
+    const __m256i weight8 = _mm256_set1_epi32( 0x00010140 );
+    //! Weight of 12 bits and upper 6 bits
+    const __m256i weight16 = _mm256_set1_epi32( 0x10000001 );
+    //! Characters and values
+    __m256i v;
+    //! General
+    int j;
+
+    //! 12 characters are decoded from each of 2 loads of 16 characters
+    for ( j = 0; ( j + 8 ) * 3 + 4 <= aNValue * 3; j += 8, apSrc += 24 )
+    {
+        v = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_loadu_si128( ( const __m128i * )apSrc ) ),
+                                     _mm_loadu_si128( ( const __m128i * )( apSrc + 12 ) ), 1 );
+        v = _mm256_sub_epi8( v, offset );
+        v = _mm256_shuffle_epi8( v, shuffle );
+        v = _mm256_madd_epi16( _mm256_maddubs_epi16( v, weight8 ), weight16 );
+        Scip2_Store8( apBuf, acType, j, v );
+    }
+    return j;
+}
+#endif											/* SCIP2_X86_SIMD */
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Decode block of whole encoded values
+ * @param *apSrc Pointer to encoded characters ( aNValue * acEnc characters )
+ * @param aNValue Number of values
+ * @param *apBuf Pointer to Buffer
+ * @param acType Type of decoded value
+ * @param acEnc Encode type
+ * @return Number of decoded values
+ * @attention No character beyond the block is read.
+ *            Values are truncated if acType is narrower than acEnc.
+ */
+/*--------------------------------------------------------------*/
+int Scip2_DecodeBlock( const char *apSrc, int aNValue, void *apBuf, const S2ValType acType, const S2EncType acEnc )
+{
+    //! Number of decoded values
+    int j;
+    //! Size of decoded value
+    int size;
+
+    pthread_once( &gSimdOnce, Scip2_DetectSimd );
+
+    j = 0;
+    size = Scip2_ValSize( acType );
+#ifdef SCIP2_X86_SIMD
+    switch ( acEnc )
+    {
+    case SCIP2_ENC_2BYTE:
+        if( gSimd >= SCIP2_SIMD_AVX2 )
+            j = Scip2_Decode2Avx2( apSrc, aNValue, apBuf, acType );
+        if( gSimd >= SCIP2_SIMD_SSE2 )
+            j += Scip2_Decode2Sse2( apSrc + j * 2, aNValue - j, ( char * )apBuf + j * size, acType );
+        break;
+    case SCIP2_ENC_3BYTE:
+        //! 3 bytes encoding is not narrowed to 16 bits in vector
+        if( acType == SCIP2_VAL_UINT16 )
+            break;
+        if( gSimd >= SCIP2_SIMD_AVX2 )
+            j = Scip2_Decode3Avx2( apSrc, aNValue, apBuf, acType );
+        if( gSimd >= SCIP2_SIMD_SSE2 && gSsse3 )
+            j += Scip2_Decode3Ssse3( apSrc + j * 3, aNValue - j, ( char * )apBuf + j * size, acType );
+        break;
+    default:
+        break;
+    }
+#endif											/* SCIP2_X86_SIMD */
+    Scip2_DecodeScalar( apSrc + j * acEnc, aNValue - j, ( char * )apBuf + j * size, acType, acEnc );
+
+    return aNValue;
+}
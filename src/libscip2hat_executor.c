@@ -0,0 +1,215 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_executor.c
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scip2hat.h"
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Take the oldest job whose sensor is not running its callback
+ * @param *aExecutor Pointer to worker pool
+ * @param *apJob Taken job
+ * @return no job: 0, taken: 1
+ * @attention Must be called with mutex of the worker pool locked.
+ */
+/*--------------------------------------------------------------*/
+static int S2Executor_Take( S2Executor_t * aExecutor, S2Job_t * apJob )
+{
+    //! Loop valiant
+    int i;
+
+    for ( i = 0; i < aExecutor->njob; i++ )
+    {
+        if( aExecutor->job[i].sdd->jobbusy )
+            continue;
+        *apJob = aExecutor->job[i];
+        aExecutor->njob--;
+        memmove( &( aExecutor->job[i] ), &( aExecutor->job[i + 1] ), sizeof ( S2Job_t ) * ( aExecutor->njob - i ) );
+        apJob->sdd->jobbusy = 1;
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Worker thread
+ * @param *aArg Pointer to worker pool
+ */
+/*--------------------------------------------------------------*/
+static void *S2Executor_Loop( void *aArg )
+{
+    //! Pointer to worker pool
+    S2Executor_t *executor;
+    //! Job to run
+    S2Job_t job;
+    //! Returned value of callback
+    int ret;
+
+    executor = ( S2Executor_t * ) aArg;
+
+    pthread_mutex_lock( &( executor->mutex ) );
+    while( 1 )
+    {
+        while( !executor->quit && !S2Executor_Take( executor, &job ) )
+            pthread_cond_wait( &( executor->cond ), &( executor->mutex ) );
+        if( executor->quit )
+            break;
+        pthread_mutex_unlock( &( executor->mutex ) );
+
+        //! run callback function
+        ret = 1;
+        if( job.sdd->callback )
+        {
+            pthread_mutex_lock( &( job.scan->mutex ) );
+            S2Sdd_MarkCallback( job.sdd, job.scan );
+            ret = job.sdd->callback( job.scan, job.sdd->userdata );
+            pthread_mutex_unlock( &( job.scan->mutex ) );
+        }
+        if( !ret )
+            __atomic_store_n( &( job.sdd->cbstop ), 1, __ATOMIC_RELEASE );
+        S2Sdd_Release( job.sdd, job.scan );
+
+        pthread_mutex_lock( &( executor->mutex ) );
+        job.sdd->jobbusy = 0;
+        job.sdd->njob--;
+        //! Other jobs of the sensor may be waiting
+        pthread_cond_broadcast( &( executor->cond ) );
+        pthread_cond_broadcast( &( executor->condd ) );
+    }
+    pthread_mutex_unlock( &( executor->mutex ) );
+    return NULL;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Initialize worker pool and start its threads
+ * @param *aExecutor Pointer to worker pool
+ * @param aNThread Number of worker threads ( 1 - SCIP2_EXECUTOR_MAX_THREAD )
+ * @return failed: 0, succeeded: 1
+ */
+/*--------------------------------------------------------------*/
+int S2Executor_Init( S2Executor_t * aExecutor, int aNThread )
+{
+    if( aNThread < 1 )
+        aNThread = 1;
+    if( aNThread > SCIP2_EXECUTOR_MAX_THREAD )
+        aNThread = SCIP2_EXECUTOR_MAX_THREAD;
+
+    aExecutor->quit = 0;
+    aExecutor->njob = 0;
+    pthread_mutex_init( &( aExecutor->mutex ), 0 );
+    pthread_cond_init( &( aExecutor->cond ), 0 );
+    pthread_cond_init( &( aExecutor->condd ), 0 );
+    for ( aExecutor->nthread = 0; aExecutor->nthread < aNThread; aExecutor->nthread++ )
+    {
+        if( pthread_create( &( aExecutor->thread[aExecutor->nthread] ), NULL,
+                            S2Executor_Loop, ( void * )aExecutor ) != 0 )
+        {
+#ifdef SCIP2_DEBUG
+            fprintf( stderr, "SCIP2 ERROR: Failed to create worker thread.\n" );
+            fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+            S2Executor_Dest( aExecutor );
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Stop worker threads and destruct worker pool
+ * @param *aExecutor Pointer to worker pool
+ * @attention Scans still waiting are released without calling callback.
+ */
+/*--------------------------------------------------------------*/
+void S2Executor_Dest( S2Executor_t * aExecutor )
+{
+    //! Loop valiant
+    int i;
+
+    pthread_mutex_lock( &( aExecutor->mutex ) );
+    aExecutor->quit = 1;
+    pthread_cond_broadcast( &( aExecutor->cond ) );
+    pthread_mutex_unlock( &( aExecutor->mutex ) );
+    for ( i = 0; i < aExecutor->nthread; i++ )
+        pthread_join( aExecutor->thread[i], NULL );
+
+    for ( i = 0; i < aExecutor->njob; i++ )
+    {
+        __atomic_sub_fetch( &( aExecutor->job[i].scan->ref ), 1, __ATOMIC_RELEASE );
+        aExecutor->job[i].sdd->njob--;
+    }
+    aExecutor->njob = 0;
+
+    pthread_cond_destroy( &( aExecutor->cond ) );
+    pthread_cond_destroy( &( aExecutor->condd ) );
+    pthread_mutex_destroy( &( aExecutor->mutex ) );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Queue scan to run callback in worker thread
+ * @param *aExecutor Pointer to worker pool
+ * @param *aData Pointer to dual buffer structure
+ * @param *aScan Pointer to recived scan
+ * @return queue is full: 0, queued: 1
+ * @attention Scan is referenced until its callback returns.
+ *            Callbacks of one sensor are run one by one in order of scans.
+ */
+/*--------------------------------------------------------------*/
+int S2Executor_Post( S2Executor_t * aExecutor, S2Sdd_t * aData, S2Scan_t * aScan )
+{
+    pthread_mutex_lock( &( aExecutor->mutex ) );
+    if( aExecutor->quit || aExecutor->njob >= SCIP2_EXECUTOR_QUEUE )
+    {
+        pthread_mutex_unlock( &( aExecutor->mutex ) );
+        return 0;
+    }
+    __atomic_add_fetch( &( aScan->ref ), 1, __ATOMIC_ACQ_REL );
+    aExecutor->job[aExecutor->njob].sdd = aData;
+    aExecutor->job[aExecutor->njob].scan = aScan;
+    aExecutor->njob++;
+    aData->njob++;
+    pthread_cond_signal( &( aExecutor->cond ) );
+    pthread_mutex_unlock( &( aExecutor->mutex ) );
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Wait until all callbacks of the sensor are returned
+ * @param *aExecutor Pointer to worker pool
+ * @param *aData Pointer to dual buffer structure
+ */
+/*--------------------------------------------------------------*/
+void S2Executor_Wait( S2Executor_t * aExecutor, S2Sdd_t * aData )
+{
+    pthread_mutex_lock( &( aExecutor->mutex ) );
+    while( aData->njob > 0 && !aExecutor->quit )
+        pthread_cond_wait( &( aExecutor->condd ), &( aExecutor->mutex ) );
+    pthread_mutex_unlock( &( aExecutor->mutex ) );
+}
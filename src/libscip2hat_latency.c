@@ -0,0 +1,261 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_latency.c
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "scip2hat.h"
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Initialize latency histogram
+ * @param *aHist Pointer to latency histogram
+ * @attention Also used to reset histogram while it is counted.
+ */
+/*--------------------------------------------------------------*/
+void S2Hist_Init( S2Hist_t * aHist )
+{
+    //! Loop valiant
+    int i;
+
+    for ( i = 0; i < SCIP2_LAT_NBIN; i++ )
+        __atomic_store_n( &( aHist->count[i] ), 0, __ATOMIC_RELAXED );
+    __atomic_store_n( &( aHist->max ), 0, __ATOMIC_RELAXED );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get bin of latency
+ * @param aUsec Latency [us]
+ * @return Index of bin
+ */
+/*--------------------------------------------------------------*/
+static int S2Hist_Bin( unsigned long aUsec )
+{
+    //! Octave of latency
+    int octave;
+    //! Index of bin
+    int bin;
+
+    if( aUsec < SCIP2_LAT_SUB )
+        return ( int )aUsec;
+    octave = ( int )( sizeof ( unsigned long ) * 8 - 1 ) - __builtin_clzl( aUsec );
+    bin = ( octave - 2 ) * SCIP2_LAT_SUB + ( int )( ( aUsec >> ( octave - 3 ) ) & ( SCIP2_LAT_SUB - 1 ) );
+    if( bin >= SCIP2_LAT_NBIN )
+        bin = SCIP2_LAT_NBIN - 1;
+    return bin;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get upper edge of bin
+ * @param aBin Index of bin
+ * @return Largest latency counted in the bin [us]
+ */
+/*--------------------------------------------------------------*/
+static long S2Hist_Upper( int aBin )
+{
+    if( aBin < SCIP2_LAT_SUB )
+        return aBin;
+    return ( ( long )( SCIP2_LAT_SUB + 1 + aBin % SCIP2_LAT_SUB ) << ( aBin / SCIP2_LAT_SUB - 1 ) ) - 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Count latency between two times
+ * @param *aHist Pointer to latency histogram
+ * @param *acpFrom CLOCK_MONOTONIC time at start
+ * @param *acpTo CLOCK_MONOTONIC time at end
+ * @attention Must be called by one thread at a time, histogram may be read by others.
+ */
+/*--------------------------------------------------------------*/
+void S2Hist_Add( S2Hist_t * aHist, const struct timespec *acpFrom, const struct timespec *acpTo )
+{
+    //! Latency [us]
+    long usec;
+
+    usec = ( long )( acpTo->tv_sec - acpFrom->tv_sec ) * 1000000L + ( acpTo->tv_nsec - acpFrom->tv_nsec ) / 1000;
+    if( usec < 0 )
+        usec = 0;
+    __atomic_add_fetch( &( aHist->count[S2Hist_Bin( ( unsigned long )usec )] ), 1, __ATOMIC_RELAXED );
+    if( usec > __atomic_load_n( &( aHist->max ), __ATOMIC_RELAXED ) )
+        __atomic_store_n( &( aHist->max ), usec, __ATOMIC_RELAXED );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get percentile of latency
+ * @param *aHist Pointer to latency histogram
+ * @param aRatio Ratio of scans below the percentile ( 0.5: median )
+ * @return Percentile [us] ( upper edge of its bin ), no scan: -1
+ */
+/*--------------------------------------------------------------*/
+long S2Hist_Percentile( S2Hist_t * aHist, double aRatio )
+{
+    //! Counts of bins
+    unsigned long count[SCIP2_LAT_NBIN];
+    //! Number of scans
+    unsigned long total;
+    //! Number of scans up to the bin
+    unsigned long sum;
+    //! Maximum latency
+    long max;
+    //! Loop valiant
+    int i;
+
+    total = 0;
+    for ( i = 0; i < SCIP2_LAT_NBIN; i++ )
+    {
+        count[i] = __atomic_load_n( &( aHist->count[i] ), __ATOMIC_RELAXED );
+        total += count[i];
+    }
+    if( total == 0 )
+        return -1;
+    max = __atomic_load_n( &( aHist->max ), __ATOMIC_RELAXED );
+
+    sum = 0;
+    for ( i = 0; i < SCIP2_LAT_NBIN - 1; i++ )
+    {
+        sum += count[i];
+        if( sum >= aRatio * total )
+            break;
+    }
+    if( S2Hist_Upper( i ) < max )
+        return S2Hist_Upper( i );
+    return max;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get summary of latency histogram
+ * @param *aHist Pointer to latency histogram
+ * @param *apStat Summary ( percentiles are -1 if no scan is counted )
+ */
+/*--------------------------------------------------------------*/
+void S2Hist_GetStat( S2Hist_t * aHist, S2LatStat_t * apStat )
+{
+    //! Loop valiant
+    int i;
+
+    apStat->count = 0;
+    for ( i = 0; i < SCIP2_LAT_NBIN; i++ )
+        apStat->count += __atomic_load_n( &( aHist->count[i] ), __ATOMIC_RELAXED );
+    apStat->p50 = S2Hist_Percentile( aHist, 0.5 );
+    apStat->p99 = S2Hist_Percentile( aHist, 0.99 );
+    apStat->max = apStat->count ? __atomic_load_n( &( aHist->max ), __ATOMIC_RELAXED ) : -1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get latency of a stage of reciving scans
+ * @param *aData Pointer to dual buffer structure
+ * @param aStage Stage of reciving ( SCIP2_LAT_TOTAL: end to end )
+ * @param *apStat Number of scans, median, 99th percentile and maximum [us]
+ * @return failed: 0, succeeded: 1
+ * @attention Percentiles are upper edges of bins of histogram ( within 1/8 ).
+ *            Scans dropped for lack of free buffer are counted only in SCIP2_LAT_TRANSFER.
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_GetLatency( S2Sdd_t * aData, S2LatStage aStage, S2LatStat_t * apStat )
+{
+    if( aStage < 0 || aStage >= SCIP2_LAT_NSTAGE )
+        return 0;
+    S2Hist_GetStat( &( aData->latency[aStage] ), apStat );
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Clear latency histograms
+ * @param *aData Pointer to dual buffer structure
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_ResetLatency( S2Sdd_t * aData )
+{
+    //! Loop valiant
+    int i;
+
+    for ( i = 0; i < SCIP2_LAT_NSTAGE; i++ )
+        S2Hist_Init( &( aData->latency[i] ) );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Stamp scan whose last data line is decoded
+ * @param *aData Pointer to dual buffer structure
+ * @param *aScan Pointer to decoded scan
+ * @attention Arrival of echo back must be set. Must be called by reciver.
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_MarkDecode( S2Sdd_t * aData, S2Scan_t * aScan )
+{
+    aScan->techo = aData->clock.arrival;
+    clock_gettime( CLOCK_MONOTONIC, &( aScan->tdecode ) );
+    memset( &( aScan->tpublish ), 0, sizeof ( struct timespec ) );
+    memset( &( aScan->tcallback ), 0, sizeof ( struct timespec ) );
+    S2Hist_Add( &( aData->latency[SCIP2_LAT_TRANSFER] ), &( aScan->techo ), &( aScan->tdecode ) );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Count latency of published scan
+ * @param *aData Pointer to dual buffer structure
+ * @param *aScan Pointer to published scan
+ * @attention tpublish of the scan must be set before it is published. Must be called by reciver.
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_CountPublish( S2Sdd_t * aData, S2Scan_t * aScan )
+{
+    S2Hist_Add( &( aData->latency[SCIP2_LAT_PUBLISH] ), &( aScan->tdecode ), &( aScan->tpublish ) );
+    if( !aData->callback )
+        S2Hist_Add( &( aData->latency[SCIP2_LAT_TOTAL] ), &( aScan->techo ), &( aScan->tpublish ) );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Stamp scan whose callback is starting
+ * @param *aData Pointer to dual buffer structure
+ * @param *aScan Pointer to scan given to callback
+ * @attention Called by reciver or worker pool running callbacks of the sensor one by one.
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_MarkCallback( S2Sdd_t * aData, S2Scan_t * aScan )
+{
+    clock_gettime( CLOCK_MONOTONIC, &( aScan->tcallback ) );
+    if( aScan->tpublish.tv_sec || aScan->tpublish.tv_nsec )
+        S2Hist_Add( &( aData->latency[SCIP2_LAT_CALLBACK] ), &( aScan->tpublish ), &( aScan->tcallback ) );
+    else
+        S2Hist_Add( &( aData->latency[SCIP2_LAT_CALLBACK] ), &( aScan->tdecode ), &( aScan->tcallback ) );
+    S2Hist_Add( &( aData->latency[SCIP2_LAT_TOTAL] ), &( aScan->techo ), &( aScan->tcallback ) );
+}
@@ -0,0 +1,788 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_points.c
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "scip2hat.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SCIP2_X86_SIMD
+#include <immintrin.h>
+#endif
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Initialize conversion table
+ * @param *aTrig Pointer to conversion table
+ */
+/*--------------------------------------------------------------*/
+void S2Trig_Init( S2Trig_t * aTrig )
+{
+    memset( aTrig, 0, sizeof ( S2Trig_t ) );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Destruct conversion table
+ * @param *aTrig Pointer to conversion table
+ */
+/*--------------------------------------------------------------*/
+void S2Trig_Dest( S2Trig_t * aTrig )
+{
+    if( aTrig->cos )
+        free( aTrig->cos );
+    aTrig->cos = NULL;
+    aTrig->sin = NULL;
+    aTrig->nstep = 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Set parameters of sensor and mounting pose
+ * @param *aTrig Pointer to conversion table
+ * @param *acpParam Parameters replied to Scip2CMD_PP
+ * @param *acpPose Mounting pose, or NULL for points in the frame of sensor
+ * @return failed: 0, succeeded: 1
+ * @attention Table is built again by next S2Trig_Build.
+ */
+/*--------------------------------------------------------------*/
+int S2Trig_Setup( S2Trig_t * aTrig, const S2Param_t * acpParam, const S2Pose_t * acpPose )
+{
+    if( acpParam->step_resolution <= 0 )
+        return 0;
+    aTrig->resolution = acpParam->step_resolution;
+    aTrig->front = acpParam->step_front;
+    aTrig->dmin = ( float )acpParam->dist_min;
+    memset( &( aTrig->pose ), 0, sizeof ( S2Pose_t ) );
+    if( acpPose )
+        aTrig->pose = *acpPose;
+    aTrig->nstep = 0;
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Build table of steps of scan
+ * @param *aTrig Pointer to conversion table
+ * @param aStart First step of scan
+ * @param aGroup Number of grouped steps ( direction is their center )
+ * @param aNStep Number of steps ( or groups ) of scan
+ * @return failed: 0, succeeded: 1
+ * @attention Nothing is done if the table is already built for the scan.
+ */
+/*--------------------------------------------------------------*/
+int S2Trig_Build( S2Trig_t * aTrig, int aStart, int aGroup, int aNStep )
+{
+    //! Direction of step [rad]
+    double angle;
+    //! Loop valiant
+    int i;
+
+    if( aGroup < 1 )
+        aGroup = 1;
+    if( aTrig->resolution <= 0 )
+        return 0;
+    if( aTrig->cos && aTrig->start == aStart && aTrig->group == aGroup && aTrig->nstep >= aNStep )
+        return 1;
+
+    S2Trig_Dest( aTrig );
+    aTrig->cos = ( float * )malloc( sizeof ( float ) * 2 * aNStep );
+    if( aTrig->cos == NULL )
+    {
+#ifdef SCIP2_DEBUG
+        fprintf( stderr, "SCIP2 ERROR: malloc failed.\n" );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+        return 0;
+    }
+    aTrig->sin = aTrig->cos + aNStep;
+    for ( i = 0; i < aNStep; i++ )
+    {
+        angle = aTrig->pose.yaw
+            + 2 * M_PI * ( aStart + i * aGroup + ( aGroup - 1 ) / 2.0 - aTrig->front ) / aTrig->resolution;
+        aTrig->cos[i] = ( float )cos( angle );
+        aTrig->sin[i] = ( float )sin( angle );
+    }
+    aTrig->start = aStart;
+    aTrig->group = aGroup;
+    aTrig->nstep = aNStep;
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Convert range of steps one by one
+ * @param *acpTrig Pointer to conversion table
+ * @param *acpRange Pointer to range [mm]
+ * @param acType Type of range
+ * @param aStride Number of values par step
+ * @param aFrom First step to convert
+ * @param aNStep Number of steps
+ * @param *apX Buffer of x [mm]
+ * @param *apY Buffer of y [mm]
+ */
+/*--------------------------------------------------------------*/
+static void S2Trig_ConvertScalar( const S2Trig_t * acpTrig, const void *acpRange, const S2ValType acType,
+                                  int aStride, int aFrom, int aNStep, float *apX, float *apY )
+{
+    //! Range of step
+    float r;
+    //! Loop valiant
+    int i;
+
+    for ( i = aFrom; i < aNStep; i++ )
+    {
+        switch ( acType )
+        {
+        case SCIP2_VAL_UINT16:
+            r = ( ( const uint16_t * )acpRange )[i * aStride];
+            break;
+        case SCIP2_VAL_UINT32:
+            r = ( ( const uint32_t * )acpRange )[i * aStride];
+            break;
+        default:
+            r = ( ( const unsigned long * )acpRange )[i * aStride];
+            break;
+        }
+        if( r < acpTrig->dmin )
+        {
+            apX[i] = apY[i] = NAN;
+            continue;
+        }
+        apX[i] = r * acpTrig->cos[i] + ( float )acpTrig->pose.x;
+        apY[i] = r * acpTrig->sin[i] + ( float )acpTrig->pose.y;
+    }
+}
+
+
+
+#ifdef SCIP2_X86_SIMD
+/*--------------------------------------------------------------*/
+/**
+ * @brief Convert range of 4 steps at once with SSE2
+ * @param *acpTrig Pointer to conversion table
+ * @param *acpRange Pointer to range [mm] ( uint16_t or uint32_t )
+ * @param acType Type of range
+ * @param aFrom First step to convert
+ * @param aNStep Number of steps
+ * @param *apX Buffer of x [mm]
+ * @param *apY Buffer of y [mm]
+ * @return Next step not converted
+ */
+/*--------------------------------------------------------------*/
+static int S2Trig_ConvertSse2( const S2Trig_t * acpTrig, const void *acpRange, const S2ValType acType,
+                               int aFrom, int aNStep, float *apX, float *apY )
+{
+    //! Position of sensor
+    const __m128 tx = _mm_set1_ps( ( float )acpTrig->pose.x );
+    const __m128 ty = _mm_set1_ps( ( float )acpTrig->pose.y );
+    //! Minimum valid range
+    const __m128 dmin = _mm_set1_ps( acpTrig->dmin );
+    //! Point of invalid range
+    const __m128 nan = _mm_set1_ps( NAN );
+    //! Range, mask of valid range and point
+    __m128 r, valid, x, y;
+    //! Loop valiant
+    int i;
+
+    for ( i = aFrom; i + 4 <= aNStep; i += 4 )
+    {
+        if( acType == SCIP2_VAL_UINT16 )
+            r = _mm_cvtepi32_ps( _mm_unpacklo_epi16( _mm_loadl_epi64( ( const __m128i * )( ( const uint16_t * )acpRange + i ) ),
+                                                     _mm_setzero_si128(  ) ) );
+        else
+            r = _mm_cvtepi32_ps( _mm_loadu_si128( ( const __m128i * )( ( const uint32_t * )acpRange + i ) ) );
+        valid = _mm_cmpge_ps( r, dmin );
+        x = _mm_add_ps( _mm_mul_ps( r, _mm_loadu_ps( acpTrig->cos + i ) ), tx );
+        y = _mm_add_ps( _mm_mul_ps( r, _mm_loadu_ps( acpTrig->sin + i ) ), ty );
+        _mm_storeu_ps( apX + i, _mm_or_ps( _mm_and_ps( valid, x ), _mm_andnot_ps( valid, nan ) ) );
+        _mm_storeu_ps( apY + i, _mm_or_ps( _mm_and_ps( valid, y ), _mm_andnot_ps( valid, nan ) ) );
+    }
+    return i;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Convert range of 8 steps at once with AVX2
+ * @param *acpTrig Pointer to conversion table
+ * @param *acpRange Pointer to range [mm] ( uint16_t or uint32_t )
+ * @param acType Type of range
+ * @param aFrom First step to convert
+ * @param aNStep Number of steps
+ * @param *apX Buffer of x [mm]
+ * @param *apY Buffer of y [mm]
+ * @return Next step not converted
+ */
+/*--------------------------------------------------------------*/
+__attribute__ ( ( target( "avx2" ) ) )
+static int S2Trig_ConvertAvx2( const S2Trig_t * acpTrig, const void *acpRange, const S2ValType acType,
+                               int aFrom, int aNStep, float *apX, float *apY )
+{
+    //! Position of sensor
+    const __m256 tx = _mm256_set1_ps( ( float )acpTrig->pose.x );
+    const __m256 ty = _mm256_set1_ps( ( float )acpTrig->pose.y );
+    //! Minimum valid range
+    const __m256 dmin = _mm256_set1_ps( acpTrig->dmin );
+    //! Point of invalid range
+    const __m256 nan = _mm256_set1_ps( NAN );
+    //! Range, mask of valid range and point
+    __m256 r, valid, x, y;
+    //! Loop valiant
+    int i;
+
+    for ( i = aFrom; i + 8 <= aNStep; i += 8 )
+    {
+        if( acType == SCIP2_VAL_UINT16 )
+            r = _mm256_cvtepi32_ps( _mm256_cvtepu16_epi32( _mm_loadu_si128( ( const __m128i * )
+                                                                            ( ( const uint16_t * )acpRange + i ) ) ) );
+        else
+            r = _mm256_cvtepi32_ps( _mm256_loadu_si256( ( const __m256i * )( ( const uint32_t * )acpRange + i ) ) );
+        valid = _mm256_cmp_ps( r, dmin, _CMP_GE_OQ );
+        x = _mm256_add_ps( _mm256_mul_ps( r, _mm256_loadu_ps( acpTrig->cos + i ) ), tx );
+        y = _mm256_add_ps( _mm256_mul_ps( r, _mm256_loadu_ps( acpTrig->sin + i ) ), ty );
+        _mm256_storeu_ps( apX + i, _mm256_blendv_ps( nan, x, valid ) );
+        _mm256_storeu_ps( apY + i, _mm256_blendv_ps( nan, y, valid ) );
+    }
+    return i;
+}
+#endif											/* SCIP2_X86_SIMD */
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Convert range of scan to Cartesian points
+ * @param *acpTrig Pointer to conversion table built for the scan
+ * @param *acpRange Pointer to range [mm]
+ * @param acType Type of range
+ * @param aStride Number of values par step ( 2 for ME / NE / GE not in planar storage )
+ * @param aNStep Number of steps ( or groups ) of scan
+ * @param *apX Buffer of x [mm] ( aNStep )
+ * @param *apY Buffer of y [mm] ( aNStep )
+ * @attention Points are transformed by mounting pose.
+ *            Point of range below dist_min ( error code of sensor ) is NAN.
+ *            SIMD instruction set is limited by Scip2_SetSimd as decoder.
+ */
+/*--------------------------------------------------------------*/
+void S2Trig_Convert( const S2Trig_t * acpTrig, const void *acpRange, const S2ValType acType, int aStride,
+                     int aNStep, float *apX, float *apY )
+{
+    //! Next step not converted
+    int i;
+#ifdef SCIP2_X86_SIMD
+    //! SIMD instruction set in use
+    S2Simd simd;
+#endif											/* SCIP2_X86_SIMD */
+
+    if( aNStep > acpTrig->nstep )
+        aNStep = acpTrig->nstep;
+
+    i = 0;
+#ifdef SCIP2_X86_SIMD
+    simd = Scip2_GetSimd(  );
+    if( aStride == 1 && ( acType == SCIP2_VAL_UINT16 || acType == SCIP2_VAL_UINT32 ) )
+    {
+        if( simd >= SCIP2_SIMD_AVX2 )
+            i = S2Trig_ConvertAvx2( acpTrig, acpRange, acType, i, aNStep, apX, apY );
+        if( simd >= SCIP2_SIMD_SSE2 )
+            i = S2Trig_ConvertSse2( acpTrig, acpRange, acType, i, aNStep, apX, apY );
+    }
+#endif											/* SCIP2_X86_SIMD */
+    S2Trig_ConvertScalar( acpTrig, acpRange, acType, aStride, i, aNStep, apX, apY );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Put classified steps into validity mask and counts
+ * @param *apMask Validity mask
+ * @param aIndex First step
+ * @param aN Number of steps ( up to 32, not crossing a word of mask )
+ * @param aLow Bits of steps below minimum
+ * @param aZero Bits of steps of 0
+ * @param aHigh Bits of steps beyond maximum
+ * @param *apCount Counts of invalid steps par class
+ */
+/*--------------------------------------------------------------*/
+static inline void S2Range_Put( uint64_t * apMask, int aIndex, int aN, uint32_t aLow, uint32_t aZero,
+                                uint32_t aHigh, int *apCount )
+{
+    //! Bits of valid steps
+    uint64_t valid;
+
+    valid = ~( uint64_t )( aLow | aHigh ) & ( ( ( uint64_t )1 << aN ) - 1 );
+    apMask[aIndex >> 6] |= valid << ( aIndex & 63 );
+    apCount[SCIP2_RANGE_ZERO] += __builtin_popcount( aLow & aZero );
+    apCount[SCIP2_RANGE_CODE] += __builtin_popcount( aLow & ~aZero );
+    apCount[SCIP2_RANGE_FAR] += __builtin_popcount( aHigh );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Validate range of steps one by one
+ * @param *acpRange Pointer to range [mm]
+ * @param acType Type of range
+ * @param aStride Number of values par step
+ * @param aFrom First step to validate
+ * @param aNStep Number of steps
+ * @param aMin Minimum valid range
+ * @param aMax Maximum valid range
+ * @param *apMask Validity mask
+ * @param *apCount Counts of invalid steps par class
+ */
+/*--------------------------------------------------------------*/
+static void S2Range_ValidateScalar( const void *acpRange, const S2ValType acType, int aStride, int aFrom,
+                                    int aNStep, unsigned long aMin, unsigned long aMax, uint64_t * apMask,
+                                    int *apCount )
+{
+    //! Range of step
+    unsigned long r;
+    //! Loop valiant
+    int i;
+
+    for ( i = aFrom; i < aNStep; i++ )
+    {
+        switch ( acType )
+        {
+        case SCIP2_VAL_UINT16:
+            r = ( ( const uint16_t * )acpRange )[i * aStride];
+            break;
+        case SCIP2_VAL_UINT32:
+            r = ( ( const uint32_t * )acpRange )[i * aStride];
+            break;
+        default:
+            r = ( ( const unsigned long * )acpRange )[i * aStride];
+            break;
+        }
+        S2Range_Put( apMask, i, 1, r < aMin, r == 0, r > aMax, apCount );
+    }
+}
+
+
+
+#ifdef SCIP2_X86_SIMD
+/*--------------------------------------------------------------*/
+/**
+ * @brief Validate range of 8 steps at once with SSE2
+ * @param *acpRange Pointer to range [mm] ( uint16_t or uint32_t )
+ * @param acType Type of range
+ * @param aFrom First step to validate
+ * @param aNStep Number of steps
+ * @param aMin Minimum valid range
+ * @param aMax Maximum valid range
+ * @param *apMask Validity mask
+ * @param *apCount Counts of invalid steps par class
+ * @return Next step not validated
+ * @attention Unsigned values are compared as signed after flipping their sign bits.
+ */
+/*--------------------------------------------------------------*/
+static int S2Range_ValidateSse2( const void *acpRange, const S2ValType acType, int aFrom, int aNStep,
+                                 unsigned long aMin, unsigned long aMax, uint64_t * apMask, int *apCount )
+{
+    //! Sign bits and limits with sign bits flipped
+    __m128i sign, min, max;
+    //! Range of steps
+    __m128i v0, v1;
+    //! Bits of steps below minimum, 0 and beyond maximum
+    uint32_t low, zero, high;
+    //! Loop valiant
+    int i;
+
+    if( acType == SCIP2_VAL_UINT16 )
+    {
+        sign = _mm_set1_epi16( ( short )0x8000 );
+        min = _mm_set1_epi16( ( short )( ( aMin > 0xFFFF ? 0xFFFF : aMin ) ^ 0x8000 ) );
+        max = _mm_set1_epi16( ( short )( ( aMax > 0xFFFF ? 0xFFFF : aMax ) ^ 0x8000 ) );
+    }
+    else
+    {
+        sign = _mm_set1_epi32( ( int )0x80000000 );
+        min = _mm_set1_epi32( ( int )( ( aMin > 0xFFFFFFFF ? 0xFFFFFFFF : aMin ) ^ 0x80000000 ) );
+        max = _mm_set1_epi32( ( int )( ( aMax > 0xFFFFFFFF ? 0xFFFFFFFF : aMax ) ^ 0x80000000 ) );
+    }
+
+    for ( i = aFrom; i + 8 <= aNStep; i += 8 )
+    {
+        if( acType == SCIP2_VAL_UINT16 )
+        {
+            v0 = _mm_loadu_si128( ( const __m128i * )( ( const uint16_t * )acpRange + i ) );
+            //! Masks of 16 bits are narrowed to 8 bits
+            zero = _mm_movemask_epi8( _mm_packs_epi16( _mm_cmpeq_epi16( v0, _mm_setzero_si128(  ) ),
+                                                       _mm_setzero_si128(  ) ) );
+            v0 = _mm_xor_si128( v0, sign );
+            low = _mm_movemask_epi8( _mm_packs_epi16( _mm_cmplt_epi16( v0, min ), _mm_setzero_si128(  ) ) );
+            high = _mm_movemask_epi8( _mm_packs_epi16( _mm_cmpgt_epi16( v0, max ), _mm_setzero_si128(  ) ) );
+        }
+        else
+        {
+            v0 = _mm_loadu_si128( ( const __m128i * )( ( const uint32_t * )acpRange + i ) );
+            v1 = _mm_loadu_si128( ( const __m128i * )( ( const uint32_t * )acpRange + i + 4 ) );
+            zero = _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpeq_epi32( v0, _mm_setzero_si128(  ) ) ) )
+                | _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpeq_epi32( v1, _mm_setzero_si128(  ) ) ) ) << 4;
+            v0 = _mm_xor_si128( v0, sign );
+            v1 = _mm_xor_si128( v1, sign );
+            low = _mm_movemask_ps( _mm_castsi128_ps( _mm_cmplt_epi32( v0, min ) ) )
+                | _mm_movemask_ps( _mm_castsi128_ps( _mm_cmplt_epi32( v1, min ) ) ) << 4;
+            high = _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpgt_epi32( v0, max ) ) )
+                | _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpgt_epi32( v1, max ) ) ) << 4;
+        }
+        S2Range_Put( apMask, i, 8, low, zero, high, apCount );
+    }
+    return i;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Validate range of 16 steps at once with AVX2
+ * @param *acpRange Pointer to range [mm] ( uint16_t or uint32_t )
+ * @param acType Type of range
+ * @param aFrom First step to validate
+ * @param aNStep Number of steps
+ * @param aMin Minimum valid range
+ * @param aMax Maximum valid range
+ * @param *apMask Validity mask
+ * @param *apCount Counts of invalid steps par class
+ * @return Next step not validated
+ * @attention Unsigned values are compared as signed after flipping their sign bits.
+ */
+/*--------------------------------------------------------------*/
+__attribute__ ( ( target( "avx2" ) ) )
+static int S2Range_ValidateAvx2( const void *acpRange, const S2ValType acType, int aFrom, int aNStep,
+                                 unsigned long aMin, unsigned long aMax, uint64_t * apMask, int *apCount )
+{
+    //! Sign bits and limits with sign bits flipped
+    __m256i sign, min, max;
+    //! Range of steps
+    __m256i v0, v1;
+    //! Comparison of 16 bits values
+    __m256i c;
+    //! Bits of steps below minimum, 0 and beyond maximum
+    uint32_t low, zero, high;
+    //! Loop valiant
+    int i;
+
+    if( acType == SCIP2_VAL_UINT16 )
+    {
+        sign = _mm256_set1_epi16( ( short )0x8000 );
+        min = _mm256_set1_epi16( ( short )( ( aMin > 0xFFFF ? 0xFFFF : aMin ) ^ 0x8000 ) );
+        max = _mm256_set1_epi16( ( short )( ( aMax > 0xFFFF ? 0xFFFF : aMax ) ^ 0x8000 ) );
+    }
+    else
+    {
+        sign = _mm256_set1_epi32( ( int )0x80000000 );
+        min = _mm256_set1_epi32( ( int )( ( aMin > 0xFFFFFFFF ? 0xFFFFFFFF : aMin ) ^ 0x80000000 ) );
+        max = _mm256_set1_epi32( ( int )( ( aMax > 0xFFFFFFFF ? 0xFFFFFFFF : aMax ) ^ 0x80000000 ) );
+    }
+
+    for ( i = aFrom; i + 16 <= aNStep; i += 16 )
+    {
+        if( acType == SCIP2_VAL_UINT16 )
+        {
+            v0 = _mm256_loadu_si256( ( const __m256i * )( ( const uint16_t * )acpRange + i ) );
+            //! Masks of 16 bits are narrowed to 8 bits in order of steps
+            c = _mm256_cmpeq_epi16( v0, _mm256_setzero_si256(  ) );
+            zero = _mm_movemask_epi8( _mm_packs_epi16( _mm256_castsi256_si128( c ),
+                                                       _mm256_extracti128_si256( c, 1 ) ) );
+            v0 = _mm256_xor_si256( v0, sign );
+            c = _mm256_cmpgt_epi16( min, v0 );
+            low = _mm_movemask_epi8( _mm_packs_epi16( _mm256_castsi256_si128( c ),
+                                                      _mm256_extracti128_si256( c, 1 ) ) );
+            c = _mm256_cmpgt_epi16( v0, max );
+            high = _mm_movemask_epi8( _mm_packs_epi16( _mm256_castsi256_si128( c ),
+                                                       _mm256_extracti128_si256( c, 1 ) ) );
+        }
+        else
+        {
+            v0 = _mm256_loadu_si256( ( const __m256i * )( ( const uint32_t * )acpRange + i ) );
+            v1 = _mm256_loadu_si256( ( const __m256i * )( ( const uint32_t * )acpRange + i + 8 ) );
+            zero = _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpeq_epi32( v0, _mm256_setzero_si256(  ) ) ) )
+                | _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpeq_epi32( v1, _mm256_setzero_si256(  ) ) ) ) << 8;
+            v0 = _mm256_xor_si256( v0, sign );
+            v1 = _mm256_xor_si256( v1, sign );
+            low = _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpgt_epi32( min, v0 ) ) )
+                | _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpgt_epi32( min, v1 ) ) ) << 8;
+            high = _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpgt_epi32( v0, max ) ) )
+                | _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpgt_epi32( v1, max ) ) ) << 8;
+        }
+        S2Range_Put( apMask, i, 16, low, zero, high, apCount );
+    }
+    return i;
+}
+#endif											/* SCIP2_X86_SIMD */
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Make validity mask of range of scan
+ * @param *acpRange Pointer to range [mm]
+ * @param acType Type of range
+ * @param aStride Number of values par step ( 2 for ME / NE / GE not in planar storage )
+ * @param aNStep Number of steps ( or groups ) of scan
+ * @param aMin Minimum valid range ( dist_min, range below it is error code of sensor )
+ * @param aMax Maximum valid range ( dist_max )
+ * @param *apMask Validity mask, bit ( i % 64 ) of word ( i / 64 ) is set if step i is valid
+ *        ( SCIP2_MASK_WORDS( aNStep ) words )
+ * @param *apCount Counts of invalid steps par class ( SCIP2_RANGE_NCLASS )
+ * @return Number of valid steps
+ * @attention SIMD instruction set is limited by Scip2_SetSimd as decoder.
+ */
+/*--------------------------------------------------------------*/
+int S2Range_Validate( const void *acpRange, const S2ValType acType, int aStride, int aNStep,
+                      unsigned long aMin, unsigned long aMax, uint64_t * apMask, int *apCount )
+{
+    //! Next step not validated
+    int i;
+    //! Number of invalid steps
+    int ninvalid;
+#ifdef SCIP2_X86_SIMD
+    //! SIMD instruction set in use
+    S2Simd simd;
+#endif											/* SCIP2_X86_SIMD */
+
+    memset( apMask, 0, sizeof ( uint64_t ) * SCIP2_MASK_WORDS( aNStep ) );
+    for ( i = 0; i < SCIP2_RANGE_NCLASS; i++ )
+        apCount[i] = 0;
+
+    i = 0;
+#ifdef SCIP2_X86_SIMD
+    simd = Scip2_GetSimd(  );
+    if( aStride == 1 && ( acType == SCIP2_VAL_UINT16 || acType == SCIP2_VAL_UINT32 ) )
+    {
+        if( simd >= SCIP2_SIMD_AVX2 )
+            i = S2Range_ValidateAvx2( acpRange, acType, i, aNStep, aMin, aMax, apMask, apCount );
+        if( simd >= SCIP2_SIMD_SSE2 )
+            i = S2Range_ValidateSse2( acpRange, acType, i, aNStep, aMin, aMax, apMask, apCount );
+    }
+#endif											/* SCIP2_X86_SIMD */
+    S2Range_ValidateScalar( acpRange, acType, aStride, i, aNStep, aMin, aMax, apMask, apCount );
+
+    ninvalid = 0;
+    for ( i = 0; i < SCIP2_RANGE_NCLASS; i++ )
+        ninvalid += apCount[i];
+    return aNStep - ninvalid;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Initialize conversion of recived scans
+ * @param *aConv Pointer to conversion
+ */
+/*--------------------------------------------------------------*/
+void S2Conv_Init( S2Conv_t * aConv )
+{
+    aConv->steppitch = 0;
+    aConv->stepfront = 0;
+    S2Trig_Init( &( aConv->trig ) );
+    aConv->points = 0;
+    aConv->validity = 0;
+    aConv->vmin = 0;
+    aConv->vmax = 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Destruct conversion of recived scans
+ * @param *aConv Pointer to conversion
+ */
+/*--------------------------------------------------------------*/
+void S2Conv_Dest( S2Conv_t * aConv )
+{
+    S2Trig_Dest( &( aConv->trig ) );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Enable time of each step computed from rotation of sensor
+ * @param *aData Pointer to dual buffer structure
+ * @param *acpParam Parameters replied to Scip2CMD_PP, or NULL to disable
+ * @return failed: 0, succeeded: 1
+ * @attention steptime of scan is filled while data lines are decoded, with time of
+ *            the step ( center of grouped steps ) from time stamp [us].
+ *            Time stamp is taken as the time when the sensor faces step_front.
+ *            Effective from next Scip2CMD_GS / Scip2CMD_StartMS / Scip2CMD_StartND.
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_setStepTime( S2Sdd_t * aData, const S2Param_t * acpParam )
+{
+    if( acpParam == NULL )
+    {
+        aData->conv.steppitch = 0;
+        return 1;
+    }
+    if( acpParam->revolution <= 0 || acpParam->step_resolution <= 0 )
+        return 0;
+    aData->conv.steppitch = 60000000.0 / ( ( double )acpParam->revolution * acpParam->step_resolution );
+    aData->conv.stepfront = acpParam->step_front;
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Enable conversion of scans to Cartesian points by reciver
+ * @param *aData Pointer to dual buffer structure
+ * @param *acpParam Parameters replied to Scip2CMD_PP, or NULL to disable
+ * @param *acpPose Mounting pose of sensor, or NULL for points in the frame of sensor
+ * @return failed: 0, succeeded: 1
+ * @attention x and y of scan are filled before the scan is published ( see S2Trig_Convert ).
+ *            Table of directions is built once for start and group of scanning.
+ *            Effective from next Scip2CMD_GS / Scip2CMD_StartMS / Scip2CMD_StartND.
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_setPoints( S2Sdd_t * aData, const S2Param_t * acpParam, const S2Pose_t * acpPose )
+{
+    if( acpParam == NULL )
+    {
+        aData->conv.points = 0;
+        return 1;
+    }
+    if( !S2Trig_Setup( &( aData->conv.trig ), acpParam, acpPose ) )
+        return 0;
+    aData->conv.points = 1;
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Enable validity mask of steps made by reciver
+ * @param *aData Pointer to dual buffer structure
+ * @param *acpParam Parameters replied to Scip2CMD_PP, or NULL to disable
+ * @return failed: 0, succeeded: 1
+ * @attention Step is valid if its range is in dist_min to dist_max.  valid, nvalid and
+ *            ninvalid of scan are set before the scan is published ( see S2Range_Validate ).
+ *            Effective from next Scip2CMD_GS / Scip2CMD_StartMS / Scip2CMD_StartND.
+ */
+/*--------------------------------------------------------------*/
+int S2Sdd_setValidity( S2Sdd_t * aData, const S2Param_t * acpParam )
+{
+    if( acpParam == NULL )
+    {
+        aData->conv.validity = 0;
+        return 1;
+    }
+    if( acpParam->dist_min < 0 || acpParam->dist_max < acpParam->dist_min )
+        return 0;
+    aData->conv.vmin = acpParam->dist_min;
+    aData->conv.vmax = acpParam->dist_max;
+    aData->conv.validity = 1;
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Fill time of steps decoded from the line
+ * @param *aScan Pointer to buffer structure
+ * @param aFrom Number of values decoded before the line
+ * @param aTo Number of values decoded with the line
+ */
+/*--------------------------------------------------------------*/
+void S2Scan_StepTime( S2Scan_t * aScan, int aFrom, int aTo )
+{
+    //! Number of values par step
+    int multi;
+    //! Time of the step [us]
+    double t;
+    //! Loop valiant
+    int i;
+
+    multi = aScan->enc == SCIP2_ENC_3X2BYTE ? 2 : 1;
+    for ( i = aFrom / multi; i < ( aTo + multi - 1 ) / multi; i++ )
+    {
+        t = aScan->stepfirst + aScan->steppitch * i;
+        aScan->steptime[i] = ( int32_t ) ( t < 0 ? t - 0.5 : t + 0.5 );
+    }
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Set time of first step and pitch of steps of scan
+ * @param *aData Pointer to dual buffer structure
+ * @param *aScan Pointer to scan whose time stamp is decoded
+ * @attention Time of steps is filled while decoding ( grouped steps are at their center ).
+ *            Must be called by reciver before data lines are decoded.
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_StampSteps( S2Sdd_t * aData, S2Scan_t * aScan )
+{
+    if( !aScan->steptime )
+        return;
+    aScan->steppitch = aData->conv.steppitch * ( aScan->group > 1 ? aScan->group : 1 );
+    aScan->stepfirst = aData->conv.steppitch * ( aScan->start - aData->conv.stepfront )
+        + ( aScan->steppitch - aData->conv.steppitch ) / 2;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Make validity mask and Cartesian points of decoded scan
+ * @param *aData Pointer to dual buffer structure
+ * @param *aScan Pointer to decoded scan
+ * @attention Points are NAN if table of directions can not be built.
+ *            Must be called by reciver after S2Sdd_MarkDecode, so that it is counted in SCIP2_LAT_PUBLISH.
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_ToPoints( S2Sdd_t * aData, S2Scan_t * aScan )
+{
+    //! Number of values par step
+    int stride;
+    //! Loop valiant
+    int i;
+
+    //! Range is every other value of ME / NE / GE unless planar
+    stride = aScan->enc == SCIP2_ENC_3X2BYTE && !aScan->planar ? 2 : 1;
+    if( aScan->valid )
+        aScan->nvalid = S2Range_Validate( aScan->values, aScan->type, stride, aScan->nstep,
+                                          aData->conv.vmin, aData->conv.vmax, aScan->valid, aScan->ninvalid );
+    if( !aScan->x )
+        return;
+    if( !S2Trig_Build( &( aData->conv.trig ), aScan->start, aScan->group, aScan->nstep ) )
+    {
+        for ( i = 0; i < aScan->nstep; i++ )
+            aScan->x[i] = aScan->y[i] = NAN;
+        return;
+    }
+    S2Trig_Convert( &( aData->conv.trig ), aScan->values, aScan->type, stride, aScan->nstep, aScan->x, aScan->y );
+}
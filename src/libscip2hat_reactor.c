@@ -0,0 +1,310 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_reactor.c
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+#include "scip2hat.h"
+
+
+
+#ifdef __linux__
+/*--------------------------------------------------------------*/
+/**
+ * @brief Parse lines already recived by the port
+ * @param *aReactor Pointer to event loop
+ * @param *aData Pointer to dual buffer structure
+ * @return stopped: 0, continue: 1
+ */
+/*--------------------------------------------------------------*/
+static int S2Reactor_Drain( S2Reactor_t * aReactor, S2Sdd_t * aData )
+{
+    //! Pointer to the line in ring buffer of port
+    char *line;
+    //! Length of the line
+    int len;
+
+    while( ( line = Scip2_PollLine( aData->thr->port, &len ) ) != NULL )
+    {
+        if( S2Sdd_ParseCont( aData, line, len ) <= 0 )
+        {
+            S2Reactor_Remove( aReactor, aData );
+            S2Sdd_Notify( aData );
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Event loop thread
+ * @param *aArg Pointer to event loop
+ */
+/*--------------------------------------------------------------*/
+static void *S2Reactor_Loop( void *aArg )
+{
+    //! Pointer to event loop
+    S2Reactor_t *reactor;
+    //! Pointer to dual buffer structure
+    S2Sdd_t *data;
+    //! Recived events
+    struct epoll_event events[SCIP2_REACTOR_EVENTS];
+    //! Generation of registration before waiting
+    int generation;
+    //! Number of events
+    int nev;
+    //! Command recived by wake up pipe
+    char cmd;
+    //! Loop valiant
+    int i;
+
+    reactor = ( S2Reactor_t * ) aArg;
+
+    while( 1 )
+    {
+        pthread_mutex_lock( &( reactor->mutex ) );
+        generation = reactor->generation;
+        pthread_mutex_unlock( &( reactor->mutex ) );
+
+        nev = epoll_wait( reactor->epfd, events, SCIP2_REACTOR_EVENTS, -1 );
+        if( nev < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+#ifdef SCIP2_DEBUG
+            fprintf( stderr, "SCIP2 ERROR: epoll_wait failed.\n" );
+            fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+            break;
+        }
+
+        pthread_mutex_lock( &( reactor->mutex ) );
+        //! Events may refer to the buffer removed while waiting
+        if( generation != reactor->generation )
+        {
+            pthread_mutex_unlock( &( reactor->mutex ) );
+            continue;
+        }
+        for ( i = 0; i < nev; i++ )
+        {
+            data = ( S2Sdd_t * ) events[i].data.ptr;
+            if( data == NULL )
+            {
+                if( read( reactor->wake[0], &cmd, 1 ) != 1 || cmd == 's' )
+                {
+                    pthread_mutex_unlock( &( reactor->mutex ) );
+                    return NULL;
+                }
+                //! Lines recived before registration
+                for ( i = reactor->nsdd - 1; i >= 0; i-- )
+                    S2Reactor_Drain( reactor, reactor->sdd[i] );
+                break;
+            }
+            if( !data->active )
+                continue;
+            if( Scip2_Fill( data->thr->port ) <= 0 )
+            {
+                S2Sdd_ParseCont( data, NULL, 0 );
+                S2Reactor_Remove( reactor, data );
+                S2Sdd_Notify( data );
+                continue;
+            }
+            S2Reactor_Drain( reactor, data );
+        }
+        pthread_mutex_unlock( &( reactor->mutex ) );
+    }
+    return NULL;
+}
+#endif											/* __linux__ */
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Initialize event loop and start its thread
+ * @param *aReactor Pointer to event loop
+ * @return failed: 0, succeeded: 1
+ */
+/*--------------------------------------------------------------*/
+int S2Reactor_Init( S2Reactor_t * aReactor )
+{
+#ifdef __linux__
+    //! Event to wake up
+    struct epoll_event ev;
+
+    aReactor->nsdd = 0;
+    aReactor->generation = 0;
+    if( pipe( aReactor->wake ) != 0 )
+        return 0;
+    aReactor->epfd = epoll_create( SCIP2_REACTOR_MAX_SENSOR );
+    if( aReactor->epfd < 0 )
+    {
+#ifdef SCIP2_DEBUG
+        fprintf( stderr, "SCIP2 ERROR: Failed to create epoll.\n" );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+        close( aReactor->wake[0] );
+        close( aReactor->wake[1] );
+        return 0;
+    }
+    memset( &ev, 0, sizeof ( ev ) );
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    epoll_ctl( aReactor->epfd, EPOLL_CTL_ADD, aReactor->wake[0], &ev );
+
+    pthread_mutex_init( &( aReactor->mutex ), 0 );
+    if( pthread_create( &( aReactor->thread ), NULL, S2Reactor_Loop, ( void * )aReactor ) != 0 )
+    {
+        pthread_mutex_destroy( &( aReactor->mutex ) );
+        close( aReactor->epfd );
+        close( aReactor->wake[0] );
+        close( aReactor->wake[1] );
+        return 0;
+    }
+    return 1;
+#else
+#ifdef SCIP2_DEBUG
+    fprintf( stderr, "SCIP2 ERROR: Event loop is not supported on this platform.\n" );
+    fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+    return 0;
+#endif											/* __linux__ */
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Stop event loop thread and destruct it
+ * @param *aReactor Pointer to event loop
+ * @attention Continuous scanning serviced by the loop is stopped without QT.
+ */
+/*--------------------------------------------------------------*/
+void S2Reactor_Dest( S2Reactor_t * aReactor )
+{
+#ifdef __linux__
+    //! Command to stop
+    char cmd = 's';
+
+    if( write( aReactor->wake[1], &cmd, 1 ) == 1 )
+        pthread_join( aReactor->thread, NULL );
+
+    while( aReactor->nsdd > 0 )
+        S2Reactor_Remove( aReactor, aReactor->sdd[0] );
+
+    pthread_mutex_destroy( &( aReactor->mutex ) );
+    close( aReactor->epfd );
+    close( aReactor->wake[0] );
+    close( aReactor->wake[1] );
+#endif											/* __linux__ */
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Start servicing continuous scanning in event loop
+ * @param *aReactor Pointer to event loop
+ * @param *aData Pointer to dual buffer structure
+ * @return failed: 0, succeeded: 1
+ */
+/*--------------------------------------------------------------*/
+int S2Reactor_Add( S2Reactor_t * aReactor, S2Sdd_t * aData )
+{
+#ifdef __linux__
+    //! Event of the port
+    struct epoll_event ev;
+    //! Command to parse lines already recived
+    char cmd = 'k';
+
+    pthread_mutex_lock( &( aReactor->mutex ) );
+    if( aReactor->nsdd >= SCIP2_REACTOR_MAX_SENSOR || aData->active || !S2Sdd_InitCont( aData ) )
+    {
+        pthread_mutex_unlock( &( aReactor->mutex ) );
+        return 0;
+    }
+    memset( &ev, 0, sizeof ( ev ) );
+    ev.events = EPOLLIN;
+    ev.data.ptr = aData;
+    if( epoll_ctl( aReactor->epfd, EPOLL_CTL_ADD, aData->thr->port->fd, &ev ) != 0 )
+    {
+#ifdef SCIP2_DEBUG
+        fprintf( stderr, "SCIP2 ERROR: Failed to add port to epoll.\n" );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+        pthread_mutex_unlock( &( aReactor->mutex ) );
+        return 0;
+    }
+    aReactor->sdd[aReactor->nsdd] = aData;
+    aReactor->nsdd++;
+    aData->reactor = aReactor;
+    aData->active = 1;
+    pthread_mutex_unlock( &( aReactor->mutex ) );
+
+    if( aData->thr->port->tail != aData->thr->port->head )
+    {
+        if( write( aReactor->wake[1], &cmd, 1 ) != 1 )
+            return 0;
+    }
+    return 1;
+#else
+    return 0;
+#endif											/* __linux__ */
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Stop servicing continuous scanning in event loop
+ * @param *aReactor Pointer to event loop
+ * @param *aData Pointer to dual buffer structure
+ * @attention Can be called in both the event loop and other threads.
+ */
+/*--------------------------------------------------------------*/
+void S2Reactor_Remove( S2Reactor_t * aReactor, S2Sdd_t * aData )
+{
+#ifdef __linux__
+    //! Loop valiant
+    int i;
+    //! Called from event loop itself
+    int self;
+
+    self = pthread_equal( pthread_self(  ), aReactor->thread );
+    if( !self )
+        pthread_mutex_lock( &( aReactor->mutex ) );
+    if( aData->active )
+    {
+        epoll_ctl( aReactor->epfd, EPOLL_CTL_DEL, aData->thr->port->fd, NULL );
+        for ( i = 0; i < aReactor->nsdd; i++ )
+        {
+            if( aReactor->sdd[i] == aData )
+            {
+                aReactor->nsdd--;
+                aReactor->sdd[i] = aReactor->sdd[aReactor->nsdd];
+                break;
+            }
+        }
+        aData->active = 0;
+        aReactor->generation++;
+    }
+    if( !self )
+        pthread_mutex_unlock( &( aReactor->mutex ) );
+#endif											/* __linux__ */
+}
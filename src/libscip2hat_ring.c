@@ -0,0 +1,224 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_ring.c
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scip2hat.h"
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Initialize broadcast ring
+ * @param *aRing Pointer to broadcast ring
+ */
+/*--------------------------------------------------------------*/
+void S2Ring_Init( S2Ring_t * aRing )
+{
+    //! Loop valiant
+    int i;
+
+    aRing->seq = 0;
+    aRing->nring = 0;
+    for ( i = 0; i < SCIP2_RING_MAX; i++ )
+        aRing->scan[i] = NULL;
+    pthread_mutex_init( &( aRing->mutex ), 0 );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Destruct broadcast ring
+ * @param *aRing Pointer to broadcast ring
+ * @attention Scans in ring are not released ( see S2Ring_Flush ).
+ */
+/*--------------------------------------------------------------*/
+void S2Ring_Dest( S2Ring_t * aRing )
+{
+    pthread_mutex_destroy( &( aRing->mutex ) );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Release all scans in broadcast ring
+ * @param *aRing Pointer to broadcast ring
+ */
+/*--------------------------------------------------------------*/
+void S2Ring_Flush( S2Ring_t * aRing )
+{
+    //! Loop valiant
+    int i;
+
+    pthread_mutex_lock( &( aRing->mutex ) );
+    for ( i = 0; i < aRing->nring; i++ )
+    {
+        if( aRing->scan[i] )
+            __atomic_sub_fetch( &( aRing->scan[i]->ref ), 1, __ATOMIC_RELEASE );
+        aRing->scan[i] = NULL;
+    }
+    pthread_mutex_unlock( &( aRing->mutex ) );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Put published scan into broadcast ring
+ * @param *aRing Pointer to broadcast ring
+ * @param *aScan Pointer to published scan stamped with next sequence number
+ * @attention Oldest scan in the ring is released.  Must be called by reciver.
+ */
+/*--------------------------------------------------------------*/
+void S2Ring_Put( S2Ring_t * aRing, S2Scan_t * aScan )
+{
+    //! Scan pushed out of ring
+    S2Scan_t *old;
+
+    pthread_mutex_lock( &( aRing->mutex ) );
+    old = NULL;
+    if( aRing->nring > 0 )
+    {
+        old = aRing->scan[aScan->seq % aRing->nring];
+        __atomic_add_fetch( &( aScan->ref ), 1, __ATOMIC_ACQ_REL );
+        aRing->scan[aScan->seq % aRing->nring] = aScan;
+    }
+    __atomic_store_n( &( aRing->seq ), aScan->seq, __ATOMIC_RELEASE );
+    pthread_mutex_unlock( &( aRing->mutex ) );
+    if( old )
+        __atomic_sub_fetch( &( old->ref ), 1, __ATOMIC_RELEASE );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Set length of broadcast ring followed by S2Reader_t
+ * @param *aData Pointer to dual buffer structure
+ * @param aNRing Number of latest scans kept for readers ( 0 - SCIP2_RING_MAX, 0: disabled ).
+ *        Scans in ring are held, so that the pool is enlarged to aNRing + 3 buffers at least.
+ *        Give the pool one more buffer for each scan held by readers ( see S2Sdd_setPool ).
+ *        Effective from next Scip2CMD_GS / Scip2CMD_StartMS / Scip2CMD_StartND.
+ */
+/*--------------------------------------------------------------*/
+void S2Sdd_setRing( S2Sdd_t * aData, int aNRing )
+{
+    if( aNRing < 0 )
+        aNRing = 0;
+    if( aNRing > SCIP2_RING_MAX )
+        aNRing = SCIP2_RING_MAX;
+    S2Ring_Flush( &( aData->ring ) );
+    pthread_mutex_lock( &( aData->ring.mutex ) );
+    aData->ring.nring = aNRing;
+    pthread_mutex_unlock( &( aData->ring.mutex ) );
+    if( aData->npool < aNRing + 3 )
+        S2Sdd_setPool( aData, aNRing + 3 );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Initialize reader of broadcast ring
+ * @param *aReader Pointer to reader
+ * @param *aData Pointer to dual buffer structure with ring ( see S2Sdd_setRing )
+ * @attention Reader starts from the scan published next.
+ */
+/*--------------------------------------------------------------*/
+void S2Reader_Init( S2Reader_t * aReader, S2Sdd_t * aData )
+{
+    aReader->sdd = aData;
+    aReader->seq = __atomic_load_n( &( aData->ring.seq ), __ATOMIC_ACQUIRE );
+    aReader->skipped = 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Acquire next scan of broadcast ring ( Non-Blocking )
+ * @param *aReader Pointer to reader
+ * @param **aScan Pointer to buffer structure handle
+ * @return fatal error: -1, no new scan: 0, succeeded: 1
+ * @attention Scans are returned in order of sequence number.  Scans pushed out of ring
+ *            before being read are added to skipped of the reader.
+ *            Scan must be released by S2Reader_Release.
+ */
+/*--------------------------------------------------------------*/
+int S2Reader_Next( S2Reader_t * aReader, S2Scan_t ** aScan )
+{
+    //! Pointer to broadcast ring
+    S2Ring_t *ring;
+    //! Sequence number of next scan
+    unsigned long next;
+    //! Scan in ring
+    S2Scan_t *scan;
+
+    if( S2Sdd_LoadError( aReader->sdd ) )
+        return -1;
+
+    ring = &( aReader->sdd->ring );
+    pthread_mutex_lock( &( ring->mutex ) );
+    next = aReader->seq + 1;
+    if( ring->nring > 0 && ring->seq >= ( unsigned long )ring->nring && next <= ring->seq - ring->nring )
+        next = ring->seq - ring->nring + 1;
+    //! Scans released from ring by restart are also skipped
+    while( next <= ring->seq && ring->nring > 0 )
+    {
+        scan = ring->scan[next % ring->nring];
+        if( scan && scan->seq == next )
+        {
+            __atomic_add_fetch( &( scan->ref ), 1, __ATOMIC_ACQ_REL );
+            aReader->skipped += next - aReader->seq - 1;
+            aReader->seq = next;
+            pthread_mutex_unlock( &( ring->mutex ) );
+            *aScan = scan;
+            return 1;
+        }
+        next++;
+    }
+    aReader->skipped += ring->seq - aReader->seq;
+    aReader->seq = ring->seq;
+    pthread_mutex_unlock( &( ring->mutex ) );
+    return 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Release scan acquired by S2Reader_Next
+ * @param *aReader Pointer to reader
+ * @param *aScan Pointer to acquired scan
+ */
+/*--------------------------------------------------------------*/
+void S2Reader_Release( S2Reader_t * aReader, S2Scan_t * aScan )
+{
+    S2Sdd_Release( aReader->sdd, aScan );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Wait for scan not read by the reader yet ( Blocking )
+ * @param *aReader Pointer to reader
+ * @param aTimeout Timeout in milliseconds ( negative: infinite )
+ * @return fatal error: -1, timeout: 0, new scan is ready to S2Reader_Next: 1
+ */
+/*--------------------------------------------------------------*/
+int S2Reader_Wait( S2Reader_t * aReader, int aTimeout )
+{
+    return S2Sdd_WaitReady( aReader->sdd, aReader, aTimeout );
+}
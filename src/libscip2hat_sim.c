@@ -0,0 +1,982 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_sim.c
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "scip2hat.h"
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Initialize model of simulated sensor as UTM-30LX
+ * @param *apModel Pointer to model
+ */
+/*--------------------------------------------------------------*/
+void S2Sim_InitModel( S2SimModel_t * apModel )
+{
+    memset( apModel, 0, sizeof ( S2SimModel_t ) );
+    strcpy( apModel->param.model, "UTM-30LX(SIM)" );
+    apModel->param.dist_min = 23;
+    apModel->param.dist_max = 60000;
+    apModel->param.step_resolution = 1440;
+    apModel->param.step_min = 0;
+    apModel->param.step_max = 1080;
+    apModel->param.step_front = 540;
+    apModel->param.revolution = 2400;
+    apModel->pattern = SCIP2_SIM_RAMP;
+    apModel->range = 1000;
+    apModel->noise = 0;
+    apModel->glitch = 0;
+    apModel->time_offset = 0;
+    apModel->seed = 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Calculate checksum charactor of SCIP2.0 line
+ * @param *acpLine Pointer to the line
+ * @param aLen Length of the line
+ * @return Checksum charactor
+ */
+/*--------------------------------------------------------------*/
+static char S2Sim_Sum( const char *acpLine, int aLen )
+{
+    //! Sum of charactors
+    unsigned int sum;
+    //! Loop valiant
+    int i;
+
+    sum = 0;
+    for ( i = 0; i < aLen; i++ )
+        sum += ( unsigned char )acpLine[i];
+
+    return ( sum & 0x3F ) + 0x30;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Append bytes to output buffer
+ * @param *aSim Pointer to simulated sensor
+ * @param *acpBuf Pointer to bytes
+ * @param aLen Number of bytes
+ */
+/*--------------------------------------------------------------*/
+static void S2Sim_Put( S2Sim_t * aSim, const char *acpBuf, int aLen )
+{
+    if( aSim->nout + aLen > aSim->outsize )
+        aLen = aSim->outsize - aSim->nout;
+    memcpy( aSim->out + aSim->nout, acpBuf, aLen );
+    aSim->nout += aLen;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Append line with checksum to output buffer
+ * @param *aSim Pointer to simulated sensor
+ * @param *acpLine Pointer to the line without checksum and LF
+ * @param aLen Length of the line
+ */
+/*--------------------------------------------------------------*/
+static void S2Sim_PutSum( S2Sim_t * aSim, const char *acpLine, int aLen )
+{
+    //! Checksum and LF
+    char tail[2];
+
+    tail[0] = S2Sim_Sum( acpLine, aLen );
+    tail[1] = '\n';
+    S2Sim_Put( aSim, acpLine, aLen );
+    S2Sim_Put( aSim, tail, 2 );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Append echo back and status to output buffer
+ * @param *aSim Pointer to simulated sensor
+ * @param *acpEcho Pointer to recived command line without LF
+ * @param *acpStatus Pointer to 2 charactors of status
+ */
+/*--------------------------------------------------------------*/
+static void S2Sim_PutStatus( S2Sim_t * aSim, const char *acpEcho, const char *acpStatus )
+{
+    S2Sim_Put( aSim, acpEcho, strlen( acpEcho ) );
+    S2Sim_Put( aSim, "\n", 1 );
+    S2Sim_PutSum( aSim, acpStatus, 2 );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Append encoded value to line
+ * @param *apBuf Pointer to the line
+ * @param aValue Value
+ * @param aNChar Number of charactors ( 2 - 4 )
+ */
+/*--------------------------------------------------------------*/
+static void S2Sim_Encode( char *apBuf, unsigned long aValue, int aNChar )
+{
+    //! Loop valiant
+    int i;
+
+    for ( i = aNChar - 1; i >= 0; i-- )
+    {
+        apBuf[i] = ( aValue & 0x3F ) + 0x30;
+        aValue >>= 6;
+    }
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get time stamp of device
+ * @param *aSim Pointer to simulated sensor
+ * @return Time stamp [ms] ( 24 bits )
+ */
+/*--------------------------------------------------------------*/
+static unsigned long S2Sim_Time( S2Sim_t * aSim )
+{
+    //! Current time
+    struct timespec now;
+    //! Elapsed time [ms]
+    unsigned long elapsed;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    elapsed = ( now.tv_sec - aSim->start.tv_sec ) * 1000 + ( now.tv_nsec - aSim->start.tv_nsec ) / 1000000;
+
+    return ( elapsed + aSim->model.time_offset ) & 0xFFFFFF;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Append time stamp line to output buffer
+ * @param *aSim Pointer to simulated sensor
+ */
+/*--------------------------------------------------------------*/
+static void S2Sim_PutTime( S2Sim_t * aSim )
+{
+    //! Encoded time stamp
+    char buf[4];
+
+    S2Sim_Encode( buf, S2Sim_Time( aSim ), 4 );
+    S2Sim_PutSum( aSim, buf, 4 );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Synthetic range of the step
+ * @param *aSim Pointer to simulated sensor
+ * @param aStep Step
+ * @return Range [mm]
+ */
+/*--------------------------------------------------------------*/
+static unsigned long S2Sim_Range( S2Sim_t * aSim, int aStep )
+{
+    //! Span of pattern
+    long span;
+    //! Phase of pattern
+    long phase;
+    //! Range
+    long range;
+
+    span = aSim->model.param.dist_max - aSim->model.range;
+    if( span < 1 )
+        span = 1;
+    switch ( aSim->model.pattern )
+    {
+    case SCIP2_SIM_RAMP:
+        range = aSim->model.range + ( aStep * 10 + ( long )aSim->nscan ) % span;
+        break;
+    case SCIP2_SIM_WAVE:
+        phase = ( aStep * 8 + ( long )aSim->nscan * 16 ) % 2000;
+        if( phase >= 1000 )
+            phase = 2000 - phase;
+        range = aSim->model.range + phase;
+        break;
+    default:
+        range = aSim->model.range;
+        break;
+    }
+    if( range > aSim->model.param.dist_max )
+        range = aSim->model.param.dist_max;
+
+    return range;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Append scanned data block to output buffer
+ * @param *aSim Pointer to simulated sensor
+ * @param aType Charactor of encode type ( 'S': 2 bytes, 'D': 3 bytes, 'E': 3 bytes x2 )
+ * @param aStart Start step
+ * @param aEnd End step
+ * @param aGroup Number of group
+ */
+/*--------------------------------------------------------------*/
+static void S2Sim_PutData( S2Sim_t * aSim, char aType, int aStart, int aEnd, int aGroup )
+{
+    //! Number of data charactors
+    int n;
+    //! Range of the group ( minimum of the steps )
+    unsigned long range;
+    //! Range of the step
+    unsigned long r;
+    //! Number of charactors of the line
+    int len;
+    //! Loop valiant
+    int i, j;
+
+    n = 0;
+    for ( i = aStart; i <= aEnd; i += aGroup )
+    {
+        range = S2Sim_Range( aSim, i );
+        for ( j = i + 1; j < i + aGroup && j <= aEnd; j++ )
+        {
+            r = S2Sim_Range( aSim, j );
+            if( r < range )
+                range = r;
+        }
+        if( aType == 'S' )
+        {
+            S2Sim_Encode( aSim->data + n, range > 4095 ? 4095 : range, 2 );
+            n += 2;
+        }
+        else
+        {
+            S2Sim_Encode( aSim->data + n, range, 3 );
+            n += 3;
+        }
+        if( aType == 'E' )
+        {
+            S2Sim_Encode( aSim->data + n, 1000 + ( i * 7 + aSim->nscan ) % 3000, 3 );
+            n += 3;
+        }
+    }
+
+    //! Split into lines of 64 charactors
+    for ( i = 0; i < n; i += 64 )
+    {
+        len = n - i < 64 ? n - i : 64;
+        S2Sim_PutSum( aSim, aSim->data + i, len );
+        if( aSim->model.noise > 0 && rand_r( &( aSim->rand ) ) % aSim->model.noise == 0 )
+        {
+            //! Flip one bit of a charactor to break checksum
+            aSim->out[aSim->nout - 2 - len + rand_r( &( aSim->rand ) ) % len] ^= 0x01;
+            __atomic_add_fetch( &( aSim->nnoise ), 1, __ATOMIC_RELAXED );
+        }
+    }
+    S2Sim_Put( aSim, "\n", 1 );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Send output buffer to client
+ * @param *aSim Pointer to simulated sensor
+ * @attention Bytes which client does not take in 100 ms are dropped as serial line does.
+ */
+/*--------------------------------------------------------------*/
+static void S2Sim_Flush( S2Sim_t * aSim )
+{
+    //! Client to wait for
+    struct pollfd fds;
+    //! Number of sent bytes
+    int n;
+    //! return value of write
+    ssize_t ret;
+
+    for ( n = 0; n < aSim->nout && aSim->fd >= 0; n += ret )
+    {
+        if( aSim->tcp )
+            ret = send( aSim->fd, aSim->out + n, aSim->nout - n, MSG_NOSIGNAL );
+        else
+            ret = write( aSim->fd, aSim->out + n, aSim->nout - n );
+        if( ret >= 0 )
+            continue;
+        ret = 0;
+        if( errno == EINTR )
+            continue;
+        if( errno != EAGAIN && errno != EWOULDBLOCK )
+            break;
+        fds.fd = aSim->fd;
+        fds.events = POLLOUT;
+        if( poll( &fds, 1, 100 ) <= 0 )
+            break;
+    }
+    aSim->nout = 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Append VV or PP parameter line to output buffer
+ * @param *aSim Pointer to simulated sensor
+ * @param *acpName Pointer to name of parameter
+ * @param *acpValue Pointer to value of parameter
+ */
+/*--------------------------------------------------------------*/
+static void S2Sim_PutParam( S2Sim_t * aSim, const char *acpName, const char *acpValue )
+{
+    //! Parameter line
+    char buf[SCIP2_MAX_LENGTH];
+    //! Length of the line
+    int len;
+
+    len = snprintf( buf, sizeof ( buf ) - 3, "%s:%s", acpName, acpValue );
+    if( len > ( int )sizeof ( buf ) - 4 )
+        len = sizeof ( buf ) - 4;
+    buf[len] = ';';
+    buf[len + 1] = S2Sim_Sum( buf, len );
+    buf[len + 2] = '\n';
+    S2Sim_Put( aSim, buf, len + 3 );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Stop continuous scanning and forget GS commands
+ * @param *aSim Pointer to simulated sensor
+ */
+/*--------------------------------------------------------------*/
+static void S2Sim_Reset( S2Sim_t * aSim )
+{
+    aSim->stream[0] = 0;
+    aSim->ngs = 0;
+    aSim->laser = 0;
+    aSim->tmmode = 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Check range of scanning requested by command
+ * @param *aSim Pointer to simulated sensor
+ * @param aStart Start step
+ * @param aEnd End step
+ * @return invalid: 0, valid: 1
+ */
+/*--------------------------------------------------------------*/
+static int S2Sim_IsRange( S2Sim_t * aSim, int aStart, int aEnd )
+{
+    return aStart >= aSim->model.param.step_min && aEnd <= aSim->model.param.step_max && aStart <= aEnd;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Answer one command line
+ * @param *aSim Pointer to simulated sensor
+ * @param *apLine Pointer to the line without LF ( null terminated )
+ */
+/*--------------------------------------------------------------*/
+static void S2Sim_Command( S2Sim_t * aSim, char *apLine )
+{
+    //! Command without string tag
+    char cmd[SCIP2_MAX_LENGTH];
+    //! Parameter value
+    char val[SCIP2_MAX_LENGTH];
+    //! Length of command
+    int len;
+    //! Parameters of scanning
+    int start, end, group, cull, num;
+
+    len = strcspn( apLine, ";" );
+    if( len == 0 || len >= SCIP2_MAX_LENGTH )
+        return;
+    memcpy( cmd, apLine, len );
+    cmd[len] = 0;
+
+    if( strcmp( cmd, "SCIP2.0" ) == 0 )
+        S2Sim_PutStatus( aSim, apLine, "00" );
+    else if( strcmp( cmd, "BM" ) == 0 )
+    {
+        S2Sim_PutStatus( aSim, apLine, aSim->laser ? "02" : "00" );
+        aSim->laser = 1;
+    }
+    else if( strcmp( cmd, "QT" ) == 0 )
+    {
+        aSim->stream[0] = 0;
+        aSim->laser = 0;
+        S2Sim_PutStatus( aSim, apLine, "00" );
+    }
+    else if( strcmp( cmd, "RS" ) == 0 || strcmp( cmd, "RT" ) == 0 )
+    {
+        S2Sim_Reset( aSim );
+        S2Sim_PutStatus( aSim, apLine, "00" );
+    }
+    else if( strncmp( cmd, "SS", 2 ) == 0 && len == 8 )
+        S2Sim_PutStatus( aSim, apLine, "00" );
+    else if( strncmp( cmd, "CR", 2 ) == 0 && len == 4 )
+        S2Sim_PutStatus( aSim, apLine, "00" );
+    else if( strcmp( cmd, "TM0" ) == 0 )
+    {
+        S2Sim_PutStatus( aSim, apLine, aSim->tmmode ? "02" : "00" );
+        aSim->tmmode = 1;
+    }
+    else if( strcmp( cmd, "TM1" ) == 0 )
+    {
+        S2Sim_PutStatus( aSim, apLine, aSim->tmmode ? "00" : "01" );
+        if( aSim->tmmode )
+            S2Sim_PutTime( aSim );
+    }
+    else if( strcmp( cmd, "TM2" ) == 0 )
+    {
+        S2Sim_PutStatus( aSim, apLine, aSim->tmmode ? "00" : "03" );
+        aSim->tmmode = 0;
+    }
+    else if( strcmp( cmd, "VV" ) == 0 )
+    {
+        S2Sim_PutStatus( aSim, apLine, "00" );
+        S2Sim_PutParam( aSim, "VEND", "libscip2hat" );
+        S2Sim_PutParam( aSim, "PROD", aSim->model.param.model );
+        S2Sim_PutParam( aSim, "FIRM", "1.0.0(simulator)" );
+        S2Sim_PutParam( aSim, "PROT", "SCIP 2.0" );
+        S2Sim_PutParam( aSim, "SERI", aSim->name );
+    }
+    else if( strcmp( cmd, "PP" ) == 0 )
+    {
+        S2Sim_PutStatus( aSim, apLine, "00" );
+        S2Sim_PutParam( aSim, "MODL", aSim->model.param.model );
+        sprintf( val, "%d", aSim->model.param.dist_min );
+        S2Sim_PutParam( aSim, "DMIN", val );
+        sprintf( val, "%d", aSim->model.param.dist_max );
+        S2Sim_PutParam( aSim, "DMAX", val );
+        sprintf( val, "%d", aSim->model.param.step_resolution );
+        S2Sim_PutParam( aSim, "ARES", val );
+        sprintf( val, "%d", aSim->model.param.step_min );
+        S2Sim_PutParam( aSim, "AMIN", val );
+        sprintf( val, "%d", aSim->model.param.step_max );
+        S2Sim_PutParam( aSim, "AMAX", val );
+        sprintf( val, "%d", aSim->model.param.step_front );
+        S2Sim_PutParam( aSim, "AFRT", val );
+        sprintf( val, "%d", aSim->model.param.revolution );
+        S2Sim_PutParam( aSim, "SCAN", val );
+    }
+    else if( cmd[0] == 'G' && strchr( "SDE", cmd[1] ) && len == 12 )
+    {
+        if( sscanf( cmd + 2, "%4d%4d%2d", &start, &end, &group ) != 3 || !S2Sim_IsRange( aSim, start, end ) )
+            S2Sim_PutStatus( aSim, apLine, "04" );
+        else if( !aSim->laser )
+            S2Sim_PutStatus( aSim, apLine, "10" );
+        else if( aSim->ngs >= SCIP2_SIM_QUEUE )
+            S2Sim_PutStatus( aSim, apLine, "0E" );
+        else
+        {
+            //! Replied after next scan
+            strcpy( aSim->gs[aSim->ngs], apLine );
+            aSim->ngs++;
+            return;
+        }
+    }
+    else if( ( cmd[0] == 'M' || cmd[0] == 'N' ) && strchr( cmd[0] == 'M' ? "SDE" : "DE", cmd[1] ) && len == 15 )
+    {
+        if( sscanf( cmd + 2, "%4d%4d%2d%1d%2d", &start, &end, &group, &cull, &num ) != 5
+            || !S2Sim_IsRange( aSim, start, end ) )
+            S2Sim_PutStatus( aSim, apLine, "04" );
+        else
+        {
+            S2Sim_PutStatus( aSim, apLine, "00" );
+            strcpy( aSim->stream, apLine );
+            aSim->sstart = start;
+            aSim->send = end;
+            aSim->sgroup = group > 0 ? group : 1;
+            aSim->scull = cull;
+            aSim->snum = num;
+            aSim->ssent = 0;
+            aSim->laser = 1;
+        }
+    }
+    else
+        S2Sim_PutStatus( aSim, apLine, "0E" );
+
+    S2Sim_Put( aSim, "\n", 1 );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Output scan to continuous scanning and waiting GS commands
+ * @param *aSim Pointer to simulated sensor
+ */
+/*--------------------------------------------------------------*/
+static void S2Sim_Scan( S2Sim_t * aSim )
+{
+    //! Echo back of the frame
+    char echo[SCIP2_MAX_LENGTH];
+    //! Remaining number of scans
+    int remain;
+    //! Parameters of GS command
+    int start, end, group;
+    //! Loop valiant
+    int i;
+
+    aSim->nscan++;
+
+    for ( i = 0; i < aSim->ngs; i++ )
+    {
+        sscanf( aSim->gs[i] + 2, "%4d%4d%2d", &start, &end, &group );
+        S2Sim_PutStatus( aSim, aSim->gs[i], "00" );
+        S2Sim_PutTime( aSim );
+        S2Sim_PutData( aSim, aSim->gs[i][1], start, end, group > 0 ? group : 1 );
+        __atomic_add_fetch( &( aSim->nframe ), 1, __ATOMIC_RELAXED );
+    }
+    aSim->ngs = 0;
+
+    if( aSim->stream[0] && aSim->nscan % ( aSim->scull + 1 ) == 0 )
+    {
+        aSim->ssent++;
+        remain = aSim->snum > 0 ? aSim->snum - aSim->ssent : 0;
+        strcpy( echo, aSim->stream );
+        echo[13] = '0' + remain / 10;
+        echo[14] = '0' + remain % 10;
+        if( aSim->model.glitch > 0 && rand_r( &( aSim->rand ) ) % aSim->model.glitch == 0 )
+        {
+            //! Flip one bit of command to break the frame
+            echo[1] ^= 0x20;
+            __atomic_add_fetch( &( aSim->nglitch ), 1, __ATOMIC_RELAXED );
+        }
+        S2Sim_PutStatus( aSim, echo, "99" );
+        S2Sim_PutTime( aSim );
+        S2Sim_PutData( aSim, aSim->stream[1], aSim->sstart, aSim->send, aSim->sgroup );
+        __atomic_add_fetch( &( aSim->nframe ), 1, __ATOMIC_RELAXED );
+        if( aSim->snum > 0 && remain <= 0 )
+        {
+            aSim->stream[0] = 0;
+            aSim->laser = 0;
+        }
+    }
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Read commands from client and answer them
+ * @param *aSim Pointer to simulated sensor
+ * @return client is closed: 0, continue: 1
+ */
+/*--------------------------------------------------------------*/
+static int S2Sim_Recv( S2Sim_t * aSim )
+{
+    //! return value of read
+    ssize_t ret;
+    //! Terminater of the line
+    char *term;
+    //! Length of the line
+    int len;
+
+    ret = read( aSim->fd, aSim->in + aSim->nin, SCIP2_SIM_INSIZE - 1 - aSim->nin );
+    if( ret < 0 && ( errno == EINTR || errno == EAGAIN ) )
+        return 1;
+    if( ret <= 0 )
+        return 0;
+    aSim->nin += ret;
+    aSim->in[aSim->nin] = 0;
+
+    while( ( term = strpbrk( aSim->in, "\r\n" ) ) != NULL )
+    {
+        *term = 0;
+        len = term - aSim->in + 1;
+        S2Sim_Command( aSim, aSim->in );
+        aSim->nin -= len;
+        memmove( aSim->in, aSim->in + len, aSim->nin + 1 );
+    }
+    //! Too long line is discarded
+    if( aSim->nin >= SCIP2_SIM_INSIZE - 1 )
+        aSim->nin = 0;
+    S2Sim_Flush( aSim );
+
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Simulator thread
+ * @param *aArg Pointer to simulated sensor
+ */
+/*--------------------------------------------------------------*/
+static void *S2Sim_Loop( void *aArg )
+{
+    //! Pointer to simulated sensor
+    S2Sim_t *sim;
+    //! Wake up pipe, listening socket and client
+    struct pollfd fds[3];
+    //! Number of fds to poll
+    int nfds;
+    //! Current time
+    struct timespec now;
+    //! Period of scan [ns]
+    long period;
+    //! Time out of poll [ms]
+    long timeout;
+    //! return value of poll
+    int ret;
+    //! Option value of socket
+    int on;
+
+    sim = ( S2Sim_t * ) aArg;
+    on = 1;
+    period = 60000000000L / ( sim->model.param.revolution > 0 ? sim->model.param.revolution : 600 );
+    clock_gettime( CLOCK_MONOTONIC, &( sim->next ) );
+
+    while( 1 )
+    {
+        fds[0].fd = sim->wake[0];
+        fds[0].events = POLLIN;
+        nfds = 1;
+        if( sim->fd < 0 )
+            fds[nfds].fd = sim->listenfd;
+        else
+            fds[nfds].fd = sim->fd;
+        fds[nfds].events = POLLIN;
+        fds[nfds].revents = 0;
+        nfds++;
+
+        clock_gettime( CLOCK_MONOTONIC, &now );
+        timeout = ( sim->next.tv_sec - now.tv_sec ) * 1000 + ( sim->next.tv_nsec - now.tv_nsec + 999999 ) / 1000000;
+        if( timeout < 0 )
+            timeout = 0;
+        ret = poll( fds, nfds, timeout );
+        if( ret < 0 && errno != EINTR )
+            break;
+        if( ret > 0 && fds[0].revents )
+            break;
+
+        if( ret > 0 && fds[1].revents )
+        {
+            if( sim->fd < 0 )
+            {
+                sim->fd = accept( sim->listenfd, NULL, NULL );
+                if( sim->fd >= 0 )
+                {
+                    //! Frames are sent at once as sensor does, not held by delayed ACK of client
+                    setsockopt( sim->fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof ( on ) );
+                    fcntl( sim->fd, F_SETFL, O_NONBLOCK );
+                    sim->nin = 0;
+                    S2Sim_Reset( sim );
+                }
+            }
+            else if( !S2Sim_Recv( sim ) && sim->tcp )
+            {
+                close( sim->fd );
+                sim->fd = -1;
+            }
+        }
+
+        //! Scan is done in every period
+        clock_gettime( CLOCK_MONOTONIC, &now );
+        if( now.tv_sec > sim->next.tv_sec || ( now.tv_sec == sim->next.tv_sec && now.tv_nsec >= sim->next.tv_nsec ) )
+        {
+            S2Sim_Scan( sim );
+            S2Sim_Flush( sim );
+            sim->next.tv_nsec += period;
+            sim->next.tv_sec += sim->next.tv_nsec / 1000000000L;
+            sim->next.tv_nsec %= 1000000000L;
+            //! Skip scans missed by long delay
+            if( now.tv_sec > sim->next.tv_sec + 1 )
+                sim->next = now;
+        }
+    }
+    return NULL;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Prepare simulated sensor and start its thread
+ * @param *aSim Pointer to simulated sensor
+ * @param *acpModel Pointer to model ( NULL: default )
+ * @return failed: 0, succeeded: 1
+ */
+/*--------------------------------------------------------------*/
+static int S2Sim_Start( S2Sim_t * aSim, const S2SimModel_t * acpModel )
+{
+    //! Number of steps
+    int nstep;
+
+    if( acpModel )
+        aSim->model = *acpModel;
+    else
+        S2Sim_InitModel( &( aSim->model ) );
+    aSim->rand = aSim->model.seed;
+    aSim->nscan = 0;
+    aSim->nframe = 0;
+    aSim->nnoise = 0;
+    aSim->nglitch = 0;
+    aSim->nin = 0;
+    aSim->nout = 0;
+    S2Sim_Reset( aSim );
+    clock_gettime( CLOCK_MONOTONIC, &( aSim->start ) );
+
+    //! Whole scan of 3 bytes x2 encoding with checksums
+    nstep = aSim->model.param.step_max + 1;
+    aSim->outsize = nstep * 6 / 64 * 66 + 66 + SCIP2_SIM_QUEUE * 2 * SCIP2_MAX_LENGTH;
+    aSim->outsize *= SCIP2_SIM_QUEUE + 1;
+    aSim->data = ( char * )malloc( nstep * 6 );
+    aSim->out = ( char * )malloc( aSim->outsize );
+    if( aSim->data == NULL || aSim->out == NULL || pipe( aSim->wake ) != 0 )
+    {
+        free( aSim->data );
+        free( aSim->out );
+        return 0;
+    }
+    if( pthread_create( &( aSim->thread ), NULL, S2Sim_Loop, ( void * )aSim ) != 0 )
+    {
+        close( aSim->wake[0] );
+        close( aSim->wake[1] );
+        free( aSim->data );
+        free( aSim->out );
+        return 0;
+    }
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Start simulated sensor on pseudo-terminal
+ * @param *aSim Pointer to simulated sensor
+ * @param *acpModel Pointer to model ( NULL: default )
+ * @return failed: 0, succeeded: 1
+ * @attention Device name to pass to Scip2_Open is got by S2Sim_GetName.
+ */
+/*--------------------------------------------------------------*/
+int S2Sim_OpenPty( S2Sim_t * aSim, const S2SimModel_t * acpModel )
+{
+    //! Parameter of terminal io
+    struct termios term;
+
+    aSim->tcp = 0;
+    aSim->port = 0;
+    aSim->listenfd = -1;
+    aSim->slave = -1;
+    aSim->fd = posix_openpt( O_RDWR | O_NOCTTY );
+    if( aSim->fd < 0 )
+        return 0;
+    if( grantpt( aSim->fd ) != 0 || unlockpt( aSim->fd ) != 0
+        || ptsname_r( aSim->fd, aSim->name, sizeof ( aSim->name ) ) != 0 )
+    {
+        close( aSim->fd );
+        return 0;
+    }
+
+    //! Keep slave open and raw, so that the device is not echoed or hung up between clients
+    aSim->slave = open( aSim->name, O_RDWR | O_NOCTTY );
+    if( aSim->slave < 0 || tcgetattr( aSim->slave, &term ) != 0 )
+    {
+        if( aSim->slave >= 0 )
+            close( aSim->slave );
+        close( aSim->fd );
+        return 0;
+    }
+    cfmakeraw( &term );
+    tcsetattr( aSim->slave, TCSANOW, &term );
+    fcntl( aSim->fd, F_SETFL, O_NONBLOCK );
+
+    if( !S2Sim_Start( aSim, acpModel ) )
+    {
+        close( aSim->slave );
+        close( aSim->fd );
+        return 0;
+    }
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Start simulated sensor on loopback TCP port
+ * @param *aSim Pointer to simulated sensor
+ * @param *acpModel Pointer to model ( NULL: default )
+ * @param aPort Number of port ( 0: chosen by system )
+ * @return failed: 0, succeeded: 1
+ * @attention Port to pass to Scip2_OpenEthernet is got by S2Sim_GetPort.
+ *            One client is served at a time, next one is accepted after it closes.
+ */
+/*--------------------------------------------------------------*/
+int S2Sim_OpenTcp( S2Sim_t * aSim, const S2SimModel_t * acpModel, int aPort )
+{
+    //! IP address
+    struct sockaddr_in address;
+    //! Length of address
+    socklen_t len;
+    //! Option value
+    int on = 1;
+
+    aSim->tcp = 1;
+    aSim->fd = -1;
+    aSim->slave = -1;
+    aSim->listenfd = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+    if( aSim->listenfd < 0 )
+        return 0;
+    setsockopt( aSim->listenfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof ( on ) );
+
+    memset( &address, 0, sizeof ( address ) );
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    address.sin_port = htons( ( unsigned short )aPort );
+    len = sizeof ( address );
+    if( bind( aSim->listenfd, ( struct sockaddr * )&address, sizeof ( address ) ) != 0
+        || listen( aSim->listenfd, 1 ) != 0
+        || getsockname( aSim->listenfd, ( struct sockaddr * )&address, &len ) != 0 )
+    {
+        close( aSim->listenfd );
+        return 0;
+    }
+    aSim->port = ntohs( address.sin_port );
+    snprintf( aSim->name, sizeof ( aSim->name ), "127.0.0.1:%d", aSim->port );
+
+    if( !S2Sim_Start( aSim, acpModel ) )
+    {
+        close( aSim->listenfd );
+        return 0;
+    }
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Stop simulated sensor and release it
+ * @param *aSim Pointer to simulated sensor
+ */
+/*--------------------------------------------------------------*/
+void S2Sim_Close( S2Sim_t * aSim )
+{
+    //! Command to stop
+    char cmd = 's';
+
+    if( write( aSim->wake[1], &cmd, 1 ) == 1 )
+        pthread_join( aSim->thread, NULL );
+
+    if( aSim->fd >= 0 )
+        close( aSim->fd );
+    if( aSim->slave >= 0 )
+        close( aSim->slave );
+    if( aSim->listenfd >= 0 )
+        close( aSim->listenfd );
+    close( aSim->wake[0] );
+    close( aSim->wake[1] );
+    free( aSim->data );
+    free( aSim->out );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get name of simulated sensor
+ * @param *aSim Pointer to simulated sensor
+ * @return Device name of pseudo-terminal or "127.0.0.1:port"
+ */
+/*--------------------------------------------------------------*/
+const char *S2Sim_GetName( S2Sim_t * aSim )
+{
+    return aSim->name;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get TCP port of simulated sensor
+ * @param *aSim Pointer to simulated sensor
+ * @return Number of port ( 0: pseudo-terminal )
+ */
+/*--------------------------------------------------------------*/
+int S2Sim_GetPort( S2Sim_t * aSim )
+{
+    return aSim->port;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get number of scans sent by simulated sensor
+ * @param *aSim Pointer to simulated sensor
+ * @return Number of scans replied to GS and continuous scanning
+ */
+/*--------------------------------------------------------------*/
+long S2Sim_GetFrames( S2Sim_t * aSim )
+{
+    return __atomic_load_n( &( aSim->nframe ), __ATOMIC_RELAXED );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get number of data lines broken by injected noise
+ * @param *aSim Pointer to simulated sensor
+ * @return Number of broken lines
+ */
+/*--------------------------------------------------------------*/
+long S2Sim_GetNoise( S2Sim_t * aSim )
+{
+    return __atomic_load_n( &( aSim->nnoise ), __ATOMIC_RELAXED );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get number of frames broken by injected glitch
+ * @param *aSim Pointer to simulated sensor
+ * @return Number of frames with broken echo back
+ */
+/*--------------------------------------------------------------*/
+long S2Sim_GetGlitch( S2Sim_t * aSim )
+{
+    return __atomic_load_n( &( aSim->nglitch ), __ATOMIC_RELAXED );
+}
@@ -0,0 +1,601 @@
+/****************************************************************/
+/**
+  @file   libscip2hat_transport.c
+  @brief  Library for Sokuiki-Sensor "URG"
+  @author HATTORI Kohei <hattori[at]team-lab.com>
+ */
+/****************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "scip2hat.h"
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Read bytes from file descriptor of port
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *apBuf Pointer to Buffer
+ * @param aNBuf Size of Buffer
+ * @return error: -1, closed or timed out: 0, succeeded: number of read bytes
+ */
+/*--------------------------------------------------------------*/
+static ssize_t Scip2_FdRead( S2Port * apPort, char *apBuf, size_t aNBuf )
+{
+    return read( apPort->fd, apBuf, aNBuf );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Write bytes to file descriptor of port
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *apcBuf Pointer to bytes to write
+ * @param aNBuf Number of bytes
+ * @return error: -1, succeeded: number of written bytes
+ */
+/*--------------------------------------------------------------*/
+static ssize_t Scip2_FdWrite( S2Port * apPort, const char *apcBuf, size_t aNBuf )
+{
+    return write( apPort->fd, apcBuf, aNBuf );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Close file descriptor of port
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @return failed: -1, succeeded: 0
+ */
+/*--------------------------------------------------------------*/
+static int Scip2_FdClose( S2Port * apPort )
+{
+    return close( apPort->fd );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Discard bytes recived by serial device
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ */
+/*--------------------------------------------------------------*/
+static void Scip2_SerialFlush( S2Port * apPort )
+{
+    tcflush( apPort->fd, TCIFLUSH );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Discard bytes recived by socket
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ */
+/*--------------------------------------------------------------*/
+static void Scip2_TcpFlush( S2Port * apPort )
+{
+    //! Discarded bytes
+    char buf[256];
+    //! return value of recv
+    ssize_t ret;
+
+    do
+    {
+        ret = recv( apPort->fd, buf, sizeof ( buf ), MSG_DONTWAIT );
+    }
+    while( ret > 0 || ( ret < 0 && errno == EINTR ) );
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Read bytes from in-memory device
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *apBuf Pointer to Buffer
+ * @param aNBuf Size of Buffer
+ * @return end of input: 0, succeeded: number of read bytes
+ * @attention Input is repeated from its head when the device is opened to loop.
+ */
+/*--------------------------------------------------------------*/
+static ssize_t Scip2_MemoryRead( S2Port * apPort, char *apBuf, size_t aNBuf )
+{
+    //! In-memory device
+    S2Memory_t *mem;
+    //! Number of bytes to read
+    size_t n;
+
+    mem = ( S2Memory_t * ) apPort->ctx;
+    if( mem->pos >= mem->nin && mem->loop )
+        mem->pos = 0;
+    n = mem->nin - mem->pos;
+    if( n > aNBuf )
+        n = aNBuf;
+    memcpy( apBuf, mem->in + mem->pos, n );
+    mem->pos += n;
+
+    return n;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Write bytes to in-memory device
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *apcBuf Pointer to bytes to write
+ * @param aNBuf Number of bytes
+ * @return error: -1, succeeded: number of written bytes
+ * @attention Written bytes are kept to be checked by Scip2_GetMemoryOutput.
+ */
+/*--------------------------------------------------------------*/
+static ssize_t Scip2_MemoryWrite( S2Port * apPort, const char *apcBuf, size_t aNBuf )
+{
+    //! In-memory device
+    S2Memory_t *mem;
+    //! Grown output buffer
+    char *out;
+    //! Size of grown output buffer
+    int size;
+
+    mem = ( S2Memory_t * ) apPort->ctx;
+    if( mem->nout + ( int )aNBuf > mem->outsize )
+    {
+        size = mem->outsize * 2 + aNBuf;
+        out = ( char * )realloc( mem->out, size );
+        if( out == NULL )
+        {
+            errno = ENOMEM;
+            return -1;
+        }
+        mem->out = out;
+        mem->outsize = size;
+    }
+    memcpy( mem->out + mem->nout, apcBuf, aNBuf );
+    mem->nout += aNBuf;
+
+    return aNBuf;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Discard bytes recived by in-memory device ( nothing to do )
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ */
+/*--------------------------------------------------------------*/
+static void Scip2_MemoryFlush( S2Port * apPort )
+{
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Release in-memory device
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @return succeeded: 0
+ */
+/*--------------------------------------------------------------*/
+static int Scip2_MemoryClose( S2Port * apPort )
+{
+    //! In-memory device
+    S2Memory_t *mem;
+
+    mem = ( S2Memory_t * ) apPort->ctx;
+    free( mem->in );
+    free( mem->out );
+    free( mem );
+    apPort->ctx = NULL;
+
+    return 0;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Wait until bytes of recorded log are due
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *acpDue Time when the bytes were recived
+ * @return woken up: 0, due: 1
+ */
+/*--------------------------------------------------------------*/
+static int Scip2_ReplayWait( S2Port * apPort, const struct timespec *acpDue )
+{
+    //! Wake up pipe
+    struct pollfd fds;
+    //! Current time
+    struct timespec now;
+    //! Time out of poll [ms]
+    long timeout;
+
+    fds.fd = apPort->wake[0];
+    fds.events = POLLIN;
+    while( 1 )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &now );
+        timeout = ( acpDue->tv_sec - now.tv_sec ) * 1000 + ( acpDue->tv_nsec - now.tv_nsec + 999999 ) / 1000000;
+        if( timeout <= 0 )
+            return 1;
+        if( poll( &fds, 1, timeout ) > 0 )
+            return 0;
+    }
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Read bytes from recorded log
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *apBuf Pointer to Buffer
+ * @param aNBuf Size of Buffer
+ * @return woken up: -1, end of log: 0, succeeded: number of read bytes
+ * @attention Each record is delayed as recorded in real time mode,
+ *            otherwise records are joined as many as the buffer takes.
+ */
+/*--------------------------------------------------------------*/
+static ssize_t Scip2_ReplayRead( S2Port * apPort, char *apBuf, size_t aNBuf )
+{
+    //! Recorded log
+    S2Replay_t *rep;
+    //! Delta time of record [us]
+    uint32_t delta;
+    //! Length of record
+    uint16_t len;
+    //! Number of read bytes
+    size_t n;
+    //! Number of bytes to copy
+    size_t ncopy;
+
+    rep = ( S2Replay_t * ) apPort->ctx;
+    n = 0;
+    while( n < aNBuf )
+    {
+        if( rep->nchunk == 0 )
+        {
+            if( rep->pos + SCIP2_LOG_HEADER > rep->size || ( rep->realtime && n > 0 ) )
+                break;
+            memcpy( &delta, rep->log + rep->pos, sizeof ( delta ) );
+            memcpy( &len, rep->log + rep->pos + sizeof ( delta ), sizeof ( len ) );
+            rep->pos += SCIP2_LOG_HEADER;
+            rep->nchunk = len;
+            if( rep->nchunk > rep->size - rep->pos )
+                rep->nchunk = rep->size - rep->pos;
+            if( rep->realtime )
+            {
+                if( rep->due.tv_sec == 0 && rep->due.tv_nsec == 0 )
+                    clock_gettime( CLOCK_MONOTONIC, &( rep->due ) );
+                rep->due.tv_nsec += ( long )delta * 1000;
+                rep->due.tv_sec += rep->due.tv_nsec / 1000000000L;
+                rep->due.tv_nsec %= 1000000000L;
+            }
+        }
+        if( rep->realtime && n == 0 && !Scip2_ReplayWait( apPort, &( rep->due ) ) )
+        {
+            errno = EAGAIN;
+            return -1;
+        }
+        ncopy = aNBuf - n;
+        if( ncopy > ( size_t )rep->nchunk )
+            ncopy = rep->nchunk;
+        memcpy( apBuf + n, rep->log + rep->pos, ncopy );
+        rep->pos += ncopy;
+        rep->nchunk -= ncopy;
+        n += ncopy;
+        if( rep->realtime )
+            break;
+    }
+
+    return n;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Discard bytes sent to recorded log
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *apcBuf Pointer to bytes to write
+ * @param aNBuf Number of bytes
+ * @return Number of written bytes
+ */
+/*--------------------------------------------------------------*/
+static ssize_t Scip2_ReplayWrite( S2Port * apPort, const char *apcBuf, size_t aNBuf )
+{
+    ( ( S2Replay_t * ) apPort->ctx )->nwrite += aNBuf;
+
+    return aNBuf;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Release recorded log
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @return succeeded: 0
+ */
+/*--------------------------------------------------------------*/
+static int Scip2_ReplayClose( S2Port * apPort )
+{
+    //! Recorded log
+    S2Replay_t *rep;
+
+    rep = ( S2Replay_t * ) apPort->ctx;
+    free( rep->log );
+    free( rep );
+    apPort->ctx = NULL;
+
+    return 0;
+}
+
+
+
+/** Serial device with termios */
+const S2Transport Scip2_SerialTransport = {
+    "serial", Scip2_FdRead, Scip2_FdWrite, Scip2_SerialFlush, Scip2_FdClose
+};
+
+/** TCP socket */
+const S2Transport Scip2_TcpTransport = {
+    "tcp", Scip2_FdRead, Scip2_FdWrite, Scip2_TcpFlush, Scip2_FdClose
+};
+
+/** In-memory buffers */
+const S2Transport Scip2_MemoryTransport = {
+    "memory", Scip2_MemoryRead, Scip2_MemoryWrite, Scip2_MemoryFlush, Scip2_MemoryClose
+};
+
+/** Recorded log */
+const S2Transport Scip2_ReplayTransport = {
+    "replay", Scip2_ReplayRead, Scip2_ReplayWrite, Scip2_MemoryFlush, Scip2_ReplayClose
+};
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Open in-memory device replying recorded bytes
+ * @param acpInput Pointer to bytes recived from the device
+ * @param aNInput Number of bytes
+ * @param aLoop Repeat input from its head after the end ( 0: end of input closes port )
+ * @return failed: NULL, succeeded: Pointer to Device Handle
+ * @attention Input is copied. No command is sent on opening.
+ *            Port is not pollable, so it can not be serviced by event loop.
+ */
+/*--------------------------------------------------------------*/
+S2Port *Scip2_OpenMemory( const char *acpInput, int aNInput, int aLoop )
+{
+    //! Handle to the Device
+    S2Port *port;
+    //! In-memory device
+    S2Memory_t *mem;
+
+    mem = ( S2Memory_t * ) calloc( 1, sizeof ( S2Memory_t ) );
+    if( mem == NULL )
+        return NULL;
+    mem->in = ( char * )malloc( aNInput > 0 ? aNInput : 1 );
+    if( mem->in == NULL )
+    {
+        free( mem );
+        return NULL;
+    }
+    if( aNInput > 0 )
+        memcpy( mem->in, acpInput, aNInput );
+    mem->nin = aNInput > 0 ? aNInput : 0;
+    mem->loop = aLoop;
+
+    port = Scip2_AllocPort( -1, &Scip2_MemoryTransport, mem );
+    if( port == NULL )
+    {
+        free( mem->in );
+        free( mem );
+    }
+
+    return port;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Get bytes sent to in-memory device
+ * @param *apPort Pointer to SCIP2.0 Device Port opened by Scip2_OpenMemory
+ * @param *apLen Number of sent bytes
+ * @return not in-memory device: NULL, succeeded: Pointer to sent bytes ( not null terminated )
+ */
+/*--------------------------------------------------------------*/
+const char *Scip2_GetMemoryOutput( S2Port * apPort, int *apLen )
+{
+    //! In-memory device
+    S2Memory_t *mem;
+
+    if( apPort->transport != &Scip2_MemoryTransport )
+        return NULL;
+    mem = ( S2Memory_t * ) apPort->ctx;
+    *apLen = mem->nout;
+
+    return mem->out;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Open recorded log as device
+ * @param acpPath Pointer to path of log recorded by Scip2_StartRecord
+ * @param aRealtime Replay at original pacing ( 0: as fast as possible )
+ * @return failed: NULL, succeeded: Pointer to Device Handle
+ * @attention Commands sent to the device are discarded, so the same commands
+ *            as recorded session must be sent to consume their replies.
+ *            Port is not pollable, so it can not be serviced by event loop.
+ */
+/*--------------------------------------------------------------*/
+S2Port *Scip2_OpenReplay( const char *acpPath, int aRealtime )
+{
+    //! Handle to the Device
+    S2Port *port;
+    //! Recorded log
+    S2Replay_t *rep;
+    //! Log file
+    FILE *fp;
+    //! Magic bytes
+    char magic[sizeof ( SCIP2_LOG_MAGIC ) - 1];
+
+    fp = fopen( acpPath, "rb" );
+    if( fp == NULL )
+    {
+#ifdef SCIP2_DEBUG
+        fprintf( stderr, "SCIP2 ERROR: Failed to Open '%s'.\n", acpPath );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+        return NULL;
+    }
+    rep = ( S2Replay_t * ) calloc( 1, sizeof ( S2Replay_t ) );
+    if( rep == NULL || fread( magic, sizeof ( magic ), 1, fp ) != 1
+        || memcmp( magic, SCIP2_LOG_MAGIC, sizeof ( magic ) ) != 0 || fseek( fp, 0, SEEK_END ) != 0 )
+    {
+#ifdef SCIP2_DEBUG
+        fprintf( stderr, "SCIP2 ERROR: '%s' is not recorded log.\n", acpPath );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+        free( rep );
+        fclose( fp );
+        return NULL;
+    }
+
+    //! Load whole log not to be delayed by file
+    rep->size = ftell( fp ) - sizeof ( magic );
+    rep->log = ( char * )malloc( rep->size > 0 ? rep->size : 1 );
+    if( rep->size < 0 || rep->log == NULL || fseek( fp, sizeof ( magic ), SEEK_SET ) != 0
+        || ( rep->size > 0 && fread( rep->log, rep->size, 1, fp ) != 1 ) )
+    {
+        free( rep->log );
+        free( rep );
+        fclose( fp );
+        return NULL;
+    }
+    fclose( fp );
+    rep->realtime = aRealtime;
+
+    port = Scip2_AllocPort( -1, &Scip2_ReplayTransport, rep );
+    if( port == NULL )
+    {
+        free( rep->log );
+        free( rep );
+    }
+
+    return port;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Start recording bytes recived by the port
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param acpPath Pointer to path of log
+ * @return failed: 0, succeeded: 1
+ * @attention Must not be called while data is recived in another thread.
+ *            Recording started before Scip2CMD_StartMS can be replayed by Scip2_OpenReplay.
+ */
+/*--------------------------------------------------------------*/
+int Scip2_StartRecord( S2Port * apPort, const char *acpPath )
+{
+    //! Log file
+    FILE *fp;
+
+    fp = fopen( acpPath, "wb" );
+    if( fp == NULL )
+    {
+#ifdef SCIP2_DEBUG
+        fprintf( stderr, "SCIP2 ERROR: Failed to Open '%s'.\n", acpPath );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+        return 0;
+    }
+    if( fwrite( SCIP2_LOG_MAGIC, sizeof ( SCIP2_LOG_MAGIC ) - 1, 1, fp ) != 1 )
+    {
+        fclose( fp );
+        return 0;
+    }
+    Scip2_StopRecord( apPort );
+    clock_gettime( CLOCK_MONOTONIC, &( apPort->recorded ) );
+    apPort->record = fp;
+
+    return 1;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Stop recording bytes recived by the port
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @attention Must not be called while data is recived in another thread.
+ */
+/*--------------------------------------------------------------*/
+void Scip2_StopRecord( S2Port * apPort )
+{
+    if( apPort->record == NULL )
+        return;
+    fclose( apPort->record );
+    apPort->record = NULL;
+}
+
+
+
+/*--------------------------------------------------------------*/
+/**
+ * @brief Append bytes just recived to log
+ * @param *apPort Pointer to SCIP2.0 Device Port
+ * @param *acpBuf Pointer to recived bytes
+ * @param aLen Number of bytes ( up to SCIP2_RECV_BUFSIZE )
+ */
+/*--------------------------------------------------------------*/
+void Scip2_Record( S2Port * apPort, const char *acpBuf, int aLen )
+{
+    //! Current time
+    struct timespec now;
+    //! Delta time from last record [us]
+    uint32_t delta;
+    //! Length of record
+    uint16_t len;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    delta = ( now.tv_sec - apPort->recorded.tv_sec ) * 1000000 + ( now.tv_nsec - apPort->recorded.tv_nsec ) / 1000;
+    //! Keep remainder to not accumulate rounding error
+    apPort->recorded.tv_nsec += ( long )delta * 1000;
+    apPort->recorded.tv_sec += apPort->recorded.tv_nsec / 1000000000L;
+    apPort->recorded.tv_nsec %= 1000000000L;
+    len = aLen;
+
+    if( fwrite( &delta, sizeof ( delta ), 1, apPort->record ) != 1
+        || fwrite( &len, sizeof ( len ), 1, apPort->record ) != 1
+        || fwrite( acpBuf, aLen, 1, apPort->record ) != 1 )
+    {
+#ifdef SCIP2_DEBUG
+        fprintf( stderr, "SCIP2 ERROR: Failed to record.\n" );
+        fflush( stderr );
+#endif											/* SCIP2_DEBUG */
+        Scip2_StopRecord( apPort );
+    }
+}